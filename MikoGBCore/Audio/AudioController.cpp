@@ -44,8 +44,8 @@ static const uint16_t AudioRegisterBase = NR10Register;
 // we emit a sample when it hits <= 0 and reset to += (1 << 22) to account for fracional drift
 // Instead of the actual clock speed (1<22) as the counter base, use the GPU speed, which is
 // 456 cycles per scanline, 154 scanlines per frame, 60 frames per second
-// Finally, cycles are doubled. In normal-speed mode, input will also be doubled so that the 2x cancels out
-// in double-speed mode, input will not be doubled, so samples will be emitted in half the actual CPU cycles
+// Finally, cycles are doubled. Input is in master cycles, which are 2x CPU cycles in normal-speed mode so the 2x cancels out
+// in double-speed mode, master cycles are CPU cycles, so samples will be emitted in half the actual CPU cycles
 // which counteracts the fact that if things are running in "real" time, the CPU should be cycling 2x as fast
 static const int SampleCounterBase = 456 * 154 * 60 * 2;
 static const int SamplesPerSecond = 44100;
@@ -55,53 +55,40 @@ AudioController::AudioController(): _sound1(true), _sound2(false) {
     _nextSampleCounter = SampleCounterBase;
 }
 
-void AudioController::updateWithCPUCycles(int cycles) {
-    _sound1.updateWithCycles(cycles);
-    _sound2.updateWithCycles(cycles);
-    _sound3.updateWithCycles(cycles);
-    _sound4.updateWithCycles(cycles);
+void AudioController::reset() {
+    AudioSampleCallback callback = std::move(_sampleCallback);
+    *this = AudioController();
+    _sampleCallback = std::move(callback);
+}
 
-    // this isn't technically correct if the input cycles is large (~190 or more)
-    // but the input cycles should only be the duration of a cpu instruction so up to ~10
-    // if there can be multiple samples per update we'd need to do something more complicated
-    _nextSampleCounter -= (cycles * SamplesPerSecond);
-    while (_nextSampleCounter <= 0) {
+void AudioController::updateWithMasterCycles(int cycles) {
+    // Updates are batched until something else needs to happen, so they can span several samples. Update the sounds up
+    // to the point of each sample before emitting it
+    int remaining = cycles;
+    while (remaining > 0) {
+        // cycles until the counter reaches 0, rounded up
+        const int cyclesUntilSample = (_nextSampleCounter + SamplesPerSecond - 1) / SamplesPerSecond;
+        if (cyclesUntilSample > remaining) {
+            _updateSounds(remaining);
+            _nextSampleCounter -= (remaining * SamplesPerSecond);
+            break;
+        }
+        
+        _updateSounds(cyclesUntilSample);
+        _nextSampleCounter -= (cyclesUntilSample * SamplesPerSecond);
         _nextSampleCounter += SampleCounterBase;
+        remaining -= cyclesUntilSample;
         // emit a sample!
         _emitSample();
     }
 }
 
-// Alternative version of the updater that updates per sample and not excessively
-//void AudioController::updateWithCPUCycles(int cycles) {
-//    int cyclesUpdated = 0;
-//    int audioCycles = (cycles * SamplesPerSecond);
-//    while (audioCycles > 0) {
-//        if (audioCycles >= _nextSampleCounter) {
-//            // if we'll hit a cycle, run until then
-//            int cpuCycles = _nextSampleCounter / SamplesPerSecond;
-//            audioCycles -= _nextSampleCounter;
-//            _nextSampleCounter = SampleCounterBase;
-//
-//            // update until the sample will be emitted and then emit
-//            _sound1.updateWithCycles(cpuCycles);
-//            _sound2.updateWithCycles(cpuCycles);
-//            _sound3.updateWithCycles(cpuCycles);
-//            _sound4.updateWithCycles(cpuCycles);
-//            cyclesUpdated += cpuCycles;
-//
-//            _emitSample();
-//        } else {
-//            int remainingCPUCycles = cycles - cyclesUpdated;
-//            _nextSampleCounter -= audioCycles;
-//            audioCycles = 0;
-//            _sound1.updateWithCycles(remainingCPUCycles);
-//            _sound2.updateWithCycles(remainingCPUCycles);
-//            _sound3.updateWithCycles(remainingCPUCycles);
-//            _sound4.updateWithCycles(remainingCPUCycles);
-//        }
-//    }
-//}
+void AudioController::_updateSounds(int cycles) {
+    _sound1.updateWithCycles(cycles);
+    _sound2.updateWithCycles(cycles);
+    _sound3.updateWithCycles(cycles);
+    _sound4.updateWithCycles(cycles);
+}
 
 // get left/right channel volumes as double from 0.0 - 1.0
 static void ChannelVolumes(uint8_t val, double &leftChannel, double &rightChannel) {
@@ -25,17 +25,21 @@ public:
     
     uint8_t readAudioRegister(uint16_t addr) const;
     
-    // CPU cycles are 4x instruction cycles. 4.2MHz (2^22)
-    void updateWithCPUCycles(int cycles);
+    // Master cycles are 2x CPU cycles at normal speed. 8.4MHz (2^23), see EventScheduler
+    // Updates may span any number of samples
+    void updateWithMasterCycles(int cycles);
     
     void setSampleCallback(AudioSampleCallback callback) {
         _sampleCallback = callback;
     }
     
+    /// Return every register and sound to power-on state. The sample callback is kept
+    void reset();
+    
 private:
     // Audio registers range from 0xFF10 - 0xFF3F so there are 0x30 of them (48)
     // Some are unused
-    std::array<uint8_t, 0x30> _audioRegisters;
+    std::array<uint8_t, 0x30> _audioRegisters = {};
     
     bool _soundOn = false;
     double _leftVolume = 0.0;
@@ -46,6 +50,7 @@ private:
     NoiseSound _sound4;
     
     int _nextSampleCounter = 0;
+    void _updateSounds(int cycles);
     void _emitSample();
     
     AudioSampleCallback _sampleCallback;
@@ -31,7 +31,7 @@ public:
     
 private:
     bool _isRunning = false;
-    const bool _hasSweep;
+    bool _hasSweep;
     
     // sweep
     int _sweepTime = 0; // CPU cycles per sweep event. 0 means sweep disabled
@@ -15,21 +15,20 @@
 using namespace std;
 using namespace MikoGB;
 
-CPUCore::CPUCore(MemoryController::Ptr &memCon): memoryController(memCon), _previousInstructions(5000) {
+CPUCore::CPUCore(MemoryController *memCon): memoryController(memCon), _previousInstructions(5000) {
     reset();
-    CPUInstruction::InitializeInstructionTable();
 }
 
 #if BUILD_FOR_TESTING
 static const size_t MainMemorySize = 1024 * 64; // 64 KiB
 static shared_ptr<MemoryController> testMemoryController = make_shared<MemoryController>();
-CPUCore::CPUCore(uint8_t *memory, size_t len): memoryController(testMemoryController) {
+CPUCore::CPUCore(uint8_t *memory, size_t len): memoryController(testMemoryController.get()), _previousInstructions(5000) {
     mainMemory = new uint8_t[MainMemorySize]();
     if (memory) {
         memcpy(mainMemory, memory, std::min(len, MainMemorySize));
     }
     reset();
-    CPUInstruction::InitializeInstructionTable();
+    setJITEnabled(ENABLE_JIT_FOR_TESTING);
 }
 
 CPUCore::~CPUCore() {
@@ -39,24 +38,61 @@ CPUCore::~CPUCore() {
 int CPUCore::step() {
     uint8_t *basePtr = mainMemory + programCounter;
     const CPUInstruction &instruction = CPUInstruction::LookupInstruction(basePtr);
+    const NativeBlock *nativeBlock = _jitEnabled ? _testNativeInstruction(instruction) : nullptr;
+    if (nativeBlock) {
+        // A budget of 1 cycle still runs one instruction, as the tests expect from a step
+        const InstructionJIT::RunResult result = InstructionJIT::Run(*nativeBlock, *this, 1);
+        if (result.instructionCount > 0) {
+            return result.cycles;
+        }
+    }
     programCounter += instruction.size;
     return instruction.func(basePtr, *this);
 }
 
+const NativeBlock *CPUCore::_testNativeInstruction(const CPUInstruction &instruction) {
+    DecodedInstruction decoded;
+    decoded.func = instruction.func;
+    decoded.size = instruction.size;
+    for (size_t i = 0; i < sizeof(decoded.bytes); ++i) {
+        decoded.bytes[i] = mainMemory[(uint16_t)(programCounter + i)];
+    }
+    auto existing = _testNativeInstructions.find(programCounter);
+    if (existing != _testNativeInstructions.end() && memcmp(existing->second.bytes, decoded.bytes, decoded.size) == 0) {
+        return existing->second.nativeBlock;
+    }
+    
+    TestNativeInstruction compiled;
+    memcpy(compiled.bytes, decoded.bytes, sizeof(compiled.bytes));
+    compiled.nativeBlock = _jit.compile(*this, &decoded, 1, 0, programCounter);
+    _testNativeInstructions[programCounter] = compiled;
+    return compiled.nativeBlock;
+}
+
 #else
 
+// Instruction cycles per step while halted. Could be 1 but there's no reason to step more finely than an instruction
+static const uint64_t HaltedStepCycles = 4;
+// Limit on a single halted step if nothing is scheduled. One frame of CPU cycles at normal speed
+static const uint64_t MaxHaltedCPUCycles = 456 * 154;
+
 int CPUCore::step() {
     if (handleInterruptsIfNeeded()) {
         // There has been an interrupt. The handler puts the CPU into a state so that the next step will
         // start the interrupt processing routine
         // Per Pandocs and Z80 sheet, this should take about 5 cycles
+        _idleLoopDetector.interrupted();
         return 5;
     }
     
     if (_isHalted) {
-        // Could return 1 but don't necessarily want to loop too tightly
-        // Might turn a "low power" mode into a "high power" busy loop
-        return 4;
+        // Only another component's event can request an interrupt while halted (input arrives between steps), so skip
+        // straight to the next one instead of stepping through the wait. Skip whole halted steps so that the CPU wakes
+        // up on the same cycle as it would stepping one at a time
+        const uint64_t cpuCycles = min(memoryController->scheduler.cpuCyclesUntilNextEvent(), MaxHaltedCPUCycles);
+        const uint64_t haltedStepCPUCycles = HaltedStepCycles * 4;
+        const uint64_t haltedSteps = max<uint64_t>(1, (cpuCycles + haltedStepCPUCycles - 1) / haltedStepCPUCycles);
+        return (int)(haltedSteps * HaltedStepCycles);
     }
     
     const uint16_t originalPC = programCounter;
@@ -73,16 +109,42 @@ int CPUCore::step() {
         }
     }
 #endif
-    const CPUInstruction &instruction = CPUInstruction::LookupInstruction(memoryController, programCounter);
-    programCounter += instruction.size;
-    uint8_t basePtr[3]; // max instruction size
-    for (int i = 0; i < instruction.size; ++i) {
-        basePtr[i] = memoryController->readByte(originalPC + i);
+    int steps = 0;
+    uint16_t instructionSize = 0;
+    uint16_t instructionPC = originalPC; // start of the last instruction run, for idle loop detection
+    const DecodedInstruction *decoded = _instructionCacheEnabled ? _blockCache.lookup(memoryController, originalPC) : nullptr;
+    if (decoded && _jitEnabled && _runNativeBlock(steps, instructionPC, instructionSize)) {
+        // Ran one or more instructions as native code
+    } else if (decoded) {
+        // Already fetched and decoded from ROM
+        instructionSize = decoded->size;
+        programCounter += instructionSize;
+        steps = decoded->func(decoded->bytes, *this);
+    } else {
+        // Read the opcode (and extended opcode if needed) once, then only the remaining operand bytes after lookup
+        uint8_t basePtr[3]; // max instruction size
+        basePtr[0] = memoryController->readByte(originalPC);
+        int bytesRead = 1;
+        if (basePtr[0] == 0xCB) {
+            basePtr[1] = memoryController->readByte(originalPC + 1);
+            bytesRead = 2;
+        }
+        const CPUInstruction &instruction = CPUInstruction::LookupInstruction(basePtr);
+        instructionSize = instruction.size;
+        programCounter += instructionSize;
+        for (int i = bytesRead; i < instructionSize; ++i) {
+            basePtr[i] = memoryController->readByte(originalPC + i);
+        }
+        steps = instruction.func(basePtr, *this);
+    }
+    if (_idleLoopSkippingEnabled && programCounter <= instructionPC) {
+        // Jumped backwards, possibly to the start of a loop that is waiting for another component
+        const uint64_t arrivalCPUCycles = memoryController->scheduler.cpuCycles() + steps * 4;
+        steps += (int)(_idleLoopDetector.loopDidJumpBack(*this, instructionPC, instructionSize, arrivalCPUCycles) / 4);
     }
-    int steps = instruction.func(basePtr, *this);
 #if ENABLE_DEBUGGER
     if (originalPC < 0x8000) {
-        KnownInstruction i = { originalROMBank, originalPC, instruction.size };
+        KnownInstruction i = { originalROMBank, originalPC, instructionSize };
         _previousInstructions.append(i);
     }
 #endif
@@ -96,6 +158,51 @@ int CPUCore::step() {
     return steps;
 }
 
+// Entries into a block before it's compiled. Code that only runs a few times, e.g. during startup, isn't worth it
+static const size_t JITHotBlockEntryCount = 16;
+// Limit on a single native run if nothing is scheduled, same as a halted step
+static const uint64_t MaxNativeCPUCycles = MaxHaltedCPUCycles;
+
+bool CPUCore::_runNativeBlock(int &steps, uint16_t &instructionPC, uint16_t &instructionSize) {
+    InstructionBlockCache::Block *block = _blockCache.currentBlock();
+    if (!block) {
+        return false;
+    }
+    if (!block->nativeBlock) {
+        if (block->isNativeUnsupported || block->entryCount < JITHotBlockEntryCount) {
+            return false;
+        }
+        block->nativeBlock = _jit.compile(*this, block->instructions.data(), block->instructions.size(), block->romBank, block->addr);
+        block->isNativeUnsupported = block->nativeBlock == nullptr;
+        if (!block->nativeBlock) {
+            return false;
+        }
+    }
+    // Native code may also be resumed partway through, e.g. after the previous run used up its cycle budget
+    const size_t startIndex = _blockCache.currentIndex();
+    if (startIndex >= block->nativeBlock->instructionCount) {
+        return false;
+    }
+    
+    // Stepping would run the next event once the elapsed CPU cycles reach cpuCyclesUntilNextEvent(), so only start
+    // instructions before then
+    const uint64_t cpuCycles = min(memoryController->scheduler.cpuCyclesUntilNextEvent(), MaxNativeCPUCycles);
+    const InstructionJIT::RunResult result = InstructionJIT::Run(*block->nativeBlock, *this, (uint32_t)((cpuCycles + 3) / 4), startIndex);
+    if (result.instructionCount == 0) {
+        // The first instruction needs the interpreter
+        return false;
+    }
+    _blockCache.skipInstructions(result.instructionCount, programCounter);
+    
+    steps = result.cycles;
+    const size_t lastIndex = startIndex + result.instructionCount - 1;
+    for (size_t i = startIndex; i < lastIndex; ++i) {
+        instructionPC += block->instructions[i].size;
+    }
+    instructionSize = block->instructions[lastIndex].size;
+    return true;
+}
+
 #endif
 
 void CPUCore::reset() {
@@ -104,9 +211,91 @@ void CPUCore::reset() {
     }
     programCounter = 0;
     stackPointer = 0;
+    interruptState = InterruptState::Disabled;
+#if ENABLE_LAZY_FLAGS
+    _lazyFlags.op = LazyFlagsOp::None;
+#endif
     _isHalted = false;
     _stoppedAtBreakpoint = false;
+    // Time starts over, so the last loop iteration seen can't be compared with the next
+    _idleLoopDetector.interrupted();
+}
+
+void CPUCore::invalidateROMCaches() {
+    _blockCache.invalidate();
+    _jit.invalidate();
+#if BUILD_FOR_TESTING
+    _testNativeInstructions.clear();
+#endif
+    _idleLoopDetector.invalidate();
+    _previousInstructions.clear();
+}
+
+#if ENABLE_LAZY_FLAGS
+uint8_t CPUCore::_computeLazyFlags() const {
+    const int a = _lazyFlags.a;
+    const int b = _lazyFlags.b;
+    const int carryIn = _lazyFlags.carry ? 1 : 0;
+    bool zero = false, n = false, halfCarry = false, carry = false;
+    switch (_lazyFlags.op) {
+        case LazyFlagsOp::None:
+            return registers[REGISTER_F];
+        case LazyFlagsOp::Add: {
+            const int sum = a + b + carryIn;
+            const int carriedBits = a ^ b ^ sum;
+            zero = (sum & 0xFF) == 0;
+            halfCarry = (carriedBits & 0x10) == 0x10;
+            carry = (carriedBits & 0x100) == 0x100;
+            break;
+        }
+        case LazyFlagsOp::Sub: {
+            const int difference = a - b - carryIn;
+            const int borrowedBits = a ^ b ^ difference;
+            zero = (difference & 0xFF) == 0;
+            n = true;
+            halfCarry = (borrowedBits & 0x10) == 0x10;
+            carry = (borrowedBits & 0x100) == 0x100;
+            break;
+        }
+        case LazyFlagsOp::And:
+            zero = (a & b) == 0;
+            halfCarry = true;
+            break;
+        case LazyFlagsOp::Logic:
+            // a holds the result for OR and XOR
+            zero = a == 0;
+            break;
+        case LazyFlagsOp::Cp:
+            zero = a == b;
+            n = true;
+            halfCarry = a > b;
+            carry = a < b;
+            break;
+        case LazyFlagsOp::Inc: {
+            const uint8_t sum = a + 1;
+            zero = sum == 0;
+            halfCarry = ((a ^ sum) & 0x10) == 0x10;
+            carry = _lazyFlags.carry;
+            break;
+        }
+        case LazyFlagsOp::Dec: {
+            const uint8_t diff = a - 1;
+            zero = diff == 0;
+            n = true;
+            halfCarry = ((a ^ diff) & 0x10) == 0x10;
+            carry = _lazyFlags.carry;
+            break;
+        }
+    }
+    
+    uint8_t flags = 0;
+    flags |= zero ? FlagBit::Zero : 0;
+    flags |= n ? FlagBit::N : 0;
+    flags |= halfCarry ? FlagBit::H : 0;
+    flags |= carry ? FlagBit::Carry : 0;
+    return flags;
 }
+#endif
 
 bool CPUCore::handleInterruptsIfNeeded() {
     bool wasNotEnabled = interruptState != InterruptState::Enabled;
@@ -181,3 +370,39 @@ void CPUCore::stop() {
     }
 }
 
+
+#if BUILD_FOR_TESTING
+/// Test memory is flat, but still never bulk-write ROM or I/O registers
+static size_t _TestBulkCount(uint16_t addr, size_t count, bool forWrite) {
+    const uint32_t regionBegin = forWrite ? 0x8000 : 0x0000;
+    if (addr >= regionBegin && addr < 0xFF00) {
+        return std::min<size_t>(count, 0xFF00 - addr);
+    } else if (addr >= 0xFF80 && addr < 0xFFFF) {
+        return std::min<size_t>(count, 0xFFFF - addr);
+    }
+    return 0;
+}
+#endif
+
+size_t CPUCore::bulkCopyMemory(uint16_t dst, uint16_t src, size_t maxCount) {
+#if BUILD_FOR_TESTING
+    size_t count = _TestBulkCount(src, _TestBulkCount(dst, maxCount, true), false);
+    if (dst > src && dst < src + count) {
+        count = dst - src;
+    }
+    memmove(mainMemory + dst, mainMemory + src, count);
+    return count;
+#else
+    return memoryController->bulkCopy(dst, src, maxCount);
+#endif
+}
+
+size_t CPUCore::bulkFillMemory(uint16_t dst, uint8_t val, size_t maxCount) {
+#if BUILD_FOR_TESTING
+    const size_t count = _TestBulkCount(dst, maxCount, true);
+    memset(mainMemory + dst, val, count);
+    return count;
+#else
+    return memoryController->bulkFill(dst, val, maxCount);
+#endif
+}
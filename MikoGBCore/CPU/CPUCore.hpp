@@ -27,10 +27,16 @@
 #include "BitTwiddlingUtil.h"
 #include "MemoryController.hpp"
 #include "InstructionRingBuffer.hpp"
+#include "InstructionBlockCache.hpp"
+#include "InstructionJIT.hpp"
+#include "IdleLoopDetector.hpp"
 #include "Breakpoint.hpp"
+#include "GameBoyCoreTypes.h"
 
 namespace MikoGB {
 
+struct CPUInstruction;
+
 enum FlagBit : uint8_t {
     Zero        = 1 << 7,
     N           = 1 << 6,
@@ -40,7 +46,7 @@ enum FlagBit : uint8_t {
 
 class CPUCore {
 public:
-    CPUCore(MemoryController::Ptr &memoryController);
+    CPUCore(MemoryController *memoryController);
 #if BUILD_FOR_TESTING
     CPUCore(uint8_t *memory, size_t len);
     ~CPUCore();
@@ -50,16 +56,37 @@ public:
     /// Step one instruction. Returns elapsed cycle count
     int step();
     
-    /// Reset the CPU state to initial
+    /// Reset the CPU state to initial. Decoded ROM blocks are kept, see invalidateROMCaches()
     void reset();
     
+    /// Drop everything decoded from or recorded about the ROM, for when different ROM data is loaded
+    void invalidateROMCaches();
+    
+    /// When enabled (default), code in ROM is decoded once into cached blocks and executed from there. When disabled,
+    /// every instruction is fetched and decoded as it executes
+    void setInstructionCacheEnabled(bool enabled) { _instructionCacheEnabled = enabled; }
+    bool isInstructionCacheEnabled() const { return _instructionCacheEnabled; }
+    const InstructionBlockCache &getInstructionCache() const { return _blockCache; }
+    
+    /// When enabled, hot blocks of the instruction cache are compiled to native code and run from there. Needs the
+    /// instruction cache, and does nothing where the JIT isn't supported (see ENABLE_JIT). Disabled by default
+    void setJITEnabled(bool enabled) { _jitEnabled = enabled && InstructionJIT::IsSupported(); }
+    bool isJITEnabled() const { return _jitEnabled; }
+    size_t getCompiledBlockCount() const { return _jit.compiledBlockCount(); }
+    
+    /// When enabled, loops that only wait for another component (e.g. polling LY) are fast-forwarded to the iteration
+    /// before the next scheduled event instead of being executed. Disabled by default. See IdleLoopDetector
+    void setIdleLoopSkippingEnabled(bool enabled) { _idleLoopSkippingEnabled = enabled; }
+    bool isIdleLoopSkippingEnabled() const { return _idleLoopSkippingEnabled; }
+    const IdleLoopCounters &getIdleLoopCounters() const { return _idleLoopDetector.counters(); }
+    
     // State
     
     uint8_t registers[REGISTER_COUNT];
     uint16_t programCounter;
     uint16_t stackPointer;
     
-    MemoryController::Ptr &memoryController;
+    MemoryController *const memoryController;
 #if BUILD_FOR_TESTING
     uint8_t *mainMemory;
 #endif
@@ -67,6 +94,11 @@ public:
     
     uint8_t getMemory(uint16_t address) const;
     
+    /// Bulk versions of setMemory for accelerated loops. See MemoryController::bulkCopy() and bulkFill()
+    /// Returns the number of bytes written, which may be fewer than requested (or 0)
+    size_t bulkCopyMemory(uint16_t dst, uint16_t src, size_t maxCount);
+    size_t bulkFillMemory(uint16_t dst, uint8_t val, size_t maxCount);
+    
     uint16_t getHLptr() const;
     
     void incrementHLptr();
@@ -101,6 +133,27 @@ public:
     bool getFlag(FlagBit) const;
     void setFlag(FlagBit, bool);
     
+    /// The full F register, including any pending lazy flags. Use these rather than accessing registers[REGISTER_F]
+    uint8_t getFlagsRegister() const;
+    void setFlagsRegister(uint8_t);
+    
+#if ENABLE_LAZY_FLAGS
+    enum class LazyFlagsOp : uint8_t {
+        None,   // registers[REGISTER_F] is up to date
+        Add,    // ADD, ADC. carry is the carry in
+        Sub,    // SUB, SBC. carry is the carry in
+        And,
+        Logic,  // OR, XOR
+        Cp,
+        Inc,    // carry is the untouched carry flag
+        Dec,    // carry is the untouched carry flag
+    };
+    
+    /// Record the operands of an 8-bit ALU operation instead of computing its flags. They're computed from the
+    /// operands only if read before the next flag-setting operation
+    void setLazyFlags(LazyFlagsOp op, uint8_t a, uint8_t b, bool carry);
+#endif
+    
     // Interrupts
     enum InterruptState {
         Disabled,
@@ -109,6 +162,9 @@ public:
     };
     InterruptState interruptState;
     
+    /// Instrumentation for fused instruction idioms. See FusedInstructions.hpp
+    InstructionFusionCounters fusionCounters;
+    
     InstructionRingBuffer _previousInstructions;
     BreakpointManager _breakpointManager;
     bool isStoppedAtBreakpoint() const { return _stoppedAtBreakpoint; }
@@ -117,6 +173,39 @@ private:
     bool handleInterruptsIfNeeded();
     bool _isHalted;
     bool _stoppedAtBreakpoint;
+    
+#if ENABLE_LAZY_FLAGS
+    struct LazyFlags {
+        LazyFlagsOp op = LazyFlagsOp::None;
+        uint8_t a = 0;
+        uint8_t b = 0;
+        bool carry = false;
+    };
+    LazyFlags _lazyFlags;
+    uint8_t _computeLazyFlags() const;
+    void _materializeFlags();
+#endif
+    
+    /// Decoded instructions for code running from ROM. Blocks are reused across resets since ROM doesn't change
+    InstructionBlockCache _blockCache;
+    bool _instructionCacheEnabled = true;
+    
+    InstructionJIT _jit;
+    bool _jitEnabled = false;
+#if BUILD_FOR_TESTING
+    /// Test memory isn't ROM, so each instruction is compiled on its own and recompiled if its bytes change
+    struct TestNativeInstruction {
+        uint8_t bytes[8];
+        const NativeBlock *nativeBlock;
+    };
+    std::unordered_map<uint16_t, TestNativeInstruction> _testNativeInstructions;
+    const NativeBlock *_testNativeInstruction(const CPUInstruction &instruction);
+#else
+    bool _runNativeBlock(int &steps, uint16_t &instructionPC, uint16_t &instructionSize);
+#endif
+    
+    IdleLoopDetector _idleLoopDetector;
+    bool _idleLoopSkippingEnabled = false;
 };
 
 
@@ -179,11 +268,47 @@ inline void CPUCore::stackPop(uint8_t &hi, uint8_t &lo) {
     hi = getMemory(stackPointer++);
 }
 
+inline uint8_t CPUCore::getFlagsRegister() const {
+#if ENABLE_LAZY_FLAGS
+    if (_lazyFlags.op != LazyFlagsOp::None) {
+        return _computeLazyFlags();
+    }
+#endif
+    return registers[REGISTER_F];
+}
+
+inline void CPUCore::setFlagsRegister(uint8_t val) {
+#if ENABLE_LAZY_FLAGS
+    _lazyFlags.op = LazyFlagsOp::None;
+#endif
+    registers[REGISTER_F] = val;
+}
+
+#if ENABLE_LAZY_FLAGS
+inline void CPUCore::setLazyFlags(LazyFlagsOp op, uint8_t a, uint8_t b, bool carry) {
+    _lazyFlags.op = op;
+    _lazyFlags.a = a;
+    _lazyFlags.b = b;
+    _lazyFlags.carry = carry;
+}
+
+inline void CPUCore::_materializeFlags() {
+    if (_lazyFlags.op != LazyFlagsOp::None) {
+        registers[REGISTER_F] = _computeLazyFlags();
+        _lazyFlags.op = LazyFlagsOp::None;
+    }
+}
+#endif
+
 inline bool CPUCore::getFlag(FlagBit bit) const {
-    return (registers[REGISTER_F] & bit) == bit;
+    return (getFlagsRegister() & bit) == bit;
 }
 
 inline void CPUCore::setFlag(FlagBit bit, bool isSet) {
+#if ENABLE_LAZY_FLAGS
+    // Other flags may still be pending from the last ALU operation
+    _materializeFlags();
+#endif
     if (isSet) {
         // & with 0xF0 to disallow setting of low 4 bits
         registers[REGISTER_F] |= (bit & 0xF0);
@@ -22,6 +22,7 @@
 #include "JumpInstructions.hpp"
 #include "RotateShiftInstructions.hpp"
 #include "SpecialInstructions.hpp"
+#include "FusedInstructions.hpp"
 
 using namespace std;
 using namespace MikoGB;
@@ -45,51 +46,29 @@ int CPUInstruction::UnrecognizedInstruction(const uint8_t *opcode, CPUCore &core
     }
 }
 
-#if BUILD_FOR_TESTING
-const CPUInstruction &CPUInstruction::LookupInstruction(uint8_t *memoryPtr) {
-    size_t idx = memoryPtr[0];
-    if (idx == 0xCB) {
-        //Z80 Extended instruction set
-        //Index in the table is 0x1SS where SS is the extended opcode
-        idx = memoryPtr[1] | 0x100;
-    }
-    
-    return InstructionTable[idx];
-}
-
-#else
-
-const CPUInstruction &CPUInstruction::LookupInstruction(const MemoryController::Ptr &mem, uint16_t pc) {
-    size_t idx = mem->readByte(pc);
-    if (idx == 0xCB) {
-        //Z80 Extended instruction set
-        //Index in the table is 0x1SS where SS is the extended opcode
-        idx = mem->readByte(pc+1) | 0x100;
-    }
-    
-    return InstructionTable[idx];
-}
-#endif /* BUILD_FOR_TESTING */
-
 #pragma mark - Instruction Definitions
 
 static int NoOp(const uint8_t *opcode, CPUCore &core) {
     return 1;
 }
 
-CPUInstruction *CPUInstruction::InstructionTable = nullptr;
-void CPUInstruction::InitializeInstructionTable() {
-    if (CPUInstruction::InstructionTable != nullptr) {
-        return; //already initialized
-    }
-    
-    // Technically, there can be 511 instructions but only 500 are used
-    // 255 possible with a single byte. 256 possible with the extender 0xCB and the second byte
-    // Single-byte instructions are indexed by their value
-    // Two-byte instructions must have 0xCB as the first byte and are indexed by 0x1NN
-    // So all feasible indices are 0x00 - 0x1FF (0-511), but there are gaps
-    // Default initialized so that gaps are automatically UnrecognizedInstruction
-    InstructionTable = new CPUInstruction[512]();
+// Technically, there can be 511 instructions but only 500 are used
+// 255 possible with a single byte. 256 possible with the extender 0xCB and the second byte
+// Single-byte instructions are indexed by their value
+// Two-byte instructions must have 0xCB as the first byte and are indexed by 0x1NN
+// So all feasible indices are 0x00 - 0x1FF (0-511), but there are gaps
+static const size_t InstructionTableSize = 512;
+
+// Wrapper so that the table can be built and returned by value from a constexpr function
+struct InstructionTableStorage {
+    CPUInstruction entries[InstructionTableSize];
+};
+
+// Evaluated at compile time so there is no runtime initialization and the table lives in read-only data
+// Default initialized so that gaps are automatically UnrecognizedInstruction
+static constexpr InstructionTableStorage _BuildInstructionTable() {
+    InstructionTableStorage table = {};
+    CPUInstruction *InstructionTable = table.entries;
     
     InstructionTable[0x00] = { 1, NoOp };
     
@@ -713,5 +692,87 @@ void CPUInstruction::InitializeInstructionTable() {
     InstructionTable[0x135] = { 2, swapRegister }; // SWAP L
     InstructionTable[0x136] = { 2, swapPtrHL }; // SWAP (HL)
     InstructionTable[0x137] = { 2, swapRegister }; // SWAP A
+    
+    return table;
+}
+
+static constexpr InstructionTableStorage _InstructionTable = _BuildInstructionTable();
+const CPUInstruction * const CPUInstruction::InstructionTable = _InstructionTable.entries;
+
+#pragma mark - Fused Instructions
+
+static bool _IsDecRegister(uint8_t opcode) {
+    // DEC r is 00rrr101, excluding DEC (HL) at 0x35
+    return (opcode & 0xC7) == 0x05 && opcode != 0x35;
+}
+
+static bool _MatchesCopyByte(const uint8_t *opcode) {
+    return opcode[0] == 0x2A && opcode[1] == 0x12 && opcode[2] == 0x13;
+}
+
+static bool _MatchesDecrementJump(const uint8_t *opcode) {
+    return _IsDecRegister(opcode[0]) && opcode[1] == 0x20;
+}
+
+static bool _MatchesPollCompareJump(const uint8_t *opcode) {
+    return opcode[0] == 0xF0 && opcode[2] == 0xFE && (opcode[4] == 0x20 || opcode[4] == 0x28);
+}
+
+/// JR NZ back to the start of a loop of the given size
+static bool _MatchesLoopJump(const uint8_t *opcode, int loopSize) {
+    return opcode[0] == 0x20 && (int8_t)opcode[1] == -loopSize;
+}
+
+/// LD A, B ; OR C or LD A, C ; OR B. Sets Z if BC is 0
+static bool _MatchesTestBC(const uint8_t *opcode) {
+    return (opcode[0] == 0x78 && opcode[1] == 0xB1) || (opcode[0] == 0x79 && opcode[1] == 0xB0);
+}
+
+static bool _MatchesCopyLoopBC(const uint8_t *opcode) {
+    return _MatchesCopyByte(opcode) && opcode[3] == 0x0B && _MatchesTestBC(opcode + 4) && _MatchesLoopJump(opcode + 6, 8);
+}
+
+static bool _MatchesCopyLoop8(const uint8_t *opcode) {
+    // Counter is DEC B or DEC C
+    return _MatchesCopyByte(opcode) && (opcode[3] == 0x05 || opcode[3] == 0x0D) && _MatchesLoopJump(opcode + 4, 6);
 }
 
+static bool _MatchesFillLoopBC(const uint8_t *opcode) {
+    return opcode[0] == 0x3E && opcode[2] == 0x22 && opcode[3] == 0x0B && _MatchesTestBC(opcode + 4) && _MatchesLoopJump(opcode + 6, 8);
+}
+
+static bool _MatchesClearLoopBC(const uint8_t *opcode) {
+    return opcode[0] == 0xAF && opcode[1] == 0x22 && opcode[2] == 0x0B && _MatchesTestBC(opcode + 3) && _MatchesLoopJump(opcode + 5, 7);
+}
+
+static bool _MatchesFillLoop8(const uint8_t *opcode) {
+    // Counter is DEC B, C, D or E. A is the value and HL is the destination
+    const bool validCounter = opcode[1] == 0x05 || opcode[1] == 0x0D || opcode[1] == 0x15 || opcode[1] == 0x1D;
+    return opcode[0] == 0x22 && validCounter && _MatchesLoopJump(opcode + 2, 4);
+}
+
+struct FusedInstructionEntry {
+    bool (*matches)(const uint8_t *);
+    CPUInstruction instruction;
+};
+
+// Whole loops first since they begin with shorter idioms
+static const FusedInstructionEntry FusedInstructionTable[] = {
+    { _MatchesCopyLoopBC, { 8, fusedCopyLoopBC } }, // LD A, (HL+) ; LD (DE), A ; INC DE ; DEC BC ; LD A, B ; OR C ; JR NZ
+    { _MatchesCopyLoop8, { 6, fusedCopyLoop8 } }, // LD A, (HL+) ; LD (DE), A ; INC DE ; DEC r ; JR NZ
+    { _MatchesFillLoopBC, { 8, fusedFillLoopBC } }, // LD A, n ; LD (HL+), A ; DEC BC ; LD A, B ; OR C ; JR NZ
+    { _MatchesClearLoopBC, { 7, fusedFillLoopBC } }, // XOR A ; LD (HL+), A ; DEC BC ; LD A, B ; OR C ; JR NZ
+    { _MatchesFillLoop8, { 4, fusedFillLoop8 } }, // LD (HL+), A ; DEC r ; JR NZ
+    { _MatchesCopyByte, { 3, fusedCopyByteHLToDE } }, // LD A, (HL+) ; LD (DE), A ; INC DE
+    { _MatchesDecrementJump, { 3, fusedDecrementJumpNotZero } }, // DEC r ; JR NZ, e
+    { _MatchesPollCompareJump, { 6, fusedPollCompareJump } }, // LD A, (n) ; CP n ; JR NZ/Z, e
+};
+
+const CPUInstruction *CPUInstruction::LookupFusedInstruction(const uint8_t *opcode, size_t available) {
+    for (const FusedInstructionEntry &entry : FusedInstructionTable) {
+        if (entry.instruction.size <= available && entry.matches(opcode)) {
+            return &entry.instruction;
+        }
+    }
+    return nullptr;
+}
@@ -8,24 +8,37 @@
 #ifndef CPUInstruction_hpp
 #define CPUInstruction_hpp
 
-#include <functional>
 #include "CPUCore.hpp"
 
 namespace MikoGB {
 
 struct CPUInstruction {
+    /// Plain function pointer rather than std::function so that dispatch is a single indirect call and the table can be
+    /// built at compile time
+    using Handler = int (*)(const uint8_t *, CPUCore &);
+    
     uint16_t size = 3; // default to 3 so that UnrecognizedInstruction exception can work
-    std::function<int(const uint8_t *, CPUCore &)> func = UnrecognizedInstruction;
+    Handler func = UnrecognizedInstruction;
+    
+    /// Look up the instruction for the opcode at the given pointer. If the first byte is the 0xCB extender, the second
+    /// byte must also be valid
+    static const CPUInstruction &LookupInstruction(const uint8_t *opcode) {
+        size_t idx = opcode[0];
+        if (idx == 0xCB) {
+            //Z80 Extended instruction set
+            //Index in the table is 0x1SS where SS is the extended opcode
+            idx = opcode[1] | 0x100;
+        }
+        
+        return InstructionTable[idx];
+    }
     
-    static void InitializeInstructionTable();
-#if BUILD_FOR_TESTING
-    static const CPUInstruction &LookupInstruction(uint8_t *);
-#else
-    static const CPUInstruction &LookupInstruction(const MemoryController::Ptr &, uint16_t);
-#endif
+    /// Look up a fused handler for a recognized multi-instruction idiom at the given pointer. `available` is the number
+    /// of valid bytes. Returns nullptr if the bytes don't start a known idiom
+    static const CPUInstruction *LookupFusedInstruction(const uint8_t *opcode, size_t available);
     
 private:
-    static CPUInstruction *InstructionTable;
+    static const CPUInstruction * const InstructionTable;
     static int UnrecognizedInstruction(const uint8_t *, CPUCore &);
 };
 
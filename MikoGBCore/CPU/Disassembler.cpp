@@ -62,7 +62,7 @@ static string DescriptionImmediate8Signed(uint8_t arg) {
     return oss.str();
 }
 
-static string lookupInstruction(uint16_t pc, const MemoryController::Ptr &mem, uint16_t &outSize) {
+static string lookupInstruction(uint16_t pc, MemoryController *mem, uint16_t &outSize) {
     size_t idx = mem->readByte(pc);
     uint16_t offset = 1;
     if (idx == 0xCB) {
@@ -104,7 +104,7 @@ static string lookupInstruction(uint16_t pc, const MemoryController::Ptr &mem, u
     assert(0);
 }
 
-std::vector<DisassembledInstruction> Disassembler::disassembleInstructions(uint16_t pc, int maxCount, const MemoryController::Ptr &mem) const {
+std::vector<DisassembledInstruction> Disassembler::disassembleInstructions(uint16_t pc, int maxCount, MemoryController *mem) const {
     vector<DisassembledInstruction> instructions;
     assert(pc < 0x8000 || (pc >= 0xFF80 && pc < 0xFFFF));
     
@@ -143,7 +143,7 @@ std::vector<DisassembledInstruction> Disassembler::disassembleInstructions(uint1
     return instructions;
 }
 
-std::vector<DisassembledInstruction> Disassembler::precedingDisassembledInstructions(uint16_t pc, int maxCount, const MemoryController::Ptr &mem, const CPUCore::Ptr &cpu) const {
+std::vector<DisassembledInstruction> Disassembler::precedingDisassembledInstructions(uint16_t pc, int maxCount, MemoryController *mem, const CPUCore *cpu) const {
     vector<DisassembledInstruction> instructions;
     assert(pc < 0x8000 || (pc >= 0xFF80 && pc < 0xFFFF));
     
@@ -203,7 +203,7 @@ std::vector<DisassembledInstruction> Disassembler::precedingDisassembledInstruct
     return instructions;
 }
 
-std::vector<DisassembledInstruction> Disassembler::lastExecutedInstructions(int maxCount, const MemoryController::Ptr &mem, const CPUCore::Ptr &cpu) const {
+std::vector<DisassembledInstruction> Disassembler::lastExecutedInstructions(int maxCount, MemoryController *mem, const CPUCore *cpu) const {
     const int currentBank = mem->currentROMBank();
     vector<KnownInstruction> knownInstructions = cpu->_previousInstructions.previousInstructions(maxCount);
     vector<DisassembledInstruction> disassembled;
@@ -0,0 +1,241 @@
+//
+//  IdleLoopDetector.cpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#include "IdleLoopDetector.hpp"
+#include "CPUCore.hpp"
+#include "CPUInstruction.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace MikoGB;
+
+static const uint16_t SwitchableROMBaseAddr = 0x4000;
+static const uint16_t ROMEndAddr = 0x8000;
+static const uint16_t MaxLoopLength = 32;
+// Limit on a single skip if nothing is scheduled. One frame of CPU cycles at normal speed
+static const uint64_t MaxSkippedCPUCycles = 456 * 154;
+
+static inline uint64_t _LoopKey(bool bootROMMapped, int bank, uint16_t headPC, uint16_t branchPC) {
+    return ((uint64_t)bootROMMapped << 48) | ((uint64_t)(uint16_t)bank << 32) | ((uint32_t)headPC << 16) | branchPC;
+}
+
+/// Whether memory at addr only changes when the CPU writes it or at a scheduled event
+static inline bool _IsIdleReadAddress(uint16_t addr) {
+    if (addr >= 0xA000 && addr < 0xC000) {
+        // External RAM may be a real time clock register
+        return false;
+    } else if (addr >= 0xFF01 && addr <= 0xFF07) {
+        // Serial and timer registers. DIV changes every cycle
+        return false;
+    } else if (addr >= 0xFF10 && addr <= 0xFF3F) {
+        // Audio, which isn't scheduled precisely
+        return false;
+    }
+    return true;
+}
+
+/// Bits for register codes, e.g. RegisterBit(REGISTER_A)
+static inline uint8_t _RegisterBit(int reg) {
+    return 1 << reg;
+}
+
+bool IdleLoopDetector::LoopState::operator==(const LoopState &other) const {
+    return memcmp(registers, other.registers, sizeof(registers)) == 0 &&
+        stackPointer == other.stackPointer &&
+        interruptState == other.interruptState;
+}
+
+IdleLoopDetector::LoopAnalysis IdleLoopDetector::_analyzeLoop(CPUCore &core, uint16_t headPC, uint16_t endPC) const {
+    LoopAnalysis analysis;
+    if (endPC > ROMEndAddr || endPC - headPC > MaxLoopLength) {
+        return analysis;
+    }
+
+    uint8_t writtenRegisters = 0;
+    uint16_t pc = headPC;
+    while (pc < endPC) {
+        uint8_t bytes[3] = { core.getMemory(pc), 0, 0 };
+        if (bytes[0] == 0xCB) {
+            bytes[1] = core.getMemory(pc + 1);
+        }
+        const uint16_t size = CPUInstruction::LookupInstruction(bytes).size;
+        for (uint16_t i = 1; i < size; ++i) {
+            bytes[i] = core.getMemory(pc + i);
+        }
+        pc += size;
+
+        const uint8_t opcode = bytes[0];
+        int jumpTarget = -1;
+        if (opcode == 0x00 || opcode == 0x37 || opcode == 0x3F) {
+            // NOP, SCF, CCF
+        } else if ((opcode & 0xC7) == 0x06) {
+            // LD r, n
+            const int dst = (opcode >> 3) & 0x7;
+            if (dst == REGISTER_F) {
+                // LD (HL), n
+                return analysis;
+            }
+            writtenRegisters |= _RegisterBit(dst);
+        } else if (opcode == 0x0A || opcode == 0x1A) {
+            // LD A, (BC) and LD A, (DE)
+            analysis.readsPtrBC |= opcode == 0x0A;
+            analysis.readsPtrDE |= opcode == 0x1A;
+            writtenRegisters |= _RegisterBit(REGISTER_A);
+        } else if (opcode == 0x07 || opcode == 0x0F || opcode == 0x17 || opcode == 0x1F || opcode == 0x2F) {
+            // Rotates of A and CPL
+            writtenRegisters |= _RegisterBit(REGISTER_A);
+        } else if (opcode >= 0x40 && opcode < 0x80) {
+            // LD r, r'. Register code 6 is (HL)
+            const int dst = (opcode >> 3) & 0x7;
+            const int src = opcode & 0x7;
+            if (dst == REGISTER_F) {
+                // LD (HL), r and HALT
+                return analysis;
+            }
+            analysis.readsPtrHL |= src == REGISTER_F;
+            writtenRegisters |= _RegisterBit(dst);
+        } else if (opcode >= 0x80 && opcode < 0xC0) {
+            // 8-bit ALU with A. CP only sets flags
+            analysis.readsPtrHL |= (opcode & 0x7) == REGISTER_F;
+            if (opcode < 0xB8) {
+                writtenRegisters |= _RegisterBit(REGISTER_A);
+            }
+        } else if ((opcode & 0xC7) == 0xC6) {
+            // 8-bit ALU with an immediate
+            if (opcode != 0xFE) {
+                writtenRegisters |= _RegisterBit(REGISTER_A);
+            }
+        } else if (opcode == 0xF0 || opcode == 0xFA) {
+            // LDH A, (n) and LD A, (nn)
+            const uint16_t addr = opcode == 0xF0 ? 0xFF00 + bytes[1] : word16(bytes[1], bytes[2]);
+            if (!_IsIdleReadAddress(addr)) {
+                return analysis;
+            }
+            writtenRegisters |= _RegisterBit(REGISTER_A);
+        } else if (opcode == 0xF2) {
+            // LD A, (C)
+            analysis.readsPtrC = true;
+            writtenRegisters |= _RegisterBit(REGISTER_A);
+        } else if (opcode == 0xCB && bytes[1] >= 0x40 && bytes[1] < 0x80) {
+            // BIT b, r. Only sets flags
+            analysis.readsPtrHL |= (bytes[1] & 0x7) == REGISTER_F;
+        } else if (opcode == 0x18 || opcode == 0x20 || opcode == 0x28 || opcode == 0x30 || opcode == 0x38) {
+            // JR
+            jumpTarget = pc + (int8_t)bytes[1];
+        } else if (opcode == 0xC2 || opcode == 0xC3 || opcode == 0xCA || opcode == 0xD2 || opcode == 0xDA) {
+            // JP
+            jumpTarget = word16(bytes[1], bytes[2]);
+        } else {
+            // Anything that could write memory, touch the stack or call elsewhere
+            return analysis;
+        }
+
+        // Jumps may stay within the loop or leave it, but can't reach code before the loop. That code could return to
+        // the middle of the loop without a backwards jump, so an iteration would include code that wasn't analyzed
+        if (jumpTarget >= 0 && jumpTarget < headPC) {
+            return analysis;
+        }
+    }
+
+    // Memory read through a register pair is only checked at the start of each iteration, so the pair can't change
+    const bool writesHL = (writtenRegisters & (_RegisterBit(REGISTER_H) | _RegisterBit(REGISTER_L))) != 0;
+    const bool writesBC = (writtenRegisters & (_RegisterBit(REGISTER_B) | _RegisterBit(REGISTER_C))) != 0;
+    const bool writesDE = (writtenRegisters & (_RegisterBit(REGISTER_D) | _RegisterBit(REGISTER_E))) != 0;
+    const bool writesC = (writtenRegisters & _RegisterBit(REGISTER_C)) != 0;
+    if ((analysis.readsPtrHL && writesHL) || (analysis.readsPtrBC && writesBC) ||
+        (analysis.readsPtrDE && writesDE) || (analysis.readsPtrC && writesC)) {
+        return analysis;
+    }
+    analysis.isEligible = true;
+    return analysis;
+}
+
+uint64_t IdleLoopDetector::loopDidJumpBack(CPUCore &core, uint16_t branchPC, uint16_t branchSize, uint64_t arrivalCPUCycles) {
+    MemoryController *mem = core.memoryController;
+    const uint16_t headPC = core.programCounter;
+    const uint16_t endPC = branchPC + branchSize;
+    if (endPC > ROMEndAddr) {
+        // Only ROM is known not to change
+        _currentLoop = nullptr;
+        _hasSnapshot = false;
+        return 0;
+    }
+
+    // Bank 0 is always mapped at 0x0000-0x3FFF regardless of the switched bank
+    const int bank = endPC > SwitchableROMBaseAddr ? mem->currentROMBank() : 0;
+    const uint64_t key = _LoopKey(mem->isBootROMMapped(), bank, headPC, branchPC);
+    if (key != _currentKey || !_currentLoop) {
+        _currentKey = key;
+        _hasSnapshot = false;
+        auto existing = _loops.find(key);
+        if (existing == _loops.end()) {
+            existing = _loops.emplace(key, _analyzeLoop(core, headPC, endPC)).first;
+        }
+        _currentLoop = &existing->second;
+    }
+    if (!_currentLoop->isEligible) {
+        return 0;
+    }
+
+    LoopState state;
+    for (int i = 0; i < REGISTER_COUNT; ++i) {
+        state.registers[i] = core.registers[i];
+    }
+    state.registers[REGISTER_F] = core.getFlagsRegister();
+    state.stackPointer = core.stackPointer;
+    state.interruptState = core.interruptState;
+
+    // The last iteration has to have run without any events. Otherwise it may have read values from before and after
+    const size_t eventCount = mem->dueEventCount();
+    const bool isWaiting = _hasSnapshot && _snapshotEventCount == eventCount && _snapshot == state;
+    const uint64_t iterationCPUCycles = arrivalCPUCycles - _snapshotCPUCycles;
+    _hasSnapshot = true;
+    _snapshot = state;
+    _snapshotCPUCycles = arrivalCPUCycles;
+    _snapshotEventCount = eventCount;
+    if (!isWaiting || iterationCPUCycles == 0) {
+        return 0;
+    }
+
+    // Memory read through registers is checked now that their values are known
+    const LoopAnalysis &loop = *_currentLoop;
+    if ((loop.readsPtrHL && !_IsIdleReadAddress(core.getHLptr())) ||
+        (loop.readsPtrBC && !_IsIdleReadAddress(core.getBCptr())) ||
+        (loop.readsPtrDE && !_IsIdleReadAddress(core.getDEptr())) ||
+        (loop.readsPtrC && !_IsIdleReadAddress(core.getCptr()))) {
+        return 0;
+    }
+
+    if (!_currentLoop->wasDetected) {
+        _currentLoop->wasDetected = true;
+        _counters.detectedLoopCount += 1;
+    }
+
+    // Skip the iterations that finish before the next event. The scheduler hasn't advanced to the arrival yet
+    const uint64_t now = mem->scheduler.cpuCycles();
+    const uint64_t untilEvent = min(mem->scheduler.cpuCyclesUntilNextEvent(), MaxSkippedCPUCycles);
+    const uint64_t elapsed = arrivalCPUCycles - now;
+    if (untilEvent <= elapsed) {
+        return 0;
+    }
+    const uint64_t skippedIterations = (untilEvent - elapsed - 1) / iterationCPUCycles;
+    const uint64_t skippedCPUCycles = skippedIterations * iterationCPUCycles;
+    if (skippedCPUCycles > 0) {
+        _snapshotCPUCycles += skippedCPUCycles;
+        _counters.skipCount += 1;
+        _counters.skippedCycles += skippedCPUCycles;
+    }
+    return skippedCPUCycles;
+}
+
+void IdleLoopDetector::invalidate() {
+    _loops.clear();
+    _currentKey = UINT64_MAX;
+    _currentLoop = nullptr;
+    _hasSnapshot = false;
+}
@@ -0,0 +1,75 @@
+//
+//  IdleLoopDetector.hpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#ifndef IdleLoopDetector_hpp
+#define IdleLoopDetector_hpp
+
+#include <unordered_map>
+#include "GameBoyCoreTypes.h"
+
+namespace MikoGB {
+
+class CPUCore;
+
+/// Finds loops in ROM that are only waiting for another component, e.g. polling LY or STAT until the GPU reaches some
+/// line or mode, and fast-forwards through them
+///
+/// A loop qualifies if its body only reads registers and memory whose values can't change until a scheduled event
+/// (GPU registers, interrupt requests, RAM), and never writes memory. If one whole iteration runs without any event
+/// and ends in exactly the CPU state that it started in, every following iteration will do the same until the next
+/// event. Those iterations can be skipped, as long as the last one still finishes before the event so that the CPU
+/// observes the change on the same cycle as it would have by executing every iteration
+class IdleLoopDetector {
+public:
+    /// Call after the instruction at branchPC jumped backwards to the start of a loop at the CPU's current program
+    /// counter. arrivalCPUCycles is the scheduler's CPU cycle count once the jump completes
+    /// Returns CPU cycles of whole iterations that can be skipped without executing them. The CPU state is left as is
+    uint64_t loopDidJumpBack(CPUCore &core, uint16_t branchPC, uint16_t branchSize, uint64_t arrivalCPUCycles);
+
+    /// Something other than the loop ran since the last jump back (e.g. an interrupt handler)
+    void interrupted() { _hasSnapshot = false; }
+
+    /// Drop all analyzed loops, e.g. if new ROM data is loaded
+    void invalidate();
+
+    const IdleLoopCounters &counters() const { return _counters; }
+
+private:
+    struct LoopAnalysis {
+        bool isEligible = false;
+        bool wasDetected = false; // found waiting at least once, for counters
+        // Memory read through register pairs (or 0xFF00 + C). Checked against the state of each iteration
+        bool readsPtrHL = false;
+        bool readsPtrBC = false;
+        bool readsPtrDE = false;
+        bool readsPtrC = false;
+    };
+    std::unordered_map<uint64_t, LoopAnalysis> _loops;
+
+    struct LoopState {
+        uint8_t registers[8]; // REGISTER_COUNT, with F including any lazy flags
+        uint16_t stackPointer;
+        int interruptState;
+        bool operator==(const LoopState &other) const;
+    };
+
+    // The loop most recently jumped back to and the state at the start of its last iteration
+    uint64_t _currentKey = UINT64_MAX;
+    LoopAnalysis *_currentLoop = nullptr;
+    bool _hasSnapshot = false;
+    LoopState _snapshot;
+    uint64_t _snapshotCPUCycles = 0;
+    size_t _snapshotEventCount = 0;
+
+    IdleLoopCounters _counters;
+
+    LoopAnalysis _analyzeLoop(CPUCore &core, uint16_t headPC, uint16_t endPC) const;
+};
+
+}
+
+#endif /* IdleLoopDetector_hpp */
@@ -0,0 +1,132 @@
+//
+//  InstructionBlockCache.cpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#include "InstructionBlockCache.hpp"
+#include "CPUInstruction.hpp"
+#include <algorithm>
+
+using namespace std;
+using namespace MikoGB;
+
+static const uint16_t SwitchableROMBaseAddr = 0x4000;
+static const uint16_t ROMEndAddr = 0x8000;
+static const size_t MaxBlockLength = 64;
+
+static inline uint32_t _BlockKey(int bank, uint16_t pc) {
+    // Bank 0 is always mapped at 0x0000-0x3FFF regardless of the switched bank
+    const uint32_t keyBank = pc < SwitchableROMBaseAddr ? 0 : bank;
+    return (keyBank << 16) | pc;
+}
+
+/// Control flow instructions end a block since the following bytes may never be executed (or may not be code)
+static inline bool _EndsBlock(uint8_t opcode) {
+    switch (opcode) {
+        case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // JR
+        case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA: case 0xE9: // JP
+        case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC: // CALL
+        case 0xC0: case 0xC8: case 0xC9: case 0xD0: case 0xD8: case 0xD9: // RET, RETI
+        case 0xC7: case 0xCF: case 0xD7: case 0xDF: case 0xE7: case 0xEF: case 0xF7: case 0xFF: // RST
+        case 0x10: case 0x76: // STOP, HALT
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// Check each instruction, since a fused instruction may end with a jump
+static bool _ContainsBlockEnd(const DecodedInstruction &decoded) {
+    size_t offset = 0;
+    while (offset < decoded.size) {
+        const uint8_t *opcode = decoded.bytes + offset;
+        if (_EndsBlock(opcode[0])) {
+            return true;
+        }
+        offset += CPUInstruction::LookupInstruction(opcode).size;
+    }
+    return false;
+}
+
+InstructionBlockCache::Block *InstructionBlockCache::_decodeBlock(MemoryController *mem, uint16_t pc) {
+    if (pc >= SwitchableROMBaseAddr && _currentBank < 0) {
+        _currentBank = mem->currentROMBank();
+    }
+    const uint32_t key = _BlockKey(_currentBank, pc);
+    auto existing = _blocks.find(key);
+    if (existing != _blocks.end()) {
+        return &existing->second;
+    }
+    
+    // Don't let a block run across the bank 0 / switchable bank boundary since the two halves are mapped independently
+    const uint32_t regionEnd = pc < SwitchableROMBaseAddr ? SwitchableROMBaseAddr : ROMEndAddr;
+    Block block;
+    block.romBank = pc < SwitchableROMBaseAddr ? 0 : _currentBank;
+    block.addr = pc;
+    uint32_t addr = pc;
+    while (block.instructions.size() < MaxBlockLength && addr < regionEnd) {
+        DecodedInstruction decoded;
+        const size_t available = min<size_t>(sizeof(decoded.bytes), regionEnd - addr);
+        for (size_t i = 0; i < sizeof(decoded.bytes); ++i) {
+            decoded.bytes[i] = i < available ? mem->readByte(addr + i) : 0;
+        }
+        
+        const CPUInstruction *instruction = nullptr;
+#if !ENABLE_DEBUGGER
+        // Fused idioms would skip over breakpoints and instruction history, so only use them without the debugger
+        instruction = CPUInstruction::LookupFusedInstruction(decoded.bytes, available);
+#endif
+        if (!instruction) {
+            instruction = &CPUInstruction::LookupInstruction(decoded.bytes);
+        }
+        if (instruction->size > available) {
+            // Straddles the boundary, leave it to the uncached path
+            break;
+        }
+        decoded.func = instruction->func;
+        decoded.size = instruction->size;
+        block.instructions.push_back(decoded);
+        addr += instruction->size;
+        
+        if (_ContainsBlockEnd(decoded)) {
+            break;
+        }
+    }
+    
+    if (block.instructions.empty()) {
+        return nullptr;
+    }
+    auto inserted = _blocks.emplace(key, std::move(block));
+    return &inserted.first->second;
+}
+
+void InstructionBlockCache::invalidate() {
+    _blocks.clear();
+    _currentBlock = nullptr;
+    _currentIdx = 0;
+    _currentBank = -1;
+}
+
+std::vector<InstructionBlockProfile> InstructionBlockCache::hottestBlocks(size_t maxCount) const {
+    vector<InstructionBlockProfile> profiles;
+    profiles.reserve(_blocks.size());
+    for (const auto &entry : _blocks) {
+        const Block &block = entry.second;
+        InstructionBlockProfile profile;
+        profile.romBank = block.romBank;
+        profile.addr = block.addr;
+        profile.instructionCount = block.instructions.size();
+        profile.entryCount = block.entryCount;
+        profiles.push_back(profile);
+    }
+    
+    sort(profiles.begin(), profiles.end(), [](const InstructionBlockProfile &a, const InstructionBlockProfile &b) {
+        return a.entryCount > b.entryCount;
+    });
+    if (profiles.size() > maxCount) {
+        profiles.resize(maxCount);
+    }
+    return profiles;
+}
@@ -0,0 +1,119 @@
+//
+//  InstructionBlockCache.hpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#ifndef InstructionBlockCache_hpp
+#define InstructionBlockCache_hpp
+
+#include <vector>
+#include <unordered_map>
+#include "MemoryController.hpp"
+#include "GameBoyCoreTypes.h"
+
+namespace MikoGB {
+
+class CPUCore;
+struct NativeBlock;
+
+/// An instruction that has already been fetched and looked up. Executing it needs no memory reads or table lookups
+struct DecodedInstruction {
+    using Handler = int (*)(const uint8_t *, CPUCore &); // same as CPUInstruction::Handler
+    Handler func;
+    uint8_t bytes[8]; // opcode and operands, same layout that handlers expect. Fused instructions use up to 8
+    uint8_t size;
+};
+
+/// Caches straight-line runs of instructions in ROM, decoded once and keyed by (ROM bank, address)
+/// Only code in the ROM address space is cached since it can't be modified. Code running from RAM (e.g. HRAM DMA
+/// routines) or the boot ROM is never cached and lookups return nullptr so that the CPU falls back to normal decoding
+class InstructionBlockCache {
+public:
+    /// Get the decoded instruction at pc. Sequential lookups walk the current block without any map lookups
+    const DecodedInstruction *lookup(MemoryController *mem, uint16_t pc);
+    
+    /// Drop all decoded blocks, e.g. if new ROM data is loaded
+    void invalidate();
+    
+    size_t blockCount() const { return _blocks.size(); }
+    
+    /// Blocks sorted by how many times execution has entered them, most first
+    std::vector<InstructionBlockProfile> hottestBlocks(size_t maxCount) const;
+    
+    struct Block {
+        int romBank = 0;
+        uint16_t addr = 0;
+        size_t entryCount = 0; // times execution started at the beginning of the block, rather than continuing within it
+        std::vector<DecodedInstruction> instructions;
+        
+        // Compiled once the block is hot. See InstructionJIT
+        const NativeBlock *nativeBlock = nullptr;
+        bool isNativeUnsupported = false;
+    };
+    
+    /// The block of the instruction that the last lookup() returned, or nullptr if it wasn't cached
+    Block *currentBlock() const { return _currentBlock; }
+    /// Index of that instruction in currentBlock()
+    size_t currentIndex() const { return _currentIdx; }
+    
+    /// Move the cursor past count instructions, starting with the current one, after they ran some other way, with pc
+    /// where execution continues
+    void skipInstructions(size_t count, uint16_t pc) {
+        _currentIdx += count - 1;
+        _nextPC = pc;
+    }
+    
+private:
+    std::unordered_map<uint32_t, Block> _blocks;
+    
+    // Cursor into the block most recently executed from
+    Block *_currentBlock = nullptr;
+    size_t _currentIdx = 0;
+    uint16_t _nextPC = 0;
+    
+    // ROM bank mapped into 0x4000-0x7FFF. Re-read lazily when the memory controller reports a mapping change
+    int _currentBank = -1;
+    uint32_t _mappingGeneration = 0;
+    
+    Block *_decodeBlock(MemoryController *mem, uint16_t pc);
+};
+
+inline const DecodedInstruction *InstructionBlockCache::lookup(MemoryController *mem, uint16_t pc) {
+    if (pc >= 0x8000 || mem->isBootROMMapped()) {
+        // Not ROM, or ROM shadowed by the boot ROM
+        return nullptr;
+    }
+    
+    const uint32_t generation = mem->romMappingGeneration();
+    if (generation != _mappingGeneration) {
+        // A bank switch (or some other MBC control write) happened. Blocks stay valid since they're keyed by bank,
+        // but the cursor may now point into a bank that is no longer mapped
+        _mappingGeneration = generation;
+        _currentBank = -1;
+        _currentBlock = nullptr;
+    }
+    
+    if (_currentBlock && pc == _nextPC && _currentIdx + 1 < _currentBlock->instructions.size()) {
+        // Fall through to the next instruction in the block
+        const DecodedInstruction &next = _currentBlock->instructions[++_currentIdx];
+        _nextPC = pc + next.size;
+        return &next;
+    }
+    
+    Block *block = _decodeBlock(mem, pc);
+    _currentBlock = block;
+    _currentIdx = 0;
+    if (!block) {
+        return nullptr;
+    }
+    block->entryCount += 1;
+    const DecodedInstruction &first = block->instructions.front();
+    _nextPC = pc + first.size;
+    return &first;
+}
+
+}
+
+#endif /* InstructionBlockCache_hpp */
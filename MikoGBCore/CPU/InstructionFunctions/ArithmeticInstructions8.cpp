@@ -15,17 +15,21 @@ using namespace MikoGB;
 static uint8_t _Add8BitOperands(int a, int b, bool addCarry, CPUCore &core) {
     const int carryIn = (addCarry && core.getFlag(FlagBit::Carry)) ? 1 : 0;
     const int sum = a + b + carryIn;
+    const uint8_t result = (0xFF & sum);
+#if ENABLE_LAZY_FLAGS
+    core.setLazyFlags(CPUCore::LazyFlagsOp::Add, a, b, carryIn);
+#else
     //carry in can be ignored when computing carry bits because we don't care about the low bit
     //each bit of carriedBits reflects whether there was carry out of the previous bit
     const int carriedBits = a ^ b ^ sum;
     const bool halfCarry = (carriedBits & 0x10) == 0x10; //bit 4 set? Means carry out of bit 3
     const bool carry = (carriedBits & 0x100) == 0x100; //bit 8 set? Means carry out of bit 7
     
-    const uint8_t result = (0xFF & sum);
     core.setFlag(FlagBit::Zero, result == 0);
     core.setFlag(FlagBit::H, halfCarry);
     core.setFlag(FlagBit::N, false);
     core.setFlag(FlagBit::Carry, carry);
+#endif
     
     return result;
 }
@@ -89,17 +93,21 @@ int CPUInstructions::addAccWithImmediate8AndCarry(const uint8_t *opcode, CPUCore
 static uint8_t _Sub8BitOperands(int a, int b, bool subCarry, CPUCore &core) {
     const int carryVal = (subCarry && core.getFlag(FlagBit::Carry)) ? 1 : 0;
     const int difference = a - b - carryVal;
+    const uint8_t result = (0xFF & difference);
+#if ENABLE_LAZY_FLAGS
+    core.setLazyFlags(CPUCore::LazyFlagsOp::Sub, a, b, carryVal);
+#else
     //carry in can be ignored when computing borrow bits because we don't care about the low bit
     //each bit of borrowed reflects whether there was a borrow from that bit
     const int borrowedBits = a ^ b ^ difference;
     const bool halfCarry = (borrowedBits & 0x10) == 0x10; //bit 4 set? Means borrow from bit 4
     const bool carry = (borrowedBits & 0x100) == 0x100; //bit 8 set? Means borrow from bit 8
     
-    const uint8_t result = (0xFF & difference);
     core.setFlag(FlagBit::Zero, result == 0);
     core.setFlag(FlagBit::H, halfCarry);
     core.setFlag(FlagBit::N, true);
     core.setFlag(FlagBit::Carry, carry);
+#endif
     
     return result;
 }
@@ -160,10 +168,14 @@ int CPUInstructions::subAccWithPtrHLAndCarry(const uint8_t *opcode, CPUCore &cor
 
 static uint8_t _And8BitOperands(uint8_t a, uint8_t b, CPUCore &core) {
     const uint8_t result = a & b;
+#if ENABLE_LAZY_FLAGS
+    core.setLazyFlags(CPUCore::LazyFlagsOp::And, a, b, false);
+#else
     core.setFlag(FlagBit::Zero, result == 0);
     core.setFlag(FlagBit::H, true);
     core.setFlag(FlagBit::N, false);
     core.setFlag(FlagBit::Carry, false);
+#endif
     return result;
 }
 
@@ -197,10 +209,14 @@ int CPUInstructions::andAccWithPtrHL(const uint8_t *opcode, CPUCore &core) {
 
 static uint8_t _Or8BitOperands(uint8_t a, uint8_t b, CPUCore &core) {
     const uint8_t result = a | b;
+#if ENABLE_LAZY_FLAGS
+    core.setLazyFlags(CPUCore::LazyFlagsOp::Logic, result, 0, false);
+#else
     core.setFlag(FlagBit::Zero, result == 0);
     core.setFlag(FlagBit::H, false);
     core.setFlag(FlagBit::N, false);
     core.setFlag(FlagBit::Carry, false);
+#endif
     return result;
 }
 
@@ -234,10 +250,14 @@ int CPUInstructions::orAccWithPtrHL(const uint8_t *opcode, MikoGB::CPUCore &core
 
 static uint8_t _Xor8BitOperands(uint8_t a, uint8_t b, CPUCore &core) {
     const uint8_t result = a ^ b;
+#if ENABLE_LAZY_FLAGS
+    core.setLazyFlags(CPUCore::LazyFlagsOp::Logic, result, 0, false);
+#else
     core.setFlag(FlagBit::Zero, result == 0);
     core.setFlag(FlagBit::H, false);
     core.setFlag(FlagBit::N, false);
     core.setFlag(FlagBit::Carry, false);
+#endif
     return result;
 }
 
@@ -270,10 +290,14 @@ int CPUInstructions::xorAccWithPtrHL(const uint8_t *opcode, CPUCore &core) {
 #pragma mark - CP
 
 static void _Cp8BitOperands(uint8_t a, uint8_t b, CPUCore &core) {
+#if ENABLE_LAZY_FLAGS
+    core.setLazyFlags(CPUCore::LazyFlagsOp::Cp, a, b, false);
+#else
     core.setFlag(FlagBit::Zero, a == b);
     core.setFlag(FlagBit::H, a > b);
     core.setFlag(FlagBit::N, true);
     core.setFlag(FlagBit::Carry, a < b);
+#endif
 }
 
 int CPUInstructions::cpAccWithRegister(const uint8_t *opcode, CPUCore &core) {
@@ -306,12 +330,16 @@ int CPUInstructions::cpAccWithPtrHL(const uint8_t *opcode, CPUCore &core) {
 
 static uint8_t _Inc8BitValue(uint8_t a, CPUCore &core) {
     const uint8_t sum = a + 1;
+#if ENABLE_LAZY_FLAGS
+    core.setLazyFlags(CPUCore::LazyFlagsOp::Inc, a, 0, core.getFlag(FlagBit::Carry));
+#else
     // We don't actually care about the low bit, so xor with the sum to get all bits with carry outs
     // from previous bits. Only one we care about is 3, so check 4 (0x10 mask)
     const uint8_t carriedBits = a ^ sum;
     core.setFlag(FlagBit::Zero, sum == 0);
     core.setFlag(FlagBit::H, (carriedBits & 0x10) == 0x10);
     core.setFlag(FlagBit::N, false);
+#endif
     //Carry flag is not touched
     return sum;
 }
@@ -337,12 +365,16 @@ int CPUInstructions::incPtrHL(const uint8_t *opcode, CPUCore &core) {
 
 static uint8_t _Dec8BitValue(uint8_t a, CPUCore &core) {
     const uint8_t diff = a - 1;
+#if ENABLE_LAZY_FLAGS
+    core.setLazyFlags(CPUCore::LazyFlagsOp::Dec, a, 0, core.getFlag(FlagBit::Carry));
+#else
     // We don't actually care about the low bit, so xor with the diff to get all bits borrowed from
     // Only one we care about is 4, so check mask 0x10
     const uint8_t carriedBits = a ^ diff;
     core.setFlag(FlagBit::Zero, diff == 0);
     core.setFlag(FlagBit::H, (carriedBits & 0x10) == 0x10);
     core.setFlag(FlagBit::N, true);
+#endif
     //Carry flag is not touched
     return diff;
 }
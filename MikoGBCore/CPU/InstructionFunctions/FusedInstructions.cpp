@@ -0,0 +1,173 @@
+//
+//  FusedInstructions.cpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#include "FusedInstructions.hpp"
+#include "LoadInstructions8.hpp"
+#include "ArithmeticInstructions8.hpp"
+#include "ArithmeticInstructions16.hpp"
+#include "JumpInstructions.hpp"
+#include "CPUInstruction.hpp"
+#include <algorithm>
+
+using namespace std;
+using namespace MikoGB;
+
+// Cycles a single bulk step may be charged. Kept under one scanline (114 cycles) so that stepping can't jump over a
+// whole line and GameBoyCore::emulateFrame() still sees line 0 begin each frame
+static const int MaxBulkLoopCycles = 112;
+
+// Marks BC as the loop counter rather than an 8-bit register
+static const int CounterBC = -1;
+
+static inline bool _CanFuse(const CPUCore &core) {
+    // With interrupts enabled, one could be dispatched between any of the fused instructions
+    return core.interruptState == CPUCore::InterruptState::Disabled;
+}
+
+/// Execute only the first instruction of the sequence, with the program counter pointing to the second
+static inline int _ExecuteFirstOnly(int (*first)(const uint8_t *, CPUCore &), uint16_t firstSize, uint16_t totalSize, const uint8_t *opcode, CPUCore &core) {
+    core.programCounter -= (totalSize - firstSize);
+    core.fusionCounters.fallbackCount += 1;
+    return first(opcode, core);
+}
+
+int CPUInstructions::fusedCopyByteHLToDE(const uint8_t *opcode, CPUCore &core) {
+    // Restrict to memory with no side effects that nothing else observes mid-instruction. An H-blank DMA step can run
+    // between the load and the store and may be reading from the destination
+    const uint16_t dst = core.getDEptr();
+    const bool plainRAM = (dst >= 0xA000 && dst < 0xE000) || (dst >= 0xFF80 && dst < 0xFFFF);
+    if (!plainRAM || !_CanFuse(core) || core.memoryController->isHBlankTransferActive()) {
+        return _ExecuteFirstOnly(loadAccumulatorFromPtrHLIncrement, 1, 3, opcode, core);
+    }
+    
+    core.fusionCounters.fusedCount += 1;
+    int cycles = loadAccumulatorFromPtrHLIncrement(opcode, core);
+    cycles += loadPtrDEFromAccumulator(opcode + 1, core);
+    cycles += incRegisterPair(opcode + 2, core);
+    return cycles;
+}
+
+int CPUInstructions::fusedDecrementJumpNotZero(const uint8_t *opcode, CPUCore &core) {
+    if (!_CanFuse(core)) {
+        return _ExecuteFirstOnly(decRegister, 1, 3, opcode, core);
+    }
+    
+    core.fusionCounters.fusedCount += 1;
+    int cycles = decRegister(opcode, core);
+    cycles += jumpConditionalRelative8(opcode + 1, core);
+    return cycles;
+}
+
+int CPUInstructions::fusedPollCompareJump(const uint8_t *opcode, CPUCore &core) {
+    if (!_CanFuse(core)) {
+        return _ExecuteFirstOnly(loadAccumulatorFromPtrImmediate8, 2, 6, opcode, core);
+    }
+    
+    core.fusionCounters.fusedCount += 1;
+    int cycles = loadAccumulatorFromPtrImmediate8(opcode, core);
+    cycles += cpAccWithImmediate8(opcode + 2, core);
+    cycles += jumpConditionalRelative8(opcode + 4, core);
+    return cycles;
+}
+
+#pragma mark - Bulk Loops
+
+static inline void _SetRegisterPair(CPUCore &core, int hiReg, int loReg, uint16_t val) {
+    splitWord16(val, core.registers[loReg], core.registers[hiReg]);
+}
+
+/// Number of iterations left, including the one about to start. The counter is tested after decrementing so 0 means
+/// the full range
+static inline size_t _RemainingIterations(const CPUCore &core, int counter) {
+    if (counter == CounterBC) {
+        const uint16_t bc = core.getBCptr();
+        return bc == 0 ? 0x10000 : bc;
+    } else {
+        const uint8_t val = core.registers[counter];
+        return val == 0 ? 0x100 : val;
+    }
+}
+
+static int _ExecuteLoopIteration(const uint8_t *opcode, uint16_t size, CPUCore &core) {
+    int cycles = 0;
+    uint16_t offset = 0;
+    while (offset < size) {
+        const CPUInstruction &instruction = CPUInstruction::LookupInstruction(opcode + offset);
+        cycles += instruction.func(opcode + offset, core);
+        offset += instruction.size;
+    }
+    return cycles;
+}
+
+/// Execute as many iterations of a copy loop (from HL to DE) or fill loop (at HL) as fit in MaxBulkLoopCycles
+/// iterationCycles is the cost of one iteration that takes the jump back to the start
+static int _ExecuteBulkLoop(const uint8_t *opcode, uint16_t size, int iterationCycles, int counter, bool isCopy, uint8_t fillVal, CPUCore &core) {
+    size_t written = 0;
+    if (_CanFuse(core)) {
+        const size_t maxCount = min<size_t>(_RemainingIterations(core, counter), MaxBulkLoopCycles / iterationCycles);
+        if (isCopy) {
+            written = core.bulkCopyMemory(core.getDEptr(), core.getHLptr(), maxCount);
+        } else {
+            written = core.bulkFillMemory(core.getHLptr(), fillVal, maxCount);
+        }
+    }
+    if (written == 0) {
+        const CPUInstruction &first = CPUInstruction::LookupInstruction(opcode);
+        return _ExecuteFirstOnly(first.func, first.size, size, opcode, core);
+    }
+    
+    // Skip ahead to the start of the last iteration that was written. Its byte is already in place, so executing it
+    // normally is harmless and leaves A, the flags and the program counter exactly as stepping would have
+    const uint16_t skipped = written - 1;
+    _SetRegisterPair(core, REGISTER_H, REGISTER_L, core.getHLptr() + skipped);
+    if (isCopy) {
+        _SetRegisterPair(core, REGISTER_D, REGISTER_E, core.getDEptr() + skipped);
+    }
+    if (counter == CounterBC) {
+        _SetRegisterPair(core, REGISTER_B, REGISTER_C, core.getBCptr() - skipped);
+    } else {
+        core.registers[counter] -= skipped;
+    }
+    
+    const int acceleratedCycles = skipped * iterationCycles;
+    const int cycles = _ExecuteLoopIteration(opcode, size, core);
+    
+    core.fusionCounters.fusedCount += 1;
+    core.fusionCounters.bulkLoopCount += 1;
+    core.fusionCounters.acceleratedCycles += acceleratedCycles;
+    return cycles + acceleratedCycles;
+}
+
+static inline int _DecrementedRegister(uint8_t decOpcode) {
+    // DEC r is 00rrr101
+    return (decOpcode >> 3) & 0x7;
+}
+
+int CPUInstructions::fusedCopyLoopBC(const uint8_t *opcode, CPUCore &core) {
+    // 2 + 2 + 2 + 2 + 1 + 1 + 3
+    return _ExecuteBulkLoop(opcode, 8, 13, CounterBC, true, 0, core);
+}
+
+int CPUInstructions::fusedCopyLoop8(const uint8_t *opcode, CPUCore &core) {
+    // 2 + 2 + 2 + 1 + 3
+    return _ExecuteBulkLoop(opcode, 6, 10, _DecrementedRegister(opcode[3]), true, 0, core);
+}
+
+int CPUInstructions::fusedFillLoopBC(const uint8_t *opcode, CPUCore &core) {
+    if (opcode[0] == 0x3E) {
+        // LD A, n: 2 + 2 + 2 + 1 + 1 + 3
+        return _ExecuteBulkLoop(opcode, 8, 11, CounterBC, false, opcode[1], core);
+    } else {
+        // XOR A: 1 + 2 + 2 + 1 + 1 + 3
+        return _ExecuteBulkLoop(opcode, 7, 10, CounterBC, false, 0, core);
+    }
+}
+
+int CPUInstructions::fusedFillLoop8(const uint8_t *opcode, CPUCore &core) {
+    // 2 + 1 + 3
+    return _ExecuteBulkLoop(opcode, 4, 6, _DecrementedRegister(opcode[1]), false, core.registers[REGISTER_A], core);
+}
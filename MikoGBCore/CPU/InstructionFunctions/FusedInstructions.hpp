@@ -0,0 +1,63 @@
+//
+//  FusedInstructions.hpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#ifndef FusedInstructions_hpp
+#define FusedInstructions_hpp
+
+#include "CPUCore.hpp"
+
+namespace CPUInstructions {
+
+// =========================================
+// Fused Instructions
+// =========================================
+// Common multi-instruction idioms executed as a single step. The opcode pointer covers the whole sequence and the
+// program counter has already been advanced past all of it. Fusing is only done when no interrupt can be dispatched
+// between the instructions (IME disabled), so the result is the same as stepping each one. Otherwise, only the first
+// instruction is executed and the program counter is rewound to the second
+
+/// LD A, (HL+) ; LD (DE), A ; INC DE
+/// One iteration of a byte copy loop. Bytes are [ 0x2A, 0x12, 0x13 ]
+/// Only fused when DE points to external RAM, WRAM or HRAM
+int fusedCopyByteHLToDE(const uint8_t *, MikoGB::CPUCore &);
+
+/// DEC r ; JR NZ, e
+/// One iteration of a countdown loop. Bytes are [ 0, 0, r2, r1, r0, 1, 0, 1 ], [ 0x20 ], [ e ]
+int fusedDecrementJumpNotZero(const uint8_t *, MikoGB::CPUCore &);
+
+/// LD A, (n) ; CP n ; JR cc, e
+/// One iteration of a polling loop, e.g. waiting on LY or STAT. Bytes are [ 0xF0 ], [ n ], [ 0xFE ], [ n ], [ 0x20 or 0x28 ], [ e ]
+int fusedPollCompareJump(const uint8_t *, MikoGB::CPUCore &);
+
+// =========================================
+// Bulk Loops
+// =========================================
+// Whole copy and fill loops, where the final JR NZ jumps back to the first instruction. Several iterations at a time
+// are done as a single native memory operation, charging the cycles the loop would have taken. The last
+// iteration in each step is executed normally so that the registers, flags and program counter are exact. Falls back
+// to the first instruction only if interrupts are enabled or the destination isn't plain RAM (see MemoryController)
+
+/// LD A, (HL+) ; LD (DE), A ; INC DE ; DEC BC ; LD A, B ; OR C ; JR NZ, -8
+/// Copy BC bytes from HL to DE. LD A, C ; OR B is also recognized
+int fusedCopyLoopBC(const uint8_t *, MikoGB::CPUCore &);
+
+/// LD A, (HL+) ; LD (DE), A ; INC DE ; DEC r ; JR NZ, -6
+/// Copy r bytes from HL to DE, where r is B or C
+int fusedCopyLoop8(const uint8_t *, MikoGB::CPUCore &);
+
+/// LD A, n ; LD (HL+), A ; DEC BC ; LD A, B ; OR C ; JR NZ, -8
+/// or XOR A ; LD (HL+), A ; DEC BC ; LD A, B ; OR C ; JR NZ, -7
+/// Fill BC bytes at HL with n (or 0). The value is reloaded each iteration since testing BC overwrites A
+int fusedFillLoopBC(const uint8_t *, MikoGB::CPUCore &);
+
+/// LD (HL+), A ; DEC r ; JR NZ, -4
+/// Fill r bytes at HL with A, where r is B, C, D or E
+int fusedFillLoop8(const uint8_t *, MikoGB::CPUCore &);
+
+}
+
+#endif /* FusedInstructions_hpp */
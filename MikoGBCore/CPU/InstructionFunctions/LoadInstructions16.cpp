@@ -68,7 +68,7 @@ int CPUInstructions::pushQQ(const uint8_t *opcode, CPUCore &core) {
             break;
         case 3:
             // PUSH AF
-            core.stackPush(core.registers[REGISTER_A], core.registers[REGISTER_F]);
+            core.stackPush(core.registers[REGISTER_A], core.getFlagsRegister());
             break;
     }
     
@@ -102,7 +102,7 @@ int CPUInstructions::popQQ(const uint8_t *opcode, CPUCore &core) {
             // POP AF
             core.stackPop(hi, lo);
             core.registers[REGISTER_A] = hi;
-            core.registers[REGISTER_F] = lo & 0xF0;
+            core.setFlagsRegister(lo & 0xF0);
             // The F register has a special format on intel 8080 derived processors
             // Specifically, when on the stack it has the format [ S, Z, 0, AC, 0, P, 1, C ]
             // S = Sign, Z = zero, AC = aux carry, P = parity, C = carry
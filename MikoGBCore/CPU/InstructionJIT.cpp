@@ -0,0 +1,553 @@
+//
+//  InstructionJIT.cpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#include "InstructionJIT.hpp"
+#include "CPUCore.hpp"
+#include "CPUInstruction.hpp"
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#if ENABLE_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace MikoGB;
+
+#if ENABLE_JIT
+
+static const size_t CodeChunkSize = 1024 * 1024;
+
+/// Where an instruction's memory operand is, so that it can be checked before the instruction runs
+enum class OperandAddress {
+    None,
+    HL,
+    BC,
+    DE,
+    HighC,      // 0xFF00 + C
+    StackPush,  // the 2 bytes below SP
+    StackPop,   // the 2 bytes at SP
+    Immediate,  // known when compiling
+};
+
+struct MemoryOperand {
+    OperandAddress address = OperandAddress::None;
+    bool isWrite = false;
+    uint32_t immediateAddr = 0;
+    uint8_t length = 1;
+};
+
+static MemoryOperand _Operand(OperandAddress address, bool isWrite, uint32_t immediateAddr = 0, uint8_t length = 1) {
+    MemoryOperand operand;
+    operand.address = address;
+    operand.isWrite = isWrite;
+    operand.immediateAddr = immediateAddr;
+    operand.length = length;
+    return operand;
+}
+
+/// The memory an instruction may access. Read-modify-write counts as a write
+static MemoryOperand _MemoryOperandForInstruction(const uint8_t *opcode) {
+    const uint8_t op = opcode[0];
+    if (op == 0xCB) {
+        // Rotates, shifts and bit operations on (HL)
+        return (opcode[1] & 0x7) == 6 ? _Operand(OperandAddress::HL, true) : MemoryOperand();
+    }
+    if (op >= 0x40 && op < 0x80) {
+        // LD r, r'. HALT (0x76) is never compiled
+        if ((op & 0x7) == 6) {
+            return _Operand(OperandAddress::HL, false);
+        } else if (((op >> 3) & 0x7) == 6) {
+            return _Operand(OperandAddress::HL, true);
+        }
+        return MemoryOperand();
+    }
+    if (op >= 0x80 && op < 0xC0) {
+        // 8-bit ALU operations with A
+        return (op & 0x7) == 6 ? _Operand(OperandAddress::HL, false) : MemoryOperand();
+    }
+    
+    switch (op) {
+        case 0x02: return _Operand(OperandAddress::BC, true);
+        case 0x0A: return _Operand(OperandAddress::BC, false);
+        case 0x12: return _Operand(OperandAddress::DE, true);
+        case 0x1A: return _Operand(OperandAddress::DE, false);
+        case 0x22: case 0x32: case 0x34: case 0x35: case 0x36: return _Operand(OperandAddress::HL, true);
+        case 0x2A: case 0x3A: return _Operand(OperandAddress::HL, false);
+        case 0x08: return _Operand(OperandAddress::Immediate, true, word16(opcode[1], opcode[2]), 2); // LD (nn), SP
+        case 0xE0: return _Operand(OperandAddress::Immediate, true, 0xFF00 + opcode[1]);
+        case 0xF0: return _Operand(OperandAddress::Immediate, false, 0xFF00 + opcode[1]);
+        case 0xEA: return _Operand(OperandAddress::Immediate, true, word16(opcode[1], opcode[2]));
+        case 0xFA: return _Operand(OperandAddress::Immediate, false, word16(opcode[1], opcode[2]));
+        case 0xE2: return _Operand(OperandAddress::HighC, true);
+        case 0xF2: return _Operand(OperandAddress::HighC, false);
+        case 0xC5: case 0xD5: case 0xE5: case 0xF5: // PUSH
+        case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC: // CALL
+        case 0xC7: case 0xCF: case 0xD7: case 0xDF: case 0xE7: case 0xEF: case 0xF7: case 0xFF: // RST
+            return _Operand(OperandAddress::StackPush, true, 0, 2);
+        case 0xC1: case 0xD1: case 0xE1: case 0xF1: // POP
+        case 0xC0: case 0xC8: case 0xC9: case 0xD0: case 0xD8: case 0xD9: // RET, RETI
+            return _Operand(OperandAddress::StackPop, false, 0, 2);
+        default:
+            return MemoryOperand();
+    }
+}
+
+/// Whether length bytes from start are memory that can be accessed without the scheduler's time being up to date or
+/// changing the code mapping. Everything except the I/O registers and IE can be read; writes also exclude the ROM area
+static bool _IsPlainMemory(uint32_t start, uint8_t length, bool isWrite) {
+    const uint32_t end = start + length - 1;
+    if (start > 0xFFFF) {
+        return false;
+    } else if (end < 0xFF00) {
+        return !isWrite || start >= 0x8000;
+    }
+    return start >= 0xFF80 && end < 0xFFFF;
+}
+
+static bool _IsCompilable(const DecodedInstruction &decoded) {
+    if (decoded.func != CPUInstruction::LookupInstruction(decoded.bytes).func) {
+        // A fused idiom. They already skip the per-instruction overhead, and have their own fallbacks
+        return false;
+    }
+    switch (decoded.bytes[0]) {
+        case 0x10: case 0x76: // STOP, HALT
+        case 0xD3: case 0xDB: case 0xDD: case 0xE3: case 0xE4: case 0xEB: case 0xEC: case 0xED: case 0xF4: case 0xFC: case 0xFD:
+            // Unrecognized, the interpreter throws
+            return false;
+        default:
+            return true;
+    }
+}
+
+/// Instructions after which the native code returns: anything that may jump, and EI and DI since interrupts are only
+/// checked between steps
+static bool _EndsNativeRun(uint8_t op) {
+    switch (op) {
+        case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // JR
+        case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA: case 0xE9: // JP
+        case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC: // CALL
+        case 0xC0: case 0xC8: case 0xC9: case 0xD0: case 0xD8: case 0xD9: // RET, RETI
+        case 0xC7: case 0xCF: case 0xD7: case 0xDF: case 0xE7: case 0xEF: case 0xF7: case 0xFF: // RST
+        case 0xF3: case 0xFB: // DI, EI
+            return true;
+        default:
+            return false;
+    }
+}
+
+namespace {
+
+/// Emits the few x86-64 instructions the compiler needs. Generated code keeps the CPUCore in rbx, elapsed instruction
+/// cycles in r13d, the cycle budget in r14d and the number of instructions run in r15d
+class Assembler {
+public:
+    explicit Assembler(const CPUCore &core): _core(core) {}
+    
+    vector<uint8_t> code;
+    
+    int32_t registerOffset(int reg) const { return _offset(&_core.registers[reg]); }
+    int32_t programCounterOffset() const { return _offset(&_core.programCounter); }
+    int32_t stackPointerOffset() const { return _offset(&_core.stackPointer); }
+    
+    void bytes(initializer_list<uint8_t> values) {
+        code.insert(code.end(), values);
+    }
+    
+    void imm16(uint16_t val) { _append(&val, sizeof(val)); }
+    void imm32(uint32_t val) { _append(&val, sizeof(val)); }
+    void imm64(uint64_t val) { _append(&val, sizeof(val)); }
+    
+    /// Jump with a 32-bit displacement, bound later. Returns the position of the displacement
+    size_t jump(initializer_list<uint8_t> opcode) {
+        bytes(opcode);
+        imm32(0);
+        return code.size() - 4;
+    }
+    
+    /// Point a jump at the current end of the code
+    void bind(size_t displacementPos) {
+        const int32_t displacement = (int32_t)(code.size() - (displacementPos + 4));
+        memcpy(code.data() + displacementPos, &displacement, sizeof(displacement));
+    }
+    
+    void prologue() {
+        // 5 pushes keep the stack 16-byte aligned for calls
+        bytes({ 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57 }); // push rbx, r12, r13, r14, r15
+        bytes({ 0x48, 0x89, 0xFB });        // mov rbx, rdi
+        bytes({ 0x41, 0x89, 0xF6 });        // mov r14d, esi
+        bytes({ 0x45, 0x31, 0xED });        // xor r13d, r13d
+        bytes({ 0x45, 0x31, 0xFF });        // xor r15d, r15d
+    }
+    
+    /// Jump to the entry in a table of absolute addresses indexed by the start index in edx. Returns the position of the
+    /// table's displacement
+    size_t dispatch() {
+        bytes({ 0x89, 0xD0 });              // mov eax, edx
+        const size_t tablePos = jump({ 0x48, 0x8D, 0x0D }); // lea rcx, [rip + table]
+        bytes({ 0xFF, 0x24, 0xC1 });        // jmp qword [rcx + rax * 8]
+        return tablePos;
+    }
+    
+    /// Returns (instructions run << 32) | cycles
+    void epilogue() {
+        bytes({ 0x44, 0x89, 0xF8 });        // mov eax, r15d
+        bytes({ 0x48, 0xC1, 0xE0, 0x20 });  // shl rax, 32
+        bytes({ 0x44, 0x89, 0xE9 });        // mov ecx, r13d
+        bytes({ 0x48, 0x09, 0xC8 });        // or rax, rcx
+        bytes({ 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B }); // pop r15, r14, r13, r12, rbx
+        bytes({ 0xC3 });                    // ret
+    }
+    
+    // reg is the x86 register number: 0 eax/al, 1 ecx, 2 edx, 4 ah
+    void loadByte(uint8_t reg, int32_t offset) { bytes({ 0x0F, 0xB6 }); _memory(reg, offset); }  // movzx reg, byte [rbx + offset]
+    void loadWord(uint8_t reg, int32_t offset) { bytes({ 0x0F, 0xB7 }); _memory(reg, offset); }  // movzx reg, word [rbx + offset]
+    void storeByte(uint8_t reg, int32_t offset) { bytes({ 0x88 }); _memory(reg, offset); }       // mov [rbx + offset], reg8
+    void storeWord(uint8_t reg, int32_t offset) { bytes({ 0x66, 0x89 }); _memory(reg, offset); } // mov [rbx + offset], reg16
+    void storeImm8(int32_t offset, uint8_t val) { bytes({ 0xC6 }); _memory(0, offset); bytes({ val }); }
+    void storeImm16(int32_t offset, uint16_t val) { bytes({ 0x66, 0xC7 }); _memory(0, offset); imm16(val); }
+    
+    /// eax = hi << 8 | lo for a register pair
+    void loadPair(int hi, int lo) {
+        loadByte(0, registerOffset(hi));
+        bytes({ 0xC1, 0xE0, 0x08 });        // shl eax, 8
+        loadByte(1, registerOffset(lo));
+        bytes({ 0x09, 0xC8 });              // or eax, ecx
+    }
+    
+    void storePair(int hi, int lo) {
+        storeByte(0, registerOffset(lo));
+        storeByte(4, registerOffset(hi));
+    }
+    
+    void addCycles(uint8_t cycles) { bytes({ 0x41, 0x83, 0xC5, cycles }); } // add r13d, cycles
+    void countInstruction() { bytes({ 0x41, 0xFF, 0xC7 }); }               // inc r15d
+    
+    /// cmp eax, val
+    void compareEAX(uint32_t val) { bytes({ 0x3D }); imm32(val); }
+    /// cmp edx, val
+    void compareEDX(uint32_t val) { bytes({ 0x81, 0xFA }); imm32(val); }
+
+private:
+    const CPUCore &_core;
+    
+    int32_t _offset(const void *member) const {
+        return (int32_t)((const uint8_t *)member - (const uint8_t *)&_core);
+    }
+    
+    void _append(const void *val, size_t size) {
+        const uint8_t *valBytes = (const uint8_t *)val;
+        code.insert(code.end(), valBytes, valBytes + size);
+    }
+    
+    /// ModRM for [rbx + disp32]
+    void _memory(uint8_t reg, int32_t offset) {
+        bytes({ (uint8_t)(0x80 | (reg << 3) | 3) });
+        imm32((uint32_t)offset);
+    }
+};
+
+}
+
+/// Leave the address of the instruction's memory operand in eax
+static void _EmitOperandAddress(Assembler &a, const MemoryOperand &operand) {
+    switch (operand.address) {
+        case OperandAddress::HL:
+            a.loadPair(REGISTER_H, REGISTER_L);
+            break;
+        case OperandAddress::BC:
+            a.loadPair(REGISTER_B, REGISTER_C);
+            break;
+        case OperandAddress::DE:
+            a.loadPair(REGISTER_D, REGISTER_E);
+            break;
+        case OperandAddress::HighC:
+            a.loadByte(0, a.registerOffset(REGISTER_C));
+            a.bytes({ 0x0D }); a.imm32(0xFF00);             // or eax, 0xFF00
+            break;
+        case OperandAddress::StackPush:
+            // SP below 2 wraps to a value above 0xFFFF, which is never plain memory
+            a.loadWord(0, a.stackPointerOffset());
+            a.bytes({ 0x83, 0xE8, 0x02 });                  // sub eax, 2
+            break;
+        case OperandAddress::StackPop:
+            a.loadWord(0, a.stackPointerOffset());
+            break;
+        case OperandAddress::None:
+        case OperandAddress::Immediate:
+            break;
+    }
+}
+
+/// Same check as _IsPlainMemory() on the address in eax, jumping to one of exits if it fails
+static void _EmitPlainMemoryCheck(Assembler &a, const MemoryOperand &operand, vector<size_t> &exits) {
+    a.compareEAX(0xFFFF);
+    exits.push_back(a.jump({ 0x0F, 0x87 }));                // ja exit
+    a.bytes({ 0x8D, 0x50, (uint8_t)(operand.length - 1) }); // lea edx, [rax + length - 1]
+    a.compareEDX(0xFF00);
+    const size_t toHighRange = a.jump({ 0x0F, 0x83 });      // jae highRange
+    if (operand.isWrite) {
+        a.compareEAX(0x8000);
+        exits.push_back(a.jump({ 0x0F, 0x82 }));            // jb exit
+    }
+    const size_t toPlain = a.jump({ 0xE9 });                // jmp plain
+    a.bind(toHighRange);
+    a.compareEAX(0xFF80);
+    exits.push_back(a.jump({ 0x0F, 0x82 }));                // jb exit
+    a.compareEDX(0xFFFF);
+    exits.push_back(a.jump({ 0x0F, 0x83 }));                // jae exit
+    a.bind(toPlain);
+}
+
+/// Generate the instruction inline if it only touches registers and doesn't need flags. Returns its cycles, the same
+/// as its handler's, or 0 if it has to call the handler
+static uint8_t _EmitInlineInstruction(Assembler &a, const uint8_t *opcode, uint16_t nextPC) {
+    const uint8_t op = opcode[0];
+    const int pcOffset = a.programCounterOffset();
+    if (op == 0x00) {
+        // NOP
+        a.storeImm16(pcOffset, nextPC);
+        return 1;
+    }
+    if (op >= 0x40 && op < 0x80 && (op & 0x7) != 6 && ((op >> 3) & 0x7) != 6) {
+        // LD r, r'
+        const int src = op & 0x7;
+        const int dst = (op >> 3) & 0x7;
+        if (src != dst) {
+            a.loadByte(0, a.registerOffset(src));
+            a.storeByte(0, a.registerOffset(dst));
+        }
+        a.storeImm16(pcOffset, nextPC);
+        return 1;
+    }
+    if ((op & 0xC7) == 0x06 && op != 0x36) {
+        // LD r, n
+        a.storeImm8(a.registerOffset((op >> 3) & 0x7), opcode[1]);
+        a.storeImm16(pcOffset, nextPC);
+        return 2;
+    }
+    
+    static const int PairHi[3] = { REGISTER_B, REGISTER_D, REGISTER_H };
+    static const int PairLo[3] = { REGISTER_C, REGISTER_E, REGISTER_L };
+    const int pair = (op >> 4) & 0x3;
+    switch (op) {
+        case 0x01: case 0x11: case 0x21:
+            // LD rr, nn
+            a.storeImm8(a.registerOffset(PairHi[pair]), opcode[2]);
+            a.storeImm8(a.registerOffset(PairLo[pair]), opcode[1]);
+            a.storeImm16(pcOffset, nextPC);
+            return 3;
+        case 0x31:
+            // LD SP, nn
+            a.storeImm16(a.stackPointerOffset(), word16(opcode[1], opcode[2]));
+            a.storeImm16(pcOffset, nextPC);
+            return 3;
+        case 0x03: case 0x13: case 0x23:
+        case 0x0B: case 0x1B: case 0x2B:
+            // INC rr, DEC rr. No flags
+            a.loadPair(PairHi[pair], PairLo[pair]);
+            a.bytes({ 0xFF, (uint8_t)(op & 0x08 ? 0xC8 : 0xC0) }); // dec eax / inc eax
+            a.storePair(PairHi[pair], PairLo[pair]);
+            a.storeImm16(pcOffset, nextPC);
+            return 2;
+        case 0x33: case 0x3B:
+            // INC SP, DEC SP
+            a.loadWord(0, a.stackPointerOffset());
+            a.bytes({ 0xFF, (uint8_t)(op & 0x08 ? 0xC8 : 0xC0) });
+            a.storeWord(0, a.stackPointerOffset());
+            a.storeImm16(pcOffset, nextPC);
+            return 2;
+        case 0xC3:
+            // JP nn
+            a.storeImm16(pcOffset, word16(opcode[1], opcode[2]));
+            return 4;
+        case 0x18:
+            // JR e, relative to the next instruction
+            a.storeImm16(pcOffset, (uint16_t)(nextPC + (int8_t)opcode[1]));
+            return 3;
+        case 0xE9:
+            // JP (HL)
+            a.loadPair(REGISTER_H, REGISTER_L);
+            a.storeWord(0, pcOffset);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+const NativeBlock *InstructionJIT::compile(const CPUCore &core, const DecodedInstruction *instructions, size_t count, int romBank, uint16_t addr) {
+    Assembler a(core);
+    a.prologue();
+    const size_t tableDisplacementPos = a.dispatch();
+    vector<size_t> exits;
+    // Where each instruction starts, after its budget check so that the first instruction of a run always starts
+    vector<size_t> entries;
+    // Handler calls take a pointer to the instruction bytes, which are copied after the code
+    struct HandlerOperands {
+        size_t immediatePos;
+        const DecodedInstruction *decoded;
+    };
+    vector<HandlerOperands> operands;
+    
+    size_t compiledCount = 0;
+    uint16_t pc = addr;
+    while (compiledCount < count) {
+        const DecodedInstruction &decoded = instructions[compiledCount];
+        if (!_IsCompilable(decoded)) {
+            break;
+        }
+        const MemoryOperand operand = _MemoryOperandForInstruction(decoded.bytes);
+        if (operand.address == OperandAddress::Immediate && !_IsPlainMemory(operand.immediateAddr, operand.length, operand.isWrite)) {
+            break;
+        }
+        
+        if (compiledCount > 0) {
+            // Stop once the next event is due
+            a.bytes({ 0x45, 0x39, 0xF5 });                  // cmp r13d, r14d
+            exits.push_back(a.jump({ 0x0F, 0x83 }));        // jae exit
+        }
+        entries.push_back(a.code.size());
+        if (operand.address != OperandAddress::None && operand.address != OperandAddress::Immediate) {
+            _EmitOperandAddress(a, operand);
+            _EmitPlainMemoryCheck(a, operand, exits);
+        }
+        
+        const uint16_t nextPC = pc + decoded.size;
+        const uint8_t inlineCycles = _EmitInlineInstruction(a, decoded.bytes, nextPC);
+        if (inlineCycles > 0) {
+            a.addCycles(inlineCycles);
+        } else {
+            // Handlers expect the program counter to already point past the instruction
+            a.storeImm16(a.programCounterOffset(), nextPC);
+            a.bytes({ 0x48, 0xBF });                        // mov rdi, bytes
+            operands.push_back({ a.code.size(), &decoded });
+            a.imm64(0);
+            a.bytes({ 0x48, 0x89, 0xDE });                  // mov rsi, rbx
+            a.bytes({ 0x48, 0xB8 });                        // mov rax, handler
+            a.imm64((uint64_t)decoded.func);
+            a.bytes({ 0xFF, 0xD0 });                        // call rax
+            a.bytes({ 0x41, 0x01, 0xC5 });                  // add r13d, eax
+        }
+        a.countInstruction();
+        ++compiledCount;
+        pc = nextPC;
+        if (_EndsNativeRun(decoded.bytes[0])) {
+            break;
+        }
+    }
+    if (compiledCount == 0) {
+        return nullptr;
+    }
+    
+    for (size_t exit : exits) {
+        a.bind(exit);
+    }
+    a.epilogue();
+    
+    // The code is followed by the handlers' operands and then the entry table
+    const size_t codeSize = a.code.size();
+    const size_t operandsPos = (codeSize + 7) & ~(size_t)7;
+    const size_t tablePos = operandsPos + operands.size() * sizeof(DecodedInstruction::bytes);
+    const size_t totalSize = tablePos + entries.size() * sizeof(uint64_t);
+    uint8_t *dst = _allocate(totalSize);
+    if (!dst) {
+        return nullptr;
+    }
+    a.code.resize(totalSize, 0xCC); // int3 padding
+    for (size_t i = 0; i < operands.size(); ++i) {
+        const size_t pos = operandsPos + i * sizeof(DecodedInstruction::bytes);
+        memcpy(a.code.data() + pos, operands[i].decoded->bytes, sizeof(DecodedInstruction::bytes));
+        const uint64_t operandAddr = (uint64_t)(dst + pos);
+        memcpy(a.code.data() + operands[i].immediatePos, &operandAddr, sizeof(operandAddr));
+    }
+    const int32_t tableDisplacement = (int32_t)(tablePos - (tableDisplacementPos + 4));
+    memcpy(a.code.data() + tableDisplacementPos, &tableDisplacement, sizeof(tableDisplacement));
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const uint64_t entryAddr = (uint64_t)(dst + entries[i]);
+        memcpy(a.code.data() + tablePos + i * sizeof(uint64_t), &entryAddr, sizeof(entryAddr));
+    }
+    
+    CodeChunk &chunk = _chunks.back();
+    mprotect(chunk.base, chunk.size, PROT_READ | PROT_WRITE);
+    memcpy(dst, a.code.data(), totalSize);
+    mprotect(chunk.base, chunk.size, PROT_READ | PROT_EXEC);
+    
+    NativeBlock block;
+    block.entry = (NativeBlock::Function)dst;
+    block.instructionCount = compiledCount;
+    block.romBank = romBank;
+    block.addr = addr;
+    _blocks.push_back(block);
+    _writePerfMapEntry(block, codeSize);
+    return &_blocks.back();
+}
+
+uint8_t *InstructionJIT::_allocate(size_t size) {
+    if (_chunks.empty() || _chunks.back().used + size > _chunks.back().size) {
+        const size_t chunkSize = max(size, CodeChunkSize);
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_JIT
+        flags |= MAP_JIT;
+#endif
+        void *base = mmap(nullptr, chunkSize, PROT_READ | PROT_EXEC, flags, -1, 0);
+        if (base == MAP_FAILED) {
+            cerr << "InstructionJIT Err: Unable to allocate code memory\n";
+            return nullptr;
+        }
+        CodeChunk chunk;
+        chunk.base = (uint8_t *)base;
+        chunk.size = chunkSize;
+        _chunks.push_back(chunk);
+    }
+    CodeChunk &chunk = _chunks.back();
+    uint8_t *allocated = chunk.base + chunk.used;
+    // Keep blocks 16-byte aligned
+    chunk.used = (chunk.used + size + 15) & ~(size_t)15;
+    return allocated;
+}
+
+void InstructionJIT::_writePerfMapEntry(const NativeBlock &block, size_t codeSize) {
+#if defined(__linux__)
+    if (!_perfMap) {
+        const string path = "/tmp/perf-" + to_string(getpid()) + ".map";
+        _perfMap = fopen(path.c_str(), "a");
+        if (!_perfMap) {
+            return;
+        }
+    }
+    fprintf(_perfMap, "%llx %zx gb_bank%d_%04X\n", (unsigned long long)block.entry, codeSize, block.romBank, block.addr);
+    fflush(_perfMap);
+#endif
+}
+
+void InstructionJIT::invalidate() {
+    _blocks.clear();
+    for (const CodeChunk &chunk : _chunks) {
+        munmap(chunk.base, chunk.size);
+    }
+    _chunks.clear();
+}
+
+InstructionJIT::~InstructionJIT() {
+    invalidate();
+    if (_perfMap) {
+        fclose(_perfMap);
+    }
+}
+
+#else
+
+const NativeBlock *InstructionJIT::compile(const CPUCore &core, const DecodedInstruction *instructions, size_t count, int romBank, uint16_t addr) {
+    return nullptr;
+}
+
+void InstructionJIT::invalidate() {}
+
+InstructionJIT::~InstructionJIT() {}
+
+#endif
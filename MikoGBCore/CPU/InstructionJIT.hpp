@@ -0,0 +1,92 @@
+//
+//  InstructionJIT.hpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#ifndef InstructionJIT_hpp
+#define InstructionJIT_hpp
+
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include "InstructionBlockCache.hpp"
+#include "GameBoyCoreTypes.h"
+
+namespace MikoGB {
+
+/// Native code for the start of a decoded block. See InstructionJIT
+struct NativeBlock {
+    using Function = uint64_t (*)(CPUCore *core, uint32_t cycleBudget, uint32_t startIndex);
+    Function entry = nullptr;
+    size_t instructionCount = 0; // instructions compiled, from the start of the block
+    int romBank = 0;
+    uint16_t addr = 0;
+};
+
+/// Compiles hot blocks of decoded ROM instructions to x86-64 code. Loads, 16-bit increments and unconditional jumps
+/// are generated inline and everything else calls the instruction's handler, so the generated code mostly saves the
+/// per-instruction dispatch and bookkeeping of CPUCore::step()
+///
+/// Running a native block must look the same as stepping through it, so it stops before an instruction when
+/// - the cycle budget is used up, i.e. another component's event would have run before it
+/// - it would read or write I/O registers, whose components sync to the scheduler's time, which isn't advanced until
+///   the block returns
+/// - it would write the ROM area, where a bank switch may remap the code that follows
+/// Compilation ends before instructions that are never compiled (HALT, STOP, fused idioms) and after EI and DI, since
+/// interrupts are only checked between steps. The interpreter takes over wherever the native code stops
+class InstructionJIT {
+public:
+    InstructionJIT() = default;
+    ~InstructionJIT();
+    InstructionJIT(const InstructionJIT &) = delete;
+    InstructionJIT &operator=(const InstructionJIT &) = delete;
+    
+    /// Whether native code can be generated on this host, see ENABLE_JIT
+    static bool IsSupported() { return ENABLE_JIT; }
+    
+    /// Compile as many of the count instructions starting at addr as possible. Returns nullptr if not even the first
+    /// could be compiled or native code isn't supported. The result stays valid until invalidate()
+    const NativeBlock *compile(const CPUCore &core, const DecodedInstruction *instructions, size_t count, int romBank, uint16_t addr);
+    
+    struct RunResult {
+        int cycles = 0;              // instruction cycles of everything that ran
+        size_t instructionCount = 0; // 0 if the first instruction has to be interpreted
+    };
+    
+    /// Run block from its instruction at startIndex (less than instructionCount), with the core's program counter at that
+    /// instruction. Instructions after the first only start while fewer than cycleBudget instruction cycles have elapsed
+    static RunResult Run(const NativeBlock &block, CPUCore &core, uint32_t cycleBudget, size_t startIndex = 0) {
+        const uint64_t result = block.entry(&core, cycleBudget, (uint32_t)startIndex);
+        RunResult runResult;
+        runResult.cycles = (int)(uint32_t)result;
+        runResult.instructionCount = (size_t)(result >> 32);
+        return runResult;
+    }
+    
+    /// Free all generated code, e.g. if new ROM data is loaded
+    void invalidate();
+    
+    size_t compiledBlockCount() const { return _blocks.size(); }
+
+private:
+    struct CodeChunk {
+        uint8_t *base = nullptr;
+        size_t size = 0;
+        size_t used = 0;
+    };
+    std::vector<CodeChunk> _chunks;
+    std::deque<NativeBlock> _blocks;
+    
+    /// Lines of "start size name" for Linux perf, so that samples in generated code are attributed to the Game Boy
+    /// code they came from. Opened when the first block is compiled
+    FILE *_perfMap = nullptr;
+    
+    uint8_t *_allocate(size_t size);
+    void _writePerfMapEntry(const NativeBlock &block, size_t codeSize);
+};
+
+}
+
+#endif /* InstructionJIT_hpp */
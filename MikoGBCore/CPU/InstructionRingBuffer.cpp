@@ -36,6 +36,12 @@ std::set<KnownInstruction> InstructionRingBuffer::uniqueInstructions() const {
     return _uniqueInstructions;
 }
 
+void InstructionRingBuffer::clear() {
+    _uniqueInstructions.clear();
+    _startPosition = 0;
+    _count = 0;
+}
+
 std::vector<KnownInstruction> InstructionRingBuffer::previousInstructions(size_t maxCount) const {
     vector<KnownInstruction> instructions;
     const size_t readSize = std::min(maxCount, _count);
@@ -29,6 +29,8 @@ public:
     std::set<KnownInstruction> uniqueInstructions() const;
     std::vector<KnownInstruction> previousInstructions(size_t maxCount) const;
     
+    void clear();
+    
 private:
     std::set<KnownInstruction> _uniqueInstructions;
     std::vector<KnownInstruction> _buffer;
@@ -18,7 +18,7 @@ static bool _PrintableAscii(uint8_t byte) {
     return byte == 0 || (byte >= 0x20 && byte < 0x7F);
 }
 
-static bool _ValidateLogoHeader(uint8_t *bytes) {
+static bool _ValidateLogoHeader(const uint8_t *bytes) {
     static const size_t LogoSize = 48;
     static const uint8_t LogoHeader[LogoSize] = { 0xCE, 0xED, 0x66, 0x66, 0xCC, 0x0D, 0x00, 0x0B, 0x03, 0x73, 0x00, 0x83, 0x00, 0x0C, 0x00, 0x0D, 0x00, 0x08, 0x11, 0x1F, 0x88, 0x89, 0x00, 0x0E, 0xDC, 0xCC, 0x6E, 0xE6, 0xDD, 0xDD, 0xD9, 0x99, 0xBB, 0xBB, 0x67, 0x63, 0x6E, 0x0E, 0xEC, 0xCC, 0xDD, 0xDC, 0x99, 0x9F, 0xBB, 0xB9, 0x33, 0x3E };
     
@@ -194,7 +194,7 @@ static string _CartridgeRAMSizeDescription(uint8_t byte) {
     }
 }
 
-void CartridgeHeader::readHeaderData(uint8_t *romData) {
+void CartridgeHeader::readHeaderData(const uint8_t *romData) {
     // Check that the logo is in the correct spot
     _validLogo = _ValidateLogoHeader(romData);
     
@@ -52,7 +52,7 @@ enum class CartridgeRAMSize {
 class CartridgeHeader {
 public:
     CartridgeHeader() = default;
-    void readHeaderData(uint8_t *romData);
+    void readHeaderData(const uint8_t *romData);
     
     bool isSupported() const;
     
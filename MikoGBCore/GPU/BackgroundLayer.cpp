@@ -0,0 +1,76 @@
+//
+//  BackgroundLayer.cpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#include "BackgroundLayer.hpp"
+#include "GPUTypes.hpp"
+
+using namespace MikoGB;
+
+static const uint16_t TileMapOffset = MemoryController::VRAMTileDataSize; // 0x9800 from the start of VRAM
+static const uint16_t TileMapEntriesPerRow = 32;
+static const uint8_t TileSize = 8;
+
+// The tile a map entry's code refers to, as an index from 0x8000
+static inline uint16_t _TileIndex(uint8_t code, bool signedMode) {
+    return signedMode ? (uint16_t)(256 + (int8_t)code) : code;
+}
+
+BackgroundLayer::BackgroundLayer() {
+    for (auto &indices : _indices) {
+        indices.resize(Size * Size);
+    }
+}
+
+void BackgroundLayer::update(MemoryController &mem, TileCache &tileCache, bool signedMode, bool useAttributes) {
+    if (signedMode != _signedMode || useAttributes != _useAttributes) {
+        // Every entry may refer to a different tile now
+        _signedMode = signedMode;
+        _useAttributes = useAttributes;
+        _needsFullUpdate = true;
+    }
+    if (!_needsFullUpdate && mem.getVRAMWriteCount() == _vramWriteCount) {
+        return;
+    }
+    _vramWriteCount = mem.getVRAMWriteCount();
+    
+    bool dirtyTiles[2][MemoryController::VRAMTileCount];
+    for (int bank = 0; bank < 2; ++bank) {
+        for (uint16_t tile = 0; tile < MemoryController::VRAMTileCount; ++tile) {
+            dirtyTiles[bank][tile] = mem.takeDirtyTile(MemoryController::BackgroundLayerReader, bank, tile);
+        }
+    }
+    
+    const uint8_t *codes = mem.videoRAMBank(0) + TileMapOffset;
+    const uint8_t *attributes = mem.videoRAMBank(1) + TileMapOffset;
+    for (uint16_t mapEntry = 0; mapEntry < MemoryController::VRAMTileMapEntryCount; ++mapEntry) {
+        const bool isEntryDirty = mem.takeDirtyTileMapEntry(mapEntry);
+        const int bank = (_useAttributes && isMaskSet(attributes[mapEntry], 0x08)) ? 1 : 0;
+        if (_needsFullUpdate || isEntryDirty || dirtyTiles[bank][_TileIndex(codes[mapEntry], _signedMode)]) {
+            _drawEntry(mem, tileCache, mapEntry / MapEntryCount, mapEntry % MapEntryCount);
+        }
+    }
+    _needsFullUpdate = false;
+}
+
+void BackgroundLayer::_drawEntry(MemoryController &mem, TileCache &tileCache, int map, uint16_t entry) {
+    const uint16_t mapEntry = (map * MapEntryCount) + entry;
+    const uint8_t code = mem.videoRAMBank(0)[TileMapOffset + mapEntry];
+    const TileAttributes attributes = TileAttributes(_useAttributes ? mem.videoRAMBank(1)[TileMapOffset + mapEntry] : 0);
+    const uint16_t tileAddress = 0x8000 + (_TileIndex(code, _signedMode) * 16);
+    const uint8_t indexBits = (attributes.colorPaletteIndex << PaletteNumberShift) | (attributes.priorityToBG ? PriorityMask : 0);
+    
+    const size_t x = (entry % TileMapEntriesPerRow) * TileSize;
+    const size_t y = (entry / TileMapEntriesPerRow) * TileSize;
+    uint8_t *dest = _indices[map].data() + (y * Size) + x;
+    for (uint8_t row = 0; row < TileSize; ++row, dest += Size) {
+        const uint8_t tileRow = attributes.flipY ? TileSize - row - 1 : row;
+        uint16_t rowCodes = tileCache.tileRow(mem, attributes.characterBank, tileAddress, tileRow, attributes.flipX);
+        for (uint8_t col = 0; col < TileSize; ++col, rowCodes >>= 2) {
+            dest[col] = (rowCodes & 0x3) | indexBits;
+        }
+    }
+}
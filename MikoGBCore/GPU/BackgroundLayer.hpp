@@ -0,0 +1,53 @@
+//
+//  BackgroundLayer.hpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#ifndef BackgroundLayer_hpp
+#define BackgroundLayer_hpp
+
+#include "MemoryController.hpp"
+#include "TileCache.hpp"
+#include <vector>
+
+namespace MikoGB {
+
+/// Both background tile maps (0x9800 and 0x9C00) drawn out in full as 256x256 images of color indices, so that a
+/// background line is a copy from (SCX, SCY + LY) rather than a tile at a time. Each index is a 2-bit palette code, the
+/// CGB palette number in bits 2-4 and BG priority in bit 7, so palettes are applied per line and can change freely.
+/// Entries are only drawn again when their code or attributes are written, or the tile they use is
+class BackgroundLayer {
+public:
+    static const size_t Size = 256;
+    static const uint8_t PaletteNumberShift = 2;
+    static const uint8_t PriorityMask = 0x80;
+    
+    BackgroundLayer();
+    
+    /// Draw whatever changed in VRAM since the last update. signedMode is LCDC bit 4 being clear (tiles from 0x9000 with
+    /// signed codes). Without attributes (DMG rendering), every entry uses bank 0, palette 0 and no flips or priority
+    void update(MemoryController &mem, TileCache &tileCache, bool signedMode, bool useAttributes);
+    
+    /// A row of Size indices of the map at 0x9800 (0) or 0x9C00 (1), as of the last update
+    const uint8_t *row(int map, uint8_t y) const { return _indices[map].data() + (y * Size); }
+    
+    /// Draw everything again on the next update
+    void invalidate() { _needsFullUpdate = true; }
+    
+private:
+    static const uint16_t MapEntryCount = 1024;
+    
+    std::vector<uint8_t> _indices[2];
+    bool _needsFullUpdate = true;
+    bool _signedMode = false;
+    bool _useAttributes = false;
+    uint32_t _vramWriteCount = 0;
+    
+    void _drawEntry(MemoryController &mem, TileCache &tileCache, int map, uint16_t entry);
+};
+
+}
+
+#endif /* BackgroundLayer_hpp */
@@ -12,6 +12,7 @@
 #include "GPUTypes.hpp"
 #include <array>
 #include <cassert>
+#include <cstring>
 
 using namespace MikoGB;
 using namespace std;
@@ -26,9 +27,10 @@ using namespace std;
 // and that V-blank lasts 1.09ms (10 lines). The first matches well to 456 oscillations per line (108.7µs and change)
 // And obviously 10x that is ~1.09ms. All together that means that 154 lines (0-153) would finish 59.7 times per second
 // This is the documented refresh rate of the screen
-// Finally, total cycles are doubled. In normal-speed mode, input cycles are multiplied by 2, so the x2 cancels
-// In double-speed mode, input is not multiplied. This means that twice as many CPU cycles must elapse in double-speed mode
-// which counteracts the fact that the CPU would be running twice as fast and keeps the framerate at "real" time
+// Finally, total cycles are doubled since input is in master cycles (see EventScheduler). In normal-speed mode, there are
+// 2 per CPU cycle, so the x2 cancels. In double-speed mode, there is 1 per CPU cycle. This means that twice as many CPU
+// cycles must elapse in double-speed mode which counteracts the fact that the CPU would be running twice as fast and keeps
+// the framerate at "real" time
 static const size_t CPUCyclesPerScanline = 456 * 2;
 static const size_t LCDScanlineCount = 154; // 0-153. 144-153 are V-Blank
 static const size_t VBlankScanline = 144;
@@ -70,6 +72,7 @@ static const uint16_t BCPSRegister = 0xFF68; // BG palette I/O control register
 static const uint16_t BCPDRegister = 0xFF69; // BG palette data register
 static const uint16_t OCPSRegister = 0xFF6A; // BG palette I/O register
 static const uint16_t OCPDRegister = 0xFF6B; // BG palette data register
+static const uint16_t KEY0Register = 0xFF4C; // Color compatibility mode
 
 static const size_t ScreenWidth = 160; // screen is 160x144
 static const size_t ScreenHeight = 144;
@@ -78,12 +81,12 @@ static const uint8_t BackgroundTileSize = 8; // BG tiles are always 8x8
 static const uint16_t BackgroundTilesPerRow = 32; // BG canvas is 32x32 tiles for 256x256 px
 static const uint16_t BackgroundTileBytes = 16; // BG tiles are 16 bytes, 2bpp
 
-static inline bool _IsLCDOn(const MemoryController::Ptr &mem) {
+static inline bool _IsLCDOn(MemoryController *mem) {
     bool isOn = (mem->readByte(LCDCRegister) & 0x80) == 0x80;
     return isOn;
 }
 
-GPUCore::GPUCore(MemoryController::Ptr &mem): _memoryController(mem), _scanline(ScreenWidth) {
+GPUCore::GPUCore(MemoryController *mem): _memoryController(mem), _scanline(ScreenWidth), _renderedScanlines(ScreenHeight, RenderedScanline { PixelBuffer(ScreenWidth, 1), {}, false }) {
     // ensure color palettes are default initialized
     for (auto &palette : _colorPaletteBG) {
         palette = ColorPalette();
@@ -91,6 +94,39 @@ GPUCore::GPUCore(MemoryController::Ptr &mem): _memoryController(mem), _scanline(
     for (auto &palette : _colorPaletteOBJ) {
         palette = ColorPalette();
     }
+    
+    // Color palettes live here rather than in memory
+    mem->registerIOHandlers(BCPSRegister, OCPDRegister, [this](uint16_t addr) {
+        return colorPaletteRegisterRead(addr);
+    }, [this](uint16_t addr, uint8_t val) {
+        colorPaletteRegisterWrite(addr, val);
+        return val;
+    });
+    mem->registerIOHandlers(KEY0Register, KEY0Register, nullptr, [this](uint16_t, uint8_t val) {
+        colorModeRegisterWrite(val);
+        return val;
+    });
+}
+
+void GPUCore::reset() {
+    _cycleCount = 0;
+    _currentScanline = 0;
+    _currentMode = OAMScan;
+    _wasOn = false;
+    _bgPaletteControl = 0;
+    _objPaletteControl = 0;
+    for (auto &palette : _colorPaletteBG) {
+        palette = ColorPalette();
+    }
+    for (auto &palette : _colorPaletteOBJ) {
+        palette = ColorPalette();
+    }
+    _renderingMode = ColorRenderingMode::DMGOnly;
+    _tileCache.invalidate();
+    _backgroundLayer.invalidate();
+    for (auto &rendered : _renderedScanlines) {
+        rendered.isValid = false;
+    }
 }
 
 // Clear all state as needed when the LCD is disabled
@@ -162,7 +198,7 @@ void GPUCore::_setMode(LCDMode mode) {
     }
 }
 
-void GPUCore::updateWithCPUCycles(size_t cpuCycles) {
+void GPUCore::updateWithMasterCycles(size_t masterCycles) {
     bool isOn = _IsLCDOn(_memoryController);
     if (!isOn) {
         if (_wasOn) {
@@ -173,7 +209,7 @@ void GPUCore::updateWithCPUCycles(size_t cpuCycles) {
             // start mode
             _setMode(OAMScan);
         }
-        _cycleCount += cpuCycles;
+        _cycleCount += masterCycles;
         
         bool done = false;
         while (!done) {
@@ -227,9 +263,32 @@ void GPUCore::updateWithCPUCycles(size_t cpuCycles) {
     _wasOn = isOn;
 }
 
+uint64_t GPUCore::masterCyclesUntilNextEvent() const {
+    if (!_wasOn) {
+        // Nothing happens until the LCD is turned on, which is a register write
+        return EventScheduler::NoEvent;
+    }
+    size_t modeCycles = 0;
+    switch (_currentMode) {
+        case HBlank:
+            modeCycles = HBlankCycles;
+            break;
+        case OAMScan:
+            modeCycles = OAMCycles;
+            break;
+        case LCDTransfer:
+            modeCycles = LCDTransferCycles;
+            break;
+        case VBlank:
+            modeCycles = CPUCyclesPerScanline;
+            break;
+    }
+    return modeCycles - _cycleCount;
+}
+
 #pragma mark - BG Utilities
 
-static void _GetBGTileMapInfo(int32_t &baseAddr, bool &signedMode, uint16_t &codeArea, const MemoryController::Ptr &mem) {
+static void _GetBGTileMapInfo(int32_t &baseAddr, bool &signedMode, uint16_t &codeArea, MemoryController *mem) {
     const uint8_t lcdc = mem->readByte(LCDCRegister);
     // Range of background tiles is either 0x9000 with codes being signed offsets (0x8800-0x97FF)
     // or they start at 0x8000 with codes being unsigned offsets (0x8000-0x8FFF)
@@ -285,6 +344,17 @@ static const Palette _GetOBJPalette(const TileAttributes attrs, const Monochrome
     assert(false);
 }
 
+// The pixels of every BG palette number, 4 at a time, for BackgroundLayer indices. Only CGB rendering uses more than 1
+static void _GetBGPalettePixels(Pixel *palettePixels, const MonochromePalette &monoPalette, const ColorPalette *colorPalettes, GPUCore::ColorRenderingMode renderingMode) {
+    const int paletteCount = renderingMode == GPUCore::ColorRenderingMode::CGBMode ? ColorPaletteCount : 1;
+    for (int i = 0; i < paletteCount; ++i) {
+        const Palette palette = _GetBGPalette(TileAttributes(i), monoPalette, colorPalettes, renderingMode);
+        for (uint8_t code = 0; code < 4; ++code) {
+            palettePixels[(i * 4) + code] = palette.pixelForCode(code);
+        }
+    }
+}
+
 static inline uint8_t _GetPaletteCode(uint8_t byte0, uint8_t byte1, int x) {
     int shift = 8 - x - 1;
     const uint8_t lowBit = (byte0 >> shift) & 0x01;
@@ -293,7 +363,7 @@ static inline uint8_t _GetPaletteCode(uint8_t byte0, uint8_t byte1, int x) {
     return code;
 }
 
-static void _ReadBGTile(uint16_t addr, const MemoryController::Ptr &mem, const Palette &bgPalette, const TileAttributes &attr, PixelBuffer &dest) {
+static void _ReadBGTile(uint16_t addr, MemoryController *mem, const Palette &bgPalette, const TileAttributes &attr, PixelBuffer &dest) {
     assert(dest.width == 8 && dest.height == 8);
     for (uint16_t y = 0; y < 16; y += 2) {
         const uint8_t byte0 = mem->readVRAMByte(addr + y, attr.characterBank);
@@ -363,6 +433,12 @@ void GPUCore::getTileMap(PixelBufferImageCallback callback) {
     callback(tileMap);
 }
 
+void GPUCore::_updateBackgroundLayer() {
+    const bool signedMode = !isMaskSet(_memoryController->readByte(LCDCRegister), 0x10);
+    const bool useAttributes = _renderingMode == ColorRenderingMode::CGBMode;
+    _backgroundLayer.update(*_memoryController, _tileCache, signedMode, useAttributes);
+}
+
 void GPUCore::getBackground(PixelBufferImageCallback callback) {
     PixelBuffer background(BackgroundCanvasSize, BackgroundCanvasSize);
     
@@ -373,45 +449,31 @@ void GPUCore::getBackground(PixelBufferImageCallback callback) {
     const uint8_t bgPaletteByte = _memoryController->readByte(BGPRegister);
     MonochromePalette monoPalette = MonochromePalette(bgPaletteByte);
     
-    const bool isCGBRendering = _renderingMode == ColorRenderingMode::CGBMode;
-    const uint16_t NumberOfBGCodes = 1024; //1024: 32x32 tiles form the background
-    PixelBuffer tileBuffer(8, 8);
-    for (uint16_t i = 0; i < NumberOfBGCodes; ++i) {
-        const uint16_t tileCodeAddr = bgCodeArea + i;
-        const uint8_t code = _memoryController->readVRAMByte(tileCodeAddr, 0);
-        const uint8_t attrByte = isCGBRendering ? _memoryController->readVRAMByte(tileCodeAddr, 1) : 0;
-        const uint16_t tileBaseAddress = _GetBGTileBaseAddress(bgTileMapBase, code, signedMode);
-        const TileAttributes bgAttributes = TileAttributes(attrByte);
-        const Palette finalPalette = _GetBGPalette(bgAttributes, monoPalette, _colorPaletteBG, _renderingMode);
-        const size_t tileX = i % BackgroundTilesPerRow;
-        const size_t tileY = i / BackgroundTilesPerRow;
-        const size_t pixelX = tileX * BackgroundTileSize;
-        const size_t pixelY = tileY * BackgroundTileSize;
-        _ReadBGTile(tileBaseAddress, _memoryController, finalPalette, bgAttributes, tileBuffer);
-        _DrawPixelBufferToBuffer(tileBuffer, background, pixelX, pixelY);
+    // Catch up the layer even if it isn't used for rendering, it only draws what changed
+    _updateBackgroundLayer();
+    Pixel palettePixels[ColorPaletteCount * 4];
+    _GetBGPalettePixels(palettePixels, monoPalette, _colorPaletteBG, _renderingMode);
+    const int map = bgCodeArea == 0x9800 ? 0 : 1;
+    for (size_t y = 0; y < BackgroundCanvasSize; ++y) {
+        const uint8_t *indices = _backgroundLayer.row(map, y);
+        for (size_t x = 0; x < BackgroundCanvasSize; ++x) {
+            background.pixels[background.indexOf(x, y)] = palettePixels[indices[x] & 0x1F];
+        }
     }
     
     callback(background);
 }
 
-static uint8_t _DrawTileRowToScanline(uint16_t tileAddress, uint8_t tileRow, uint8_t tileCol, const TileAttributes &attributes, LCDScanline::WriteType writeType, uint8_t scanlinePos, LCDScanline &scanline, const MemoryController::Ptr &mem, const Palette &palette) {
-    // the 2 bytes representing the given row in the tile
-    const uint16_t tileRowOffset = tileRow * 2; // 2 bytes per row
-    const uint8_t byte0 = mem->readVRAMByte(tileAddress + tileRowOffset, attributes.characterBank);
-    const uint8_t byte1 = mem->readVRAMByte(tileAddress + tileRowOffset + 1, attributes.characterBank);
-    int x = tileCol;
-    uint8_t currentIdx = scanlinePos;
+static uint8_t _DrawTileRowToScanline(uint16_t tileAddress, uint8_t tileRow, uint8_t tileCol, const TileAttributes &attributes, LCDScanline::WriteType writeType, uint8_t scanlinePos, LCDScanline &scanline, MemoryController *mem, TileCache &tileCache, const Palette &palette) {
     // Draw until the end of the tile or the end of the scanline
     const size_t width = scanline.getWidth();
-    while (currentIdx < width && x < BackgroundTileSize) {
-        const int adjustedX = attributes.flipX ? BackgroundTileSize - x - 1 : x;
-        const uint8_t code = _GetPaletteCode(byte0, byte1, adjustedX);
-        scanline.writePixel(currentIdx, code, palette, writeType);
-        ++currentIdx;
-        ++x;
+    if (scanlinePos >= width) {
+        return 0;
     }
-    
-    return currentIdx - scanlinePos;
+    const uint16_t codes = tileCache.tileRow(*mem, attributes.characterBank, tileAddress, tileRow, attributes.flipX);
+    const size_t count = min<size_t>(BackgroundTileSize - tileCol, width - scanlinePos);
+    scanline.writeTileRow(scanlinePos, codes >> (2 * tileCol), count, palette, writeType);
+    return count;
 }
 
 void GPUCore::_renderBackgroundToScanline(size_t lineNum, LCDScanline &scanline) {
@@ -436,20 +498,32 @@ void GPUCore::_renderBackgroundToScanline(size_t lineNum, LCDScanline &scanline)
     
     // 2. Figure out what row of tile codes we need to draw and which row of those tiles is relevant
     const uint8_t bgY = (lineNum + scy) & 0xFF; // wrap around
+    if (_backgroundLayerEnabled) {
+        // The line is already drawn out in the layer, just copy it. The screen can wrap around the right edge
+        _updateBackgroundLayer();
+        Pixel palettePixels[ColorPaletteCount * 4];
+        _GetBGPalettePixels(palettePixels, bgPalette, _colorPaletteBG, _renderingMode);
+        const uint8_t *indices = _backgroundLayer.row(bgCodeArea == 0x9800 ? 0 : 1, bgY);
+        const size_t firstCount = min<size_t>(ScreenWidth, BackgroundCanvasSize - scx);
+        scanline.writeBackgroundIndices(0, indices + scx, firstCount, palettePixels);
+        scanline.writeBackgroundIndices(firstCount, indices, ScreenWidth - firstCount, palettePixels);
+        return;
+    }
     const uint8_t bgTileY = bgY / 8;
     const uint8_t tileRow = bgY % 8; // the row in the 8x8 tile that is on this line
     
     // 3. Main loop, draw background tiles progressively to the scanline
+    const uint8_t *tileCodes = _memoryController->videoRAMBank(0) + (bgCodeArea - TileMapBase) + (bgTileY * BackgroundTilesPerRow);
+    const uint8_t *tileAttrs = _memoryController->videoRAMBank(1) + (bgCodeArea - TileMapBase) + (bgTileY * BackgroundTilesPerRow);
     uint8_t pixelsDrawn = 0;
     while (pixelsDrawn < ScreenWidth) {
         // 3a. Figure out the next tile to draw, determine it's code from the code area, then it's address in the map
         const uint8_t bgX = (pixelsDrawn + scx) & 0xFF;
         const uint8_t bgTileX = bgX / 8;
-        const uint16_t tileCodeAddress = bgCodeArea + (bgTileY * BackgroundTilesPerRow) + bgTileX;
-        const uint8_t tileCode = _memoryController->readVRAMByte(tileCodeAddress, 0);
+        const uint8_t tileCode = tileCodes[bgTileX];
         const uint16_t tileBaseAddress = _GetBGTileBaseAddress(bgTileMapBase, tileCode, signedMode);
         
-        const uint8_t tileAttr = isCGBRendering ? _memoryController->readVRAMByte(tileCodeAddress, 1) : 0;
+        const uint8_t tileAttr = isCGBRendering ? tileAttrs[bgTileX] : 0;
         const TileAttributes bgAttributes = TileAttributes(tileAttr);
         const uint8_t adjustedRow = bgAttributes.flipY ? BackgroundTileSize - tileRow - 1 : tileRow;
         const LCDScanline::WriteType writeType = bgAttributes.priorityToBG ? LCDScanline::WriteType::BackgroundPrioritizeBG : LCDScanline::WriteType::BackgroundDeferToObj;
@@ -457,7 +531,7 @@ void GPUCore::_renderBackgroundToScanline(size_t lineNum, LCDScanline &scanline)
         
         // 3b. Now draw the line from the tile to the scanline using the helper
         const uint8_t tileCol = bgX % 8; // for all but the first tile, this should be 0
-        pixelsDrawn += _DrawTileRowToScanline(tileBaseAddress, adjustedRow, tileCol, bgAttributes, writeType, pixelsDrawn, scanline, _memoryController, finalPalette);
+        pixelsDrawn += _DrawTileRowToScanline(tileBaseAddress, adjustedRow, tileCol, bgAttributes, writeType, pixelsDrawn, scanline, _memoryController, _tileCache, finalPalette);
     }
 #if DEBUG
     assert(pixelsDrawn == 160);
@@ -466,7 +540,7 @@ void GPUCore::_renderBackgroundToScanline(size_t lineNum, LCDScanline &scanline)
 
 #pragma mark - Window Utilities
 
-static bool _windowStatus(int32_t &baseAddr, bool &signedMode, uint16_t &codeArea, const MemoryController::Ptr &mem) {
+static bool _windowStatus(int32_t &baseAddr, bool &signedMode, uint16_t &codeArea, MemoryController *mem) {
     const uint8_t lcdc = mem->readByte(LCDCRegister);
     bool windowEnabled = isMaskSet(lcdc, 0x20);
     // Range of background tiles is either 0x9000 with codes being signed offsets (0x8800-0x97FF)
@@ -517,15 +591,16 @@ void GPUCore::_renderWindowToScanline(size_t lineNum, LCDScanline &scanline) {
     uint8_t windowPosition = wx < 7 ? 7 - wx : 0;
     
     const bool isCGBRendering = _renderingMode == ColorRenderingMode::CGBMode;
+    const uint8_t *tileCodes = _memoryController->videoRAMBank(0) + (winCodeArea - TileMapBase) + (bgTileY * BackgroundTilesPerRow);
+    const uint8_t *tileAttrs = _memoryController->videoRAMBank(1) + (winCodeArea - TileMapBase) + (bgTileY * BackgroundTilesPerRow);
     while (screenPosition < ScreenWidth) {
         // 3a. Figure out the next tile to draw, determine its code from the code area, then its address in the map
         const uint8_t winX = windowPosition;
         const uint8_t bgTileX = winX / 8;
-        const uint16_t tileCodeAddress = winCodeArea + (bgTileY * BackgroundTilesPerRow) + bgTileX;
-        const uint8_t tileCode = _memoryController->readVRAMByte(tileCodeAddress, 0);
+        const uint8_t tileCode = tileCodes[bgTileX];
         const uint16_t tileBaseAddress = _GetBGTileBaseAddress(bgTileMapBase, tileCode, signedMode);
         
-        const uint8_t tileAttr = isCGBRendering ? _memoryController->readVRAMByte(tileCodeAddress, 1) : 0;
+        const uint8_t tileAttr = isCGBRendering ? tileAttrs[bgTileX] : 0;
         const TileAttributes winAttributes = TileAttributes(tileAttr);
         const uint8_t adjustedRow = winAttributes.flipY ? BackgroundTileSize - tileRow - 1 : tileRow;
         const LCDScanline::WriteType writeType = winAttributes.priorityToBG ? LCDScanline::WriteType::WindowPrioritizeBG : LCDScanline::WriteType::WindowDeferToObj;
@@ -533,7 +608,7 @@ void GPUCore::_renderWindowToScanline(size_t lineNum, LCDScanline &scanline) {
         
         // 3b. Now draw the line from the tile to the scanline using the helper
         const uint8_t tileCol = windowPosition % 8;
-        const uint8_t pixelsDrawn = _DrawTileRowToScanline(tileBaseAddress, adjustedRow, tileCol, winAttributes, writeType, screenPosition, scanline, _memoryController, finalPalette);
+        const uint8_t pixelsDrawn = _DrawTileRowToScanline(tileBaseAddress, adjustedRow, tileCol, winAttributes, writeType, screenPosition, scanline, _memoryController, _tileCache, finalPalette);
         screenPosition += pixelsDrawn;
         windowPosition += pixelsDrawn;
     }
@@ -658,27 +733,58 @@ void GPUCore::_renderSpritesToScanline(size_t line, LCDScanline &scanline) {
         const uint8_t attrByte = _memoryController->readByte(codeBase + 3);
         const TileAttributes spriteAttr = TileAttributes(attrByte);
         const LCDScanline::WriteType writeType = spriteAttr.priorityToBG ? LCDScanline::WriteType::ObjectLow : LCDScanline::WriteType::ObjectHigh;
-
+        
         const uint16_t tileBaseAddr = TileMapBase + (chrCode * BackgroundTileBytes);
         const uint8_t tileRow = currentSpriteLine - spriteY;
         const uint8_t adjustedRow = spriteAttr.flipY ? spriteHeight - tileRow - 1 : tileRow;
         const uint8_t tileCol = spriteX < spriteWidth ? spriteWidth - spriteX : 0;
         const uint8_t scanlinePos = spriteX >= spriteWidth ? spriteX - spriteWidth : 0;
         const Palette finalPalette = _GetOBJPalette(spriteAttr, monoPalettes, _colorPaletteOBJ, _renderingMode);
-        _DrawTileRowToScanline(tileBaseAddr, adjustedRow, tileCol, spriteAttr, writeType, scanlinePos, scanline, _memoryController, finalPalette);
+        _DrawTileRowToScanline(tileBaseAddr, adjustedRow, tileCol, spriteAttr, writeType, scanlinePos, scanline, _memoryController, _tileCache, finalPalette);
     }
     
 }
 
+bool GPUCore::ScanlineSignature::operator==(const ScanlineSignature &other) const {
+    return memcmp(registers, other.registers, sizeof(registers)) == 0 && renderingMode == other.renderingMode && vramWriteCount == other.vramWriteCount && oamWriteCount == other.oamWriteCount && paletteWriteCount == other.paletteWriteCount;
+}
+
+GPUCore::ScanlineSignature GPUCore::_currentScanlineSignature() {
+    ScanlineSignature signature;
+    const uint16_t registers[] = { LCDCRegister, SCYRegister, SCXRegister, BGPRegister, OBP0Register, OBP1Register, WYRegister, WXRegister };
+    static_assert(sizeof(registers) / sizeof(registers[0]) == sizeof(signature.registers), "Every register has a place in the signature");
+    for (size_t i = 0; i < sizeof(signature.registers); ++i) {
+        signature.registers[i] = _memoryController->readByte(registers[i]);
+    }
+    signature.renderingMode = _renderingMode;
+    signature.vramWriteCount = _memoryController->getVRAMWriteCount();
+    signature.oamWriteCount = _memoryController->getOAMWriteCount();
+    signature.paletteWriteCount = _paletteWriteCount;
+    return signature;
+}
+
 void GPUCore::_renderScanline(size_t lineNum) {
-    _scanline.clear();
-    _renderBackgroundToScanline(lineNum, _scanline);
-    _renderWindowToScanline(lineNum, _scanline);
-    _renderSpritesToScanline(lineNum, _scanline);
+    // Most lines come out the same as in the previous frame. Only render them again if something they depend on changed
+    const ScanlineSignature signature = _currentScanlineSignature();
+    RenderedScanline &rendered = _renderedScanlines[lineNum];
+    _isScanlineUnchanged = rendered.isValid && rendered.signature == signature;
+    if (_isScanlineUnchanged) {
+        _scanlineCounters.reusedCount += 1;
+    } else {
+        _scanline.clear();
+        _renderBackgroundToScanline(lineNum, _scanline);
+        _renderWindowToScanline(lineNum, _scanline);
+        _renderSpritesToScanline(lineNum, _scanline);
+        rendered.pixels.pixels = _scanline.getCompositedPixelData().pixels;
+        rendered.signature = signature;
+        rendered.isValid = true;
+        _scanlineCounters.renderedCount += 1;
+    }
     
     if (_scanlineCallback) {
-        _scanlineCallback(_scanline.getCompositedPixelData(), lineNum);
+        _scanlineCallback(rendered.pixels, lineNum);
     }
+    _isScanlineUnchanged = false;
 }
 
 #pragma mark - Color Palette Management
@@ -711,12 +817,14 @@ void GPUCore::colorPaletteRegisterWrite(uint16_t addr, uint8_t val) {
     } else if (addr == BCPDRegister) {
         const int index = _paletteControlIndex(_bgPaletteControl);
         _colorPaletteBG[index].paletteDataWrite(_bgPaletteControl, val);
+        ++_paletteWriteCount;
         _bgPaletteControl = _incrementedPaletteControlRegister(_bgPaletteControl);
     } else if (addr == OCPSRegister) {
         _objPaletteControl = val; // mask out bit 6 so it's always 0
     } else if (addr == OCPDRegister) {
         const int index = _paletteControlIndex(_objPaletteControl);
         _colorPaletteOBJ[index].paletteDataWrite(_objPaletteControl, val);
+        ++_paletteWriteCount;
         _objPaletteControl = _incrementedPaletteControlRegister(_objPaletteControl);
     } else {
         // Should be unreachable except by client error
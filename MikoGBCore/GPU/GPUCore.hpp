@@ -13,6 +13,8 @@
 #include "MemoryController.hpp"
 #include "LCDScanline.hpp"
 #include "ColorPalette.hpp"
+#include "TileCache.hpp"
+#include "BackgroundLayer.hpp"
 
 #define ColorPaletteCount 8
 
@@ -20,16 +22,22 @@ namespace MikoGB {
 
 class GPUCore {
 public:
-    GPUCore(MemoryController::Ptr &);
+    GPUCore(MemoryController *);
     using Ptr = std::shared_ptr<GPUCore>;
     
-    /// Expects CPU oscillation cycles (~4.2MHz, 4 per instruction cycle)
-    void updateWithCPUCycles(size_t cpuCycles);
+    /// Expects master clock cycles (~8.4MHz, see EventScheduler) so that the frame rate doesn't change with CPU speed
+    void updateWithMasterCycles(size_t masterCycles);
+    
+    /// Master cycles until the next mode change, or EventScheduler::NoEvent while the LCD is off
+    uint64_t masterCyclesUntilNextEvent() const;
     
     void setScanlineCallback(PixelBufferScanlineCallback callback) {
         _scanlineCallback = callback;
     }
     
+    /// Return to power-on state in DMG rendering mode. The scanline callback is kept
+    void reset();
+    
     uint8_t getCurrentScanline() {
         return _currentScanline;
     }
@@ -44,6 +52,18 @@ public:
     void colorPaletteRegisterWrite(uint16_t addr, uint8_t val);
     uint8_t colorPaletteRegisterRead(uint16_t addr) const;
     
+    /// How often drawn tile rows were already decoded. See TileCache
+    const TileCacheCounters &getTileCacheCounters() const { return _tileCache.counters(); }
+    
+    /// How many lines were rendered and how many were the same as in the previous frame. See _renderScanline()
+    const ScanlineCounters &getScanlineCounters() const { return _scanlineCounters; }
+    /// True while the scanline callback is given a line that is the same as the one it was given in the previous frame
+    bool isScanlineUnchanged() const { return _isScanlineUnchanged; }
+    
+    /// When enabled, background lines are copied out of a BackgroundLayer rather than drawn a tile at a time
+    void setBackgroundLayerEnabled(bool enabled) { _backgroundLayerEnabled = enabled; }
+    bool isBackgroundLayerEnabled() const { return _backgroundLayerEnabled; }
+    
     /// Debug utilities
     void getTileMap(PixelBufferImageCallback callback);
     void getBackground(PixelBufferImageCallback callback);
@@ -57,7 +77,7 @@ private:
         LCDTransfer = 3,
     };
     
-    MemoryController::Ptr &_memoryController;
+    MemoryController *const _memoryController;
     size_t _cycleCount = 0;
     uint8_t _currentScanline = 0;
     void _incrementScanline();
@@ -69,7 +89,33 @@ private:
     void _turnOff();
     
     LCDScanline _scanline;
+    TileCache _tileCache;
+    BackgroundLayer _backgroundLayer;
+    bool _backgroundLayerEnabled = false;
+    void _updateBackgroundLayer();
     void _renderScanline(size_t line);
+    
+    /// Everything a rendered line depends on besides its number: registers, rendering mode and counters that change
+    /// with each write to VRAM, OAM and the color palettes
+    struct ScanlineSignature {
+        uint8_t registers[8];
+        ColorRenderingMode renderingMode;
+        uint32_t vramWriteCount;
+        uint32_t oamWriteCount;
+        uint32_t paletteWriteCount;
+        bool operator==(const ScanlineSignature &other) const;
+    };
+    ScanlineSignature _currentScanlineSignature();
+    struct RenderedScanline {
+        PixelBuffer pixels;
+        ScanlineSignature signature;
+        bool isValid;
+    };
+    std::vector<RenderedScanline> _renderedScanlines; // for each line, as last rendered
+    ScanlineCounters _scanlineCounters;
+    bool _isScanlineUnchanged = false;
+    uint32_t _paletteWriteCount = 0;
+    
     void _renderBackgroundToScanline(size_t line, LCDScanline &scanline);
     void _renderWindowToScanline(size_t line, LCDScanline &scanline);
     void _renderSpritesToScanline(size_t line, LCDScanline &scanline);
@@ -0,0 +1,90 @@
+//
+//  LCDScanline.cpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#include "LCDScanline.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace MikoGB;
+
+// The object pixel wins if there is no background pixel, or if it isn't transparent and the background either is
+// transparent or deferred to a high priority object. Otherwise the background wins, even if transparent
+// With Undefined < Transparent < Low < High, that's
+// obj != Undefined && (bg == Undefined || (obj > Transparent && (bg == Transparent || (bg == Low && obj == High))))
+void LCDScanline::_ComputeObjectMask(const InternalPriority *objPriority, const InternalPriority *bgPriority, uint8_t *mask, size_t count) {
+    const uint8_t *obj = reinterpret_cast<const uint8_t *>(objPriority);
+    const uint8_t *bg = reinterpret_cast<const uint8_t *>(bgPriority);
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i undefined = _mm256_set1_epi8((char)InternalPriority::Undefined);
+    const __m256i transparent = _mm256_set1_epi8((char)InternalPriority::Transparent);
+    const __m256i low = _mm256_set1_epi8((char)InternalPriority::Low);
+    const __m256i high = _mm256_set1_epi8((char)InternalPriority::High);
+    for (; i + 32 <= count; i += 32) {
+        const __m256i o = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(obj + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bg + i));
+        const __m256i bgDefers = _mm256_or_si256(_mm256_cmpeq_epi8(b, transparent), _mm256_and_si256(_mm256_cmpeq_epi8(b, low), _mm256_cmpeq_epi8(o, high)));
+        const __m256i objOverBG = _mm256_and_si256(_mm256_cmpgt_epi8(o, transparent), bgDefers);
+        const __m256i objWins = _mm256_andnot_si256(_mm256_cmpeq_epi8(o, undefined), _mm256_or_si256(_mm256_cmpeq_epi8(b, undefined), objOverBG));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(mask + i), objWins);
+    }
+#elif defined(__SSE2__)
+    const __m128i undefined = _mm_set1_epi8((char)InternalPriority::Undefined);
+    const __m128i transparent = _mm_set1_epi8((char)InternalPriority::Transparent);
+    const __m128i low = _mm_set1_epi8((char)InternalPriority::Low);
+    const __m128i high = _mm_set1_epi8((char)InternalPriority::High);
+    for (; i + 16 <= count; i += 16) {
+        const __m128i o = _mm_loadu_si128(reinterpret_cast<const __m128i *>(obj + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bg + i));
+        const __m128i bgDefers = _mm_or_si128(_mm_cmpeq_epi8(b, transparent), _mm_and_si128(_mm_cmpeq_epi8(b, low), _mm_cmpeq_epi8(o, high)));
+        const __m128i objOverBG = _mm_and_si128(_mm_cmpgt_epi8(o, transparent), bgDefers);
+        const __m128i objWins = _mm_andnot_si128(_mm_cmpeq_epi8(o, undefined), _mm_or_si128(_mm_cmpeq_epi8(b, undefined), objOverBG));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(mask + i), objWins);
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t undefined = vdupq_n_u8((uint8_t)InternalPriority::Undefined);
+    const uint8x16_t transparent = vdupq_n_u8((uint8_t)InternalPriority::Transparent);
+    const uint8x16_t low = vdupq_n_u8((uint8_t)InternalPriority::Low);
+    const uint8x16_t high = vdupq_n_u8((uint8_t)InternalPriority::High);
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t o = vld1q_u8(obj + i);
+        const uint8x16_t b = vld1q_u8(bg + i);
+        const uint8x16_t bgDefers = vorrq_u8(vceqq_u8(b, transparent), vandq_u8(vceqq_u8(b, low), vceqq_u8(o, high)));
+        const uint8x16_t objOverBG = vandq_u8(vcgtq_u8(o, transparent), bgDefers);
+        const uint8x16_t objWins = vbicq_u8(vorrq_u8(vceqq_u8(b, undefined), objOverBG), vceqq_u8(o, undefined));
+        vst1q_u8(mask + i, objWins);
+    }
+#endif
+    // Scalar for the rest, or everything without vector instructions
+    for (; i < count; ++i) {
+        const InternalPriority o = objPriority[i];
+        const InternalPriority b = bgPriority[i];
+        const bool bgDefers = b == InternalPriority::Transparent || (b == InternalPriority::Low && o == InternalPriority::High);
+        const bool objOverBG = o > InternalPriority::Transparent && bgDefers;
+        const bool objWins = o != InternalPriority::Undefined && (b == InternalPriority::Undefined || objOverBG);
+        mask[i] = objWins ? 0xFF : 0x00;
+    }
+}
+
+const PixelBuffer &LCDScanline::getCompositedPixelData() {
+    const size_t width = getWidth();
+    _ComputeObjectMask(_objPriority.data(), _bgPriority.data(), _objMask.data(), width);
+    
+    const Pixel *layers[2] = { _bgPixelData.pixels.data(), _objPixelData.pixels.data() };
+    Pixel *pixels = _pixelData.pixels.data();
+    for (size_t i = 0; i < width; ++i) {
+        pixels[i] = layers[_objMask[i] & 0x1][i];
+    }
+    
+    return _pixelData;
+}
@@ -15,7 +15,7 @@
 namespace MikoGB {
 
 struct LCDScanline {
-    LCDScanline(size_t width) : _pixelData(width, 1), _bgPixelData(width, 1), _bgPriority(width, InternalPriority::Undefined), _objPixelData(width, 1), _objPriority(width, InternalPriority::Undefined) {}
+    LCDScanline(size_t width) : _pixelData(width, 1), _bgPixelData(width, 1), _bgPriority(width, InternalPriority::Undefined), _objPixelData(width, 1), _objPriority(width, InternalPriority::Undefined), _objMask(width, 0) {}
     
     size_t getWidth() const { return _pixelData.width; }
     
@@ -47,87 +47,107 @@ struct LCDScanline {
         }
     }
     
-    void writePixel(size_t idx, uint8_t code, const Palette &palette, WriteType writeType) {
-        const Pixel &px = palette.pixelForCode(code);
-        const bool isTransparentPixel = (code & 0x3) == 0;
+    /// Write count (at most 8) pixels starting at idx. codes holds one 2-bit palette code per pixel, starting with the
+    /// lowest 2 bits, as produced by decoding a tile row. The write type and palette are resolved once for the whole run
+    void writeTileRow(size_t idx, uint16_t codes, size_t count, const Palette &palette, WriteType writeType) {
+        const Pixel pixels[4] = {
+            palette.pixelForCode(0),
+            palette.pixelForCode(1),
+            palette.pixelForCode(2),
+            palette.pixelForCode(3),
+        };
+        // Priority for each code. Code 0 is transparent except in the window
+        InternalPriority priorities[4];
+        bool isObject = false;
         switch (writeType) {
             case WriteType::BackgroundDeferToObj:
-                _bgPixelData.pixels[idx] = px;
-                _bgPriority[idx] = isTransparentPixel ? InternalPriority::Transparent : InternalPriority::Low;
+                _SetPriorities(priorities, InternalPriority::Transparent, InternalPriority::Low);
                 break;
             case WriteType::BackgroundPrioritizeBG:
-                _bgPixelData.pixels[idx] = px;
-                _bgPriority[idx] = isTransparentPixel ? InternalPriority::Transparent : InternalPriority::High;
+                _SetPriorities(priorities, InternalPriority::Transparent, InternalPriority::High);
                 break;
             case WriteType::WindowDeferToObj:
-                _bgPixelData.pixels[idx] = px;
-                _bgPriority[idx] = InternalPriority::Low;
+                _SetPriorities(priorities, InternalPriority::Low, InternalPriority::Low);
                 break;
             case WriteType::WindowPrioritizeBG:
-                _bgPixelData.pixels[idx] = px;
-                _bgPriority[idx] = InternalPriority::High;
+                _SetPriorities(priorities, InternalPriority::High, InternalPriority::High);
                 break;
             case WriteType::ObjectLow:
-                if (_objPriority[idx] == InternalPriority::Undefined || !isTransparentPixel) {
-                    _objPixelData.pixels[idx] = px;
-                    _objPriority[idx] = isTransparentPixel ? InternalPriority::Transparent : InternalPriority::Low;
-                }
+                _SetPriorities(priorities, InternalPriority::Transparent, InternalPriority::Low);
+                isObject = true;
                 break;
             case WriteType::ObjectHigh:
-                if (_objPriority[idx] == InternalPriority::Undefined || !isTransparentPixel) {
-                    _objPixelData.pixels[idx] = px;
-                    _objPriority[idx] = isTransparentPixel ? InternalPriority::Transparent : InternalPriority::High;
-                }
+                _SetPriorities(priorities, InternalPriority::Transparent, InternalPriority::High);
+                isObject = true;
                 break;
         }
+        
+        if (!isObject) {
+            Pixel *bgPixels = _bgPixelData.pixels.data() + idx;
+            InternalPriority *bgPriority = _bgPriority.data() + idx;
+            for (size_t i = 0; i < count; ++i, codes >>= 2) {
+                const uint8_t code = codes & 0x3;
+                bgPixels[i] = pixels[code];
+                bgPriority[i] = priorities[code];
+            }
+        } else {
+            // Transparent pixels don't cover other objects
+            Pixel *objPixels = _objPixelData.pixels.data() + idx;
+            InternalPriority *objPriority = _objPriority.data() + idx;
+            for (size_t i = 0; i < count; ++i, codes >>= 2) {
+                const uint8_t code = codes & 0x3;
+                if (code != 0 || objPriority[i] == InternalPriority::Undefined) {
+                    objPixels[i] = pixels[code];
+                    objPriority[i] = priorities[code];
+                }
+            }
+        }
     }
     
-    // See section 2.4 in the GB programmer manual for details on compositing BG and OBJ pixels
-    const PixelBuffer &getCompositedPixelData() {
-        for (int i = 0; i < _pixelData.width; ++i) {
-            InternalPriority objPriority = _objPriority[i];
-            InternalPriority bgPriority = _bgPriority[i];
-            if (objPriority == InternalPriority::Undefined) {
-                _pixelData.pixels[i] = _bgPixelData.pixels[i];
-            } else if (bgPriority == InternalPriority::Undefined) {
-                _pixelData.pixels[i] = _objPixelData.pixels[i];
-            } else if (objPriority == InternalPriority::Transparent) {
-                // if OBJ is transparent, BG always wins, even if transparent
-                _pixelData.pixels[i] = _bgPixelData.pixels[i];
+    /// Write count background pixels starting at idx from a row of BackgroundLayer indices. palettePixels holds the 4
+    /// pixels of each palette number the indices use
+    void writeBackgroundIndices(size_t idx, const uint8_t *indices, size_t count, const Pixel *palettePixels) {
+        Pixel *bgPixels = _bgPixelData.pixels.data() + idx;
+        InternalPriority *bgPriority = _bgPriority.data() + idx;
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t index = indices[i];
+            bgPixels[i] = palettePixels[index & 0x1F];
+            if ((index & 0x3) == 0) {
+                bgPriority[i] = InternalPriority::Transparent;
             } else {
-                if (bgPriority == InternalPriority::Transparent) {
-                    // If the OBJ is non-transparent and the BG is transparent, then OBJ always wins
-                    _pixelData.pixels[i] = _objPixelData.pixels[i];
-                } else if (bgPriority == InternalPriority::High) {
-                    // BG takes priority always if it did not defer to OBJ and neither is transparent
-                    _pixelData.pixels[i] = _bgPixelData.pixels[i];
-                } else {
-                    // Neither is transparent and BG deferred, so use the OBJ priority
-                    if (objPriority == InternalPriority::High) {
-                        _pixelData.pixels[i] = _objPixelData.pixels[i];
-                    } else {
-                        _pixelData.pixels[i] = _bgPixelData.pixels[i];
-                    }
-                }
+                bgPriority[i] = (index & 0x80) ? InternalPriority::High : InternalPriority::Low;
             }
         }
-        
-        return _pixelData;
     }
     
+    /// Combine the background and object layers into the final line. See section 2.4 in the GB programmer manual
+    const PixelBuffer &getCompositedPixelData();
+    
 private:
-    enum class InternalPriority {
+    // Byte-sized and ordered so that compositing can compare 16 pixels at a time. See _ComputeObjectMask()
+    enum class InternalPriority : uint8_t {
         Undefined,
         Transparent,
         Low,
         High
     };
     
+    static void _SetPriorities(InternalPriority *priorities, InternalPriority code0, InternalPriority opaque) {
+        priorities[0] = code0;
+        priorities[1] = opaque;
+        priorities[2] = opaque;
+        priorities[3] = opaque;
+    }
+    
     PixelBuffer _pixelData;
     PixelBuffer _bgPixelData;
     std::vector<InternalPriority> _bgPriority;
     PixelBuffer _objPixelData;
     std::vector<InternalPriority> _objPriority;
+    
+    /// 0xFF where the object pixel wins over the background pixel, 0 where the background wins
+    std::vector<uint8_t> _objMask;
+    static void _ComputeObjectMask(const InternalPriority *objPriority, const InternalPriority *bgPriority, uint8_t *mask, size_t count);
 };
 
 }
@@ -0,0 +1,71 @@
+//
+//  TileCache.cpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#include "TileCache.hpp"
+
+using namespace MikoGB;
+
+static const uint16_t TileDataBaseAddr = 0x8000;
+static const uint16_t TileBytes = 16;
+
+// Tile rows are 2 bitplane bytes with the leftmost pixel in the high bit. Spreading each byte's bits out to every other
+// bit and combining the two gives all 8 2-bit palette codes at once, leftmost in the low 2 bits (see LCDScanline)
+// Flipped spreads put the rightmost pixel first for X-flipped tiles
+struct TileRowSpreadTables {
+    uint16_t spread[256];
+    uint16_t flippedSpread[256];
+};
+
+static constexpr TileRowSpreadTables _BuildTileRowSpreadTables() {
+    TileRowSpreadTables tables = {};
+    for (int byte = 0; byte < 256; ++byte) {
+        for (int x = 0; x < 8; ++x) {
+            const uint16_t bit = (byte >> (7 - x)) & 0x1;
+            tables.spread[byte] |= bit << (2 * x);
+            tables.flippedSpread[byte] |= bit << (2 * (7 - x));
+        }
+    }
+    return tables;
+}
+
+static constexpr TileRowSpreadTables _TileRowSpreadTables = _BuildTileRowSpreadTables();
+
+uint16_t TileCache::tileRow(MemoryController &mem, int bank, uint16_t tileAddress, uint8_t row, bool flipX) {
+    const uint16_t tileIndex = ((tileAddress - TileDataBaseAddr) / TileBytes) + (row / TileRowCount);
+    const uint8_t tileRow = row % TileRowCount;
+    if (mem.takeDirtyTile(MemoryController::TileCacheReader, bank, tileIndex) && _decoded[bank][tileIndex] != 0) {
+        _decoded[bank][tileIndex] = 0;
+        _counters.invalidationCount += 1;
+    }
+    
+    const uint8_t neededMask = flipX ? FlippedMask : DecodedMask;
+    if ((_decoded[bank][tileIndex] & neededMask) == 0) {
+        _decodeTile(mem, bank, tileIndex, flipX);
+        _decoded[bank][tileIndex] |= neededMask;
+        _counters.missCount += 1;
+    } else {
+        _counters.hitCount += 1;
+    }
+    return flipX ? _flippedRows[bank][tileIndex][tileRow] : _rows[bank][tileIndex][tileRow];
+}
+
+void TileCache::_decodeTile(MemoryController &mem, int bank, uint16_t tileIndex, bool flipX) {
+    const uint8_t *tileData = mem.videoRAMBank(bank) + (tileIndex * TileBytes);
+    const uint16_t *spread = flipX ? _TileRowSpreadTables.flippedSpread : _TileRowSpreadTables.spread;
+    uint16_t *rows = flipX ? _flippedRows[bank][tileIndex] : _rows[bank][tileIndex];
+    for (uint8_t row = 0; row < TileRowCount; ++row) {
+        rows[row] = spread[tileData[row * 2]] | (spread[tileData[(row * 2) + 1]] << 1);
+    }
+}
+
+void TileCache::invalidate() {
+    for (auto &bank : _decoded) {
+        for (uint8_t &decoded : bank) {
+            decoded = 0;
+        }
+    }
+}
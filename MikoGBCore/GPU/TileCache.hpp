@@ -0,0 +1,46 @@
+//
+//  TileCache.hpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#ifndef TileCache_hpp
+#define TileCache_hpp
+
+#include "MemoryController.hpp"
+#include "GameBoyCoreTypes.h"
+
+namespace MikoGB {
+
+/// VRAM tiles decoded into rows of 2-bit palette codes, as drawn by LCDScanline::writeTileRow(). Tiles are decoded the
+/// first time they're drawn and again only after the MemoryController reports a write to them. X-flipped rows are
+/// decoded separately, the first time a tile is drawn flipped
+class TileCache {
+public:
+    /// Codes for a row of the tile at tileAddress (0x8000 - 0x97FF) in the bank. Rows past 7 are in the following
+    /// tiles, as for double-height sprites
+    uint16_t tileRow(MemoryController &mem, int bank, uint16_t tileAddress, uint8_t row, bool flipX);
+    
+    /// Drop every decoded tile
+    void invalidate();
+    
+    const TileCacheCounters &counters() const { return _counters; }
+    
+private:
+    static const uint16_t TileCount = MemoryController::VRAMTileCount;
+    static const uint8_t TileRowCount = 8;
+    static const uint8_t DecodedMask = 0x1;
+    static const uint8_t FlippedMask = 0x2;
+    
+    uint16_t _rows[2][TileCount][TileRowCount];
+    uint16_t _flippedRows[2][TileCount][TileRowCount];
+    uint8_t _decoded[2][TileCount] = {}; // DecodedMask and FlippedMask for which of the rows are valid
+    TileCacheCounters _counters;
+    
+    void _decodeTile(MemoryController &mem, int bank, uint16_t tileIndex, bool flipX);
+};
+
+}
+
+#endif /* TileCache_hpp */
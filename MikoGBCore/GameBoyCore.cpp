@@ -7,6 +7,7 @@
 
 #include "GameBoyCore.hpp"
 #include "GameBoyCoreImp.hpp"
+#include <algorithm>
 
 using namespace MikoGB;
 
@@ -23,10 +24,26 @@ bool GameBoyCore::loadROMData(const void *romData, size_t size, const void *colo
     return _imp->loadROMData(romData, size, colorBootROMData, bootRomSize);
 }
 
+bool GameBoyCore::loadROMFile(const char *path, const void *colorBootROMData, size_t bootRomSize) {
+    return _imp->loadROMImage(ROMImage::CreateByMappingFile(path), colorBootROMData, bootRomSize);
+}
+
+bool GameBoyCore::loadROMDataNoCopy(const void *romData, size_t size, const void *colorBootROMData, size_t bootRomSize) {
+    return _imp->loadROMImage(ROMImage::CreateWithUnownedData(romData, size), colorBootROMData, bootRomSize);
+}
+
+bool GameBoyCore::loadROMImage(const ROMImage::Ptr &rom, const void *colorBootROMData, size_t bootRomSize) {
+    return _imp->loadROMImage(rom, colorBootROMData, bootRomSize);
+}
+
 void GameBoyCore::prepTestROM() {
     _imp->prepTestROM();
 }
 
+void GameBoyCore::reset() {
+    _imp->reset();
+}
+
 size_t GameBoyCore::saveDataSize() const {
     return _imp->saveDataSize();
 }
@@ -35,6 +52,18 @@ size_t GameBoyCore::copySaveData(void *buffer, size_t size) const {
     return _imp->copySaveData(buffer, size);
 }
 
+size_t GameBoyCore::copyDirtySaveData(void *buffer, size_t size, std::vector<SaveDataRange> &ranges) {
+    return _imp->copyDirtySaveData(buffer, size, ranges);
+}
+
+bool GameBoyCore::mapSaveFile(const char *path) {
+    return _imp->mapSaveFile(path);
+}
+
+bool GameBoyCore::flushSaveData() {
+    return _imp->flushSaveData();
+}
+
 bool GameBoyCore::loadSaveData(const void *saveData, size_t size) {
     return _imp->loadSaveData(saveData, size);
 }
@@ -91,6 +120,38 @@ void GameBoyCore::setAudioSampleCallback(AudioSampleCallback callback) {
     _imp->setAudioSampleCallback(callback);
 }
 
+void GameBoyCore::setInstructionCacheEnabled(bool enabled) {
+    _imp->_cpu.setInstructionCacheEnabled(enabled);
+}
+
+bool GameBoyCore::isInstructionCacheEnabled() const {
+    return _imp->_cpu.isInstructionCacheEnabled();
+}
+
+void GameBoyCore::setJITEnabled(bool enabled) {
+    _imp->_cpu.setJITEnabled(enabled);
+}
+
+bool GameBoyCore::isJITEnabled() const {
+    return _imp->_cpu.isJITEnabled();
+}
+
+void GameBoyCore::setIdleLoopSkippingEnabled(bool enabled) {
+    _imp->_cpu.setIdleLoopSkippingEnabled(enabled);
+}
+
+bool GameBoyCore::isIdleLoopSkippingEnabled() const {
+    return _imp->_cpu.isIdleLoopSkippingEnabled();
+}
+
+void GameBoyCore::setBackgroundLayerEnabled(bool enabled) {
+    _imp->_gpu.setBackgroundLayerEnabled(enabled);
+}
+
+bool GameBoyCore::isBackgroundLayerEnabled() const {
+    return _imp->_gpu.isBackgroundLayerEnabled();
+}
+
 bool GameBoyCore::isPersistenceStale() const {
     return _imp->isPersistenceStale();
 }
@@ -120,7 +181,7 @@ void GameBoyCore::setSerialEventCallback(SerialEventCallback callback) {
 }
 
 uint16_t GameBoyCore::getPC() const {
-    return _imp->_cpu->programCounter;
+    return _imp->_cpu.programCounter;
 }
 
 void GameBoyCore::getTileMap(PixelBufferImageCallback callback) {
@@ -147,6 +208,30 @@ RegisterState GameBoyCore::getRegisterState() const {
     return _imp->getRegisterState();
 }
 
+std::vector<InstructionBlockProfile> GameBoyCore::getHottestInstructionBlocks(int count) const {
+    return _imp->_cpu.getInstructionCache().hottestBlocks(std::max(count, 0));
+}
+
+InstructionFusionCounters GameBoyCore::getInstructionFusionCounters() const {
+    return _imp->_cpu.fusionCounters;
+}
+
+IdleLoopCounters GameBoyCore::getIdleLoopCounters() const {
+    return _imp->_cpu.getIdleLoopCounters();
+}
+
+TileCacheCounters GameBoyCore::getTileCacheCounters() const {
+    return _imp->_gpu.getTileCacheCounters();
+}
+
+ScanlineCounters GameBoyCore::getScanlineCounters() const {
+    return _imp->_gpu.getScanlineCounters();
+}
+
+bool GameBoyCore::isScanlineUnchanged() const {
+    return _imp->_gpu.isScanlineUnchanged();
+}
+
 uint8_t GameBoyCore::readMem(uint16_t addr) const {
     return _imp->readMem(addr);
 }
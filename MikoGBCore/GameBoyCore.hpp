@@ -9,25 +9,49 @@
 #define GameBoyCore_hpp
 
 #include <cstdlib>
+#include <memory>
 #include "PixelBuffer.hpp"
 #include "GameBoyCoreTypes.h"
 
 namespace MikoGB {
 
 class GameBoyCoreImp;
+class ROMImage;
 
 class GameBoyCore {
 public:
     GameBoyCore();
     ~GameBoyCore();
     
+    // Loading a ROM into a core that has already run replaces the ROM and starts over as if the core were new, apart
+    // from callbacks and breakpoints. Loading again is much cheaper than creating another core
     bool loadROMData(const void *romData, size_t size, const void *colorBootROMData = nullptr, size_t bootRomSize = 0);
+    /// Map the ROM file read-only instead of copying it into memory. Cores loading the same file share its pages
+    bool loadROMFile(const char *path, const void *colorBootROMData = nullptr, size_t bootRomSize = 0);
+    /// Use romData without copying it. The caller must keep it alive and unmodified until this core is destroyed
+    bool loadROMDataNoCopy(const void *romData, size_t size, const void *colorBootROMData = nullptr, size_t bootRomSize = 0);
+    /// Load a ROM image that may be shared with other cores. See ROMImage.hpp
+    bool loadROMImage(const std::shared_ptr<const ROMImage> &rom, const void *colorBootROMData = nullptr, size_t bootRomSize = 0);
     void prepTestROM();
     
+    /// Power cycle, keeping the loaded ROM and color boot ROM. Battery RAM and the clock are cleared, so load them
+    /// again as after loading a ROM. Callbacks and breakpoints are kept
+    void reset();
+    
     // Persisting battery RAM and loading it from saved files
     size_t saveDataSize() const;
     size_t copySaveData(void *buffer, size_t size) const;
+    /// Incremental copySaveData(). buffer holds the previous copy of the save data (or the loaded save data). Only the ranges
+    /// that changed since then are copied into it and appended to ranges, so that only they need to be written out
+    /// Returns the number of bytes copied. Independent of isPersistenceStale() and resetPersistence()
+    size_t copyDirtySaveData(void *buffer, size_t size, std::vector<SaveDataRange> &ranges);
     bool loadSaveData(const void *saveData, size_t size);
+    /// Alternative to copying save data: keep battery RAM (followed by the clock, if any) in the file at path, mapped so
+    /// that the game's writes go straight to the file's pages. Existing save data in the file is loaded, a new file starts
+    /// with the current save data. Call after loading a ROM. The system writes changes back eventually, flushSaveData()
+    /// writes the changed ranges back now. Returns false if the cartridge has no battery or the file can't be mapped
+    bool mapSaveFile(const char *path);
+    bool flushSaveData();
     
     // Persisting real-time clock data and loading it from saved files
     size_t clockDataSize() const;
@@ -60,6 +84,27 @@ public:
     void setScanlineCallback(PixelBufferScanlineCallback callback);
     void setAudioSampleCallback(AudioSampleCallback callback);
     
+    /// Decoded instruction caching for code in ROM. Enabled by default. Disable to fetch and decode every instruction
+    /// as it executes, e.g. to compare behavior
+    void setInstructionCacheEnabled(bool);
+    bool isInstructionCacheEnabled() const;
+    
+    /// Compile hot cached blocks to native code. Disabled by default, and only available on x86-64 hosts without the
+    /// debugger. Emulation is the same either way, only faster. On Linux, compiled code is listed in /tmp/perf-<pid>.map
+    void setJITEnabled(bool);
+    bool isJITEnabled() const;
+    
+    /// Fast-forward through loops that only wait for the GPU or an interrupt, e.g. polling LY or STAT. Disabled by
+    /// default. The CPU observes the same values on the same cycles, but skipped iterations aren't executed, so they
+    /// won't hit breakpoints or appear in instruction history
+    void setIdleLoopSkippingEnabled(bool);
+    bool isIdleLoopSkippingEnabled() const;
+    
+    /// Keep both background tile maps drawn out in full, updated as VRAM changes, and copy each line's background from
+    /// them instead of drawing it a tile at a time. Disabled by default. Helps most with backgrounds that rarely change
+    void setBackgroundLayerEnabled(bool);
+    bool isBackgroundLayerEnabled() const;
+    
     /// Save state management
     bool isPersistenceStale() const;
     void resetPersistence();
@@ -98,6 +143,27 @@ public:
     
     RegisterState getRegisterState() const;
     
+    /// returns up to `count` cached instruction blocks, sorted by the number of times they've been entered
+    std::vector<InstructionBlockProfile> getHottestInstructionBlocks(int count) const;
+    
+    /// how often recognized multi-instruction idioms were executed as a single fused step, and how many cycles of copy
+    /// and fill loops were executed as bulk memory operations (in total and in the last emulated frame)
+    InstructionFusionCounters getInstructionFusionCounters() const;
+    
+    /// how many waiting loops were found and how many cycles were skipped. See setIdleLoopSkippingEnabled()
+    IdleLoopCounters getIdleLoopCounters() const;
+    
+    /// how often drawn tile rows came from already decoded tiles, and how often tiles were decoded or dropped after
+    /// VRAM writes
+    TileCacheCounters getTileCacheCounters() const;
+    
+    /// how many lines were rendered and how many were passed on unchanged from the previous frame
+    ScanlineCounters getScanlineCounters() const;
+    
+    /// True while the scanline callback is given a line that is the same as the one it was given in the previous frame,
+    /// so hosts that keep the last frame around can skip copying it
+    bool isScanlineUnchanged() const;
+    
     uint8_t readMem(uint16_t) const;
     
     bool setLineBreakpoint(int romBank, uint16_t addr);
@@ -11,77 +11,109 @@
 using namespace std;
 using namespace MikoGB;
 
-GameBoyCoreImp::GameBoyCoreImp() {
+GameBoyCoreImp::GameBoyCoreImp():
+    _cpu(&_memoryController),
+    _gpu(&_memoryController),
+    _joypad(&_memoryController),
+    _serialController(&_memoryController) {
     // For now, initialize the CPU core with the bootstrap ROM and valid cartridge logo data
-    _memoryController = make_shared<MemoryController>();
-    _cpu = make_shared<CPUCore>(_memoryController);
-    _gpu = make_shared<GPUCore>(_memoryController);
-    _memoryController->gpu = _gpu;
-    _joypad = make_shared<Joypad>(_memoryController);
-    _memoryController->joypad = _joypad;
-    _serialController = make_shared<SerialController>(_memoryController);
-    _memoryController->serialController = _serialController;
+    _memoryController.gpu = &_gpu;
+    _memoryController.joypad = &_joypad;
+    _memoryController.serialController = &_serialController;
 }
 
 bool GameBoyCoreImp::loadROMData(const void *romData, size_t size, const void *bootRomData, size_t bootRomSize) {
-    // TODO: rather than creating everything in the constructor, (re-)create it on load
-    if (_cpu->programCounter != 0) {
-        // Must not have already started running
-        return false;
+    return loadROMImage(ROMImage::CreateByCopying(romData, size), bootRomData, bootRomSize);
+}
+
+bool GameBoyCoreImp::loadROMImage(const ROMImage::Ptr &rom, const void *bootRomData, size_t bootRomSize) {
+    // Everything is created once in the constructor. Loading over a ROM that already ran starts the machine over
+    _resetComponents();
+    if (rom != _memoryController.getROMImage()) {
+        // Images are immutable, so code decoded from the same one is still valid
+        _cpu.invalidateROMCaches();
     }
-    bool success = _memoryController->configureWithROMData(romData, size);
+    bool success = _memoryController.configureWithROMImage(rom);
     if (bootRomData != nullptr) {
-        success = success && _memoryController->configureWithColorBootROM(bootRomData, bootRomSize);
-        _gpu->enableCGBRendering();
+        success = success && _memoryController.configureWithColorBootROM(bootRomData, bootRomSize);
+        _gpu.enableCGBRendering();
     }
     return success;
 }
 
+void GameBoyCoreImp::reset() {
+    _memoryController.reset();
+    _resetComponents();
+    if (_memoryController.hasColorBootROM()) {
+        _gpu.enableCGBRendering();
+    }
+}
+
+void GameBoyCoreImp::_resetComponents() {
+    _cpu.reset();
+    _gpu.reset();
+    _joypad.reset();
+    _serialController.reset();
+}
+
 void GameBoyCoreImp::prepTestROM() {
-    _memoryController->configureWithEmptyData();
+    _memoryController.configureWithEmptyData();
 }
 
 size_t GameBoyCoreImp::saveDataSize() const {
-    return _memoryController->saveDataSize();
+    return _memoryController.saveDataSize();
 }
 
 size_t GameBoyCoreImp::copySaveData(void *buffer, size_t size) const {
-    return _memoryController->copySaveData(buffer, size);
+    return _memoryController.copySaveData(buffer, size);
+}
+
+size_t GameBoyCoreImp::copyDirtySaveData(void *buffer, size_t size, std::vector<SaveDataRange> &ranges) {
+    return _memoryController.copyDirtySaveData(buffer, size, ranges);
+}
+
+bool GameBoyCoreImp::mapSaveFile(const char *path) {
+    return _memoryController.mapSaveFile(path);
+}
+
+bool GameBoyCoreImp::flushSaveData() {
+    return _memoryController.flushSaveData();
 }
 
 bool GameBoyCoreImp::loadSaveData(const void *saveData, size_t size) {
-    return _memoryController->loadSaveData(saveData, size);
+    return _memoryController.loadSaveData(saveData, size);
 }
 
 size_t GameBoyCoreImp::clockDataSize() const {
-    return _memoryController->clockDataSize();
+    return _memoryController.clockDataSize();
 }
 
 size_t GameBoyCoreImp::copyClockData(void *buffer, size_t size) const {
-    return _memoryController->copyClockData(buffer, size);
+    return _memoryController.copyClockData(buffer, size);
 }
 
 bool GameBoyCoreImp::loadClockData(const void *clockData, size_t size) {
-    return _memoryController->loadClockData(clockData, size);
+    return _memoryController.loadClockData(clockData, size);
 }
 
 void GameBoyCoreImp::step() {
-    int instructionCycles = _cpu->step();
+    int instructionCycles = _cpu.step();
     size_t cpuCycles = instructionCycles * 4;
-    // in double-speed mode, GPU cycles take half as long so that GPU events happen in "real" time
-    const bool isDoubleSpeed = _memoryController->isDoubleSpeedModeEnabled();
-    const size_t cyclesForGPU = isDoubleSpeed ? cpuCycles : cpuCycles * 2;
-    _gpu->updateWithCPUCycles(cyclesForGPU);
-    _memoryController->updateWithCPUCycles(cpuCycles);
+    // Other components only need to be updated when one of their events is due
+    if (_memoryController.scheduler.advance(cpuCycles)) {
+        _memoryController.runDueEvents();
+    }
 #if ENABLE_DEBUGGER
-    if (_cpu->isStoppedAtBreakpoint()) {
+    if (_cpu.isStoppedAtBreakpoint()) {
         setRunnable(false);
     }
 #endif
 }
 
 void GameBoyCoreImp::emulateFrame() {
-    auto gpu = _gpu.get();
+    GPUCore *gpu = &_gpu;
+    InstructionFusionCounters &fusionCounters = _cpu.fusionCounters;
+    const size_t initialAcceleratedCycles = fusionCounters.acceleratedCycles;
     // If we're in the middle of a frame, run until the start of the next
     while (gpu->getCurrentScanline() != 0 && _isRunnable) {
         step();
@@ -91,14 +123,15 @@ void GameBoyCoreImp::emulateFrame() {
     while (gpu->getCurrentScanline() < 144 && _isRunnable) {
         step();
     }
+    fusionCounters.acceleratedCyclesLastFrame = fusionCounters.acceleratedCycles - initialAcceleratedCycles;
 }
 
 void GameBoyCoreImp::updateWithRealTimeSeconds(size_t secondsElapsed) {
-    _memoryController->updateWithRealTimeSeconds(secondsElapsed);
+    _memoryController.updateWithRealTimeSeconds(secondsElapsed);
 }
 
 void GameBoyCoreImp::emulateFrameStep() {
-    auto gpu = _gpu.get();
+    GPUCore *gpu = &_gpu;
     // If we're in the middle of a frame, run until the start of the next
     while (gpu->getCurrentScanline() != 0) {
         step();
@@ -121,55 +154,55 @@ void GameBoyCoreImp::setRunnable(bool runnable) {
 }
 
 void GameBoyCoreImp::setButtonPressed(JoypadButton button, bool set) {
-    _joypad->setButtonPressed(button, set);
+    _joypad.setButtonPressed(button, set);
 }
 
 void GameBoyCoreImp::setScanlineCallback(PixelBufferScanlineCallback callback) {
-    _gpu->setScanlineCallback(callback);
+    _gpu.setScanlineCallback(callback);
 }
 
 void GameBoyCoreImp::setAudioSampleCallback(AudioSampleCallback callback) {
-    _memoryController->setAudioSampleCallback(callback);
+    _memoryController.setAudioSampleCallback(callback);
 }
 
 bool GameBoyCoreImp::isPersistenceStale() const {
-    return _memoryController->isPersistenceStale();
+    return _memoryController.isPersistenceStale();
 }
 
 void GameBoyCoreImp::resetPersistence() {
-    _memoryController->resetPersistence();
+    _memoryController.resetPersistence();
 }
 
 bool GameBoyCoreImp::isClockPersistenceStale() const {
-    return _memoryController->isClockPersistenceStale();
+    return _memoryController.isClockPersistenceStale();
 }
 
 void GameBoyCoreImp::resetClockPersistence() {
-    _memoryController->resetClockPersistence();
+    _memoryController.resetClockPersistence();
 }
 
 uint8_t GameBoyCoreImp::currentSerialDataByte() const {
-    return _serialController->getCurrentDataByte();
+    return _serialController.getCurrentDataByte();
 }
 
 void GameBoyCoreImp::handleIncomingSerialRequest(SerialIncoming incoming, uint8_t payload) {
-    _serialController->handleIncomingEvent(incoming, payload);
+    _serialController.handleIncomingEvent(incoming, payload);
 }
 
 void GameBoyCoreImp::setSerialEventCallback(SerialEventCallback callback) {
-    _serialController->setEventCallback(callback);
+    _serialController.setEventCallback(callback);
 }
 
 void GameBoyCoreImp::getTileMap(PixelBufferImageCallback callback) {
-    _gpu->getTileMap(callback);
+    _gpu.getTileMap(callback);
 }
 
 void GameBoyCoreImp::getBackground(PixelBufferImageCallback callback) {
-    _gpu->getBackground(callback);
+    _gpu.getBackground(callback);
 }
 
 void GameBoyCoreImp::getWindow(PixelBufferImageCallback callback) {
-    _gpu->getWindow(callback);
+    _gpu.getWindow(callback);
 }
 
 Disassembler::Ptr GameBoyCoreImp::_accessDisassembler() {
@@ -181,9 +214,9 @@ Disassembler::Ptr GameBoyCoreImp::_accessDisassembler() {
 
 std::vector<DisassembledInstruction> GameBoyCoreImp::getDisassembledInstructions(int lookAheadCount, int lookBehindCount, size_t *currentIdx) {
     Disassembler::Ptr disassembler = _accessDisassembler();
-    uint16_t pc = _cpu->programCounter;
-    vector<DisassembledInstruction> forward = disassembler->disassembleInstructions(pc, lookAheadCount, _memoryController);
-    vector<DisassembledInstruction> backward = disassembler->precedingDisassembledInstructions(pc, lookBehindCount, _memoryController, _cpu);
+    uint16_t pc = _cpu.programCounter;
+    vector<DisassembledInstruction> forward = disassembler->disassembleInstructions(pc, lookAheadCount, &_memoryController);
+    vector<DisassembledInstruction> backward = disassembler->precedingDisassembledInstructions(pc, lookBehindCount, &_memoryController, &_cpu);
     
     if (currentIdx) {
         *currentIdx = backward.size();
@@ -199,12 +232,12 @@ std::vector<DisassembledInstruction> GameBoyCoreImp::getDisassembledInstructions
 
 std::vector<DisassembledInstruction> GameBoyCoreImp::getDisassembledPreviousInstructions(int count) {
     Disassembler::Ptr disassembler = _accessDisassembler();
-    vector<DisassembledInstruction> disassembled = disassembler->lastExecutedInstructions(count, _memoryController, _cpu);
+    vector<DisassembledInstruction> disassembled = disassembler->lastExecutedInstructions(count, &_memoryController, &_cpu);
     return disassembled;
 }
 
 RegisterState GameBoyCoreImp::getRegisterState() const {
-    uint8_t *registers = _cpu->registers;
+    const uint8_t *registers = _cpu.registers;
     RegisterState state;
     state.B = registers[REGISTER_B];
     state.C = registers[REGISTER_C];
@@ -214,7 +247,7 @@ RegisterState GameBoyCoreImp::getRegisterState() const {
     state.L = registers[REGISTER_L];
     state.A = registers[REGISTER_A];
     
-    uint8_t flag = registers[REGISTER_F];
+    uint8_t flag = _cpu.getFlagsRegister();
     state.ZFlag = (flag & FlagBit::Zero) != 0;
     state.NFlag = (flag & FlagBit::N) != 0;
     state.HFlag = (flag & FlagBit::H) != 0;
@@ -223,10 +256,10 @@ RegisterState GameBoyCoreImp::getRegisterState() const {
     return state;
 }
 
-uint8_t GameBoyCoreImp::readMem(uint16_t addr) const {
-    return _memoryController->readByte(addr);
+uint8_t GameBoyCoreImp::readMem(uint16_t addr) {
+    return _memoryController.readByte(addr);
 }
 
 void GameBoyCoreImp::setLineBreakpoint(int romBank, uint16_t addr) {
-    _cpu->_breakpointManager.addLineBreakpoint(romBank, addr);
+    _cpu._breakpointManager.addLineBreakpoint(romBank, addr);
 }
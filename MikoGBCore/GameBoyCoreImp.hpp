@@ -25,9 +25,14 @@ public:
     GameBoyCoreImp();
     
     bool loadROMData(const void *romData, size_t size, const void *bootRomData = nullptr, size_t bootRomSize = 0);
+    bool loadROMImage(const ROMImage::Ptr &rom, const void *bootRomData = nullptr, size_t bootRomSize = 0);
     void prepTestROM();
+    void reset();
     size_t saveDataSize() const;
     size_t copySaveData(void *buffer, size_t size) const;
+    size_t copyDirtySaveData(void *buffer, size_t size, std::vector<SaveDataRange> &ranges);
+    bool mapSaveFile(const char *path);
+    bool flushSaveData();
     bool loadSaveData(const void *saveData, size_t size);
     size_t clockDataSize() const;
     size_t copyClockData(void *buffer, size_t size) const;
@@ -65,17 +70,21 @@ public:
     std::vector<DisassembledInstruction> getDisassembledInstructions(int lookAheadCount, int lookBehindCount, size_t *currentIdx);
     std::vector<DisassembledInstruction> getDisassembledPreviousInstructions(int count);
     RegisterState getRegisterState() const;
-    uint8_t readMem(uint16_t) const;
+    uint8_t readMem(uint16_t);
     void setLineBreakpoint(int romBank, uint16_t addr);
     
 private:
-    CPUCore::Ptr _cpu;
-    GPUCore::Ptr _gpu;
-    MemoryController::Ptr _memoryController;
-    Joypad::Ptr _joypad;
-    SerialController::Ptr _serialController;
+    // The whole machine is held by value in this one allocation. Components reach each other through plain pointers
+    // into it. The memory controller is first since the others register their I/O handlers with it on construction
+    MemoryController _memoryController;
+    CPUCore _cpu;
+    GPUCore _gpu;
+    Joypad _joypad;
+    SerialController _serialController;
     Disassembler::Ptr _disassembler;
     Disassembler::Ptr _accessDisassembler();
+    /// Power-on state for everything but the memory controller, which resets itself when configured
+    void _resetComponents();
     
     bool _isRunnable = false;
     RunnableChangedCallback _runnableChangedCallback;
@@ -32,6 +32,44 @@ struct DisassembledInstruction {
     std::string description;
 };
 
+struct InstructionBlockProfile {
+    int romBank = 0;
+    uint16_t addr = 0;
+    size_t instructionCount = 0;
+    size_t entryCount = 0; // number of times execution jumped (or called, returned, etc) to the start of the block
+};
+
+struct InstructionFusionCounters {
+    size_t fusedCount = 0;      // multi-instruction idioms executed as a single step
+    size_t fallbackCount = 0;   // idioms recognized in code but executed one instruction at a time, e.g. with interrupts enabled
+    size_t bulkLoopCount = 0;   // copy and fill loops executed as native memory operations
+    size_t acceleratedCycles = 0; // CPU cycles covered by bulk loops, rather than by executing each instruction
+    size_t acceleratedCyclesLastFrame = 0; // acceleratedCycles during the most recent emulated frame
+};
+
+struct IdleLoopCounters {
+    size_t detectedLoopCount = 0; // distinct loops found waiting on another component, e.g. polling LY
+    size_t skipCount = 0;       // times emulated time was fast-forwarded through a waiting loop
+    size_t skippedCycles = 0;   // CPU cycles fast-forwarded rather than executed
+};
+
+struct TileCacheCounters {
+    size_t hitCount = 0;        // tile rows drawn from already decoded tiles
+    size_t missCount = 0;       // tiles decoded because they weren't cached (or not in the needed orientation)
+    size_t invalidationCount = 0; // cached tiles dropped because VRAM tile data was written
+};
+
+struct ScanlineCounters {
+    size_t renderedCount = 0;   // lines rendered because something they depend on changed since the previous frame
+    size_t reusedCount = 0;     // lines passed on from the previous frame instead
+};
+
+/// A run of battery RAM that changed, in bytes from the start of the save data
+struct SaveDataRange {
+    size_t offset = 0;
+    size_t size = 0;
+};
+
 struct RegisterState {
     // registers
     uint8_t B;
@@ -72,4 +110,26 @@ using SerialEventCallback = std::function<void(SerialOutgoing, uint8_t)>;
 // - instruction location cache for disassembly
 #define ENABLE_DEBUGGER 0
 
+// toggle to defer computing CPU flags for 8-bit ALU operations until something reads them
+// (conditional branches, PUSH AF, carry-in operations, register state inspection)
+#ifndef ENABLE_LAZY_FLAGS
+#define ENABLE_LAZY_FLAGS 1
+#endif
+
+// toggle to build the JIT that compiles hot blocks of ROM code to native code (see InstructionJIT). It generates
+// x86-64 code, and is left out with the debugger since native blocks run several instructions per step. Cores still
+// start with it disabled, see CPUCore::setJITEnabled()
+#ifndef ENABLE_JIT
+#if defined(__x86_64__) && !defined(_WIN32) && !ENABLE_DEBUGGER
+#define ENABLE_JIT 1
+#else
+#define ENABLE_JIT 0
+#endif
+#endif
+
+// toggle to run every instruction through the JIT in test builds, so that the instruction tests cover generated code
+#ifndef ENABLE_JIT_FOR_TESTING
+#define ENABLE_JIT_FOR_TESTING 0
+#endif
+
 #endif /* GameBoyCoreTypes_h */
@@ -11,6 +11,15 @@
 using namespace std;
 using namespace MikoGB;
 
+static const uint16_t ControllerDataRegister = 0xFF00;
+
+Joypad::Joypad(MemoryController *memoryController): _memoryController(memoryController) {
+    // Writes select which buttons are read, so they're stored as usual
+    memoryController->registerIOHandlers(ControllerDataRegister, ControllerDataRegister, [this](uint16_t) {
+        return readJoypadRegister();
+    }, nullptr);
+}
+
 void Joypad::setButtonPressed(JoypadButton button, bool set) {
     bool wasSet = getButtonPressed(button);
     int bVal = static_cast<int>(button);
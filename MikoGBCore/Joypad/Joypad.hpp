@@ -15,7 +15,7 @@ namespace MikoGB {
 
 class Joypad {
 public:
-    Joypad(MemoryController::Ptr &memoryController): _memoryController(memoryController) {}
+    Joypad(MemoryController *memoryController);
     using Ptr = std::shared_ptr<Joypad>;
     
     void setButtonPressed(JoypadButton, bool);
@@ -23,8 +23,11 @@ public:
     
     uint8_t readJoypadRegister() const;
     
+    /// Release every button
+    void reset() { _setButtons = 0; }
+    
 private:
-    MemoryController::Ptr &_memoryController;
+    MemoryController *const _memoryController;
     uint8_t _setButtons = 0;
 };
 
@@ -68,11 +68,8 @@ MBC1::MBC1(const CartridgeHeader &header) {
     _batteryBackup = header.hasBatteryBackup();
 }
 
-MBC1::~MBC1() {
-    delete [] _ramData;
-}
-
-bool MBC1::configureWithROMData(const void *romData, size_t size) {
+bool MBC1::configureWithROMImage(const ROMImage::Ptr &rom) {
+    const size_t size = rom->size();
     if (_romBankCount == -1 || _ramBankCount == -1) {
         cerr << "Unexpected ROM/RAM configuration for MBC1" << endl;
         return false;
@@ -89,7 +86,7 @@ bool MBC1::configureWithROMData(const void *romData, size_t size) {
         _ramData = new uint8_t[ramSize]();
     }
     
-    return MemoryBankController::configureWithROMData(romData, size);
+    return MemoryBankController::configureWithROMImage(rom);
 }
 
 void MBC1::_updateBankNumbers() {
@@ -146,6 +143,10 @@ uint8_t MBC1::readROM(uint16_t addr) const {
     return _romData[romIdx];
 }
 
+const uint8_t *MBC1::switchableROMData() const {
+    return _romData + (_romBank * ROMBankSize);
+}
+
 static inline size_t _RAMDataIndex(uint16_t addr, int bankNum) {
     const size_t baseIdx = bankNum * RAMBankSize;
     const size_t ramIdx = baseIdx + (addr - SwitchableRAMBaseAddr);
@@ -160,6 +161,13 @@ uint8_t MBC1::readRAM(uint16_t addr) const {
     return _ramData[ramIdx];
 }
 
+const uint8_t *MBC1::switchableRAMData() const {
+    if (!_ramEnabled || _ramBankCount <= 0) {
+        return nullptr;
+    }
+    return _ramData + _RAMDataIndex(SwitchableRAMBaseAddr, _ramBank);
+}
+
 void MBC1::writeRAM(uint16_t addr, uint8_t val) {
     if (!_ramEnabled || _ramBankCount <= 0) {
         return;
@@ -167,7 +175,9 @@ void MBC1::writeRAM(uint16_t addr, uint8_t val) {
     const size_t ramIdx = _RAMDataIndex(addr, _ramBank);
     if (val != _ramData[ramIdx]) {
         _ramData[ramIdx] = val;
-        _isPersistenceStale = _batteryBackup;
+        if (_batteryBackup) {
+            _saveDataDidChange(ramIdx);
+        }
     }
 }
 
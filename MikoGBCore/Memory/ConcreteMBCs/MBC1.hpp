@@ -15,11 +15,12 @@ namespace MikoGB {
 class MBC1 : public MemoryBankController {
 public:
     MBC1(const CartridgeHeader &header);
-    ~MBC1();
     
-    bool configureWithROMData(const void *romData, size_t size) override;
+    bool configureWithROMImage(const ROMImage::Ptr &rom) override;
     uint8_t readROM(uint16_t addr) const override;
+    const uint8_t *switchableROMData() const override;
     uint8_t readRAM(uint16_t addr) const override;
+    const uint8_t *switchableRAMData() const override;
     void writeRAM(uint16_t addr, uint8_t val) override;
     void writeControlCode(uint16_t addr, uint8_t val) override;
     int currentROMBank() const override;
@@ -31,7 +32,6 @@ private:
     int _romBankCount;
     int _ramBankCount;
     bool _ramEnabled = false;
-    uint8_t *_ramData = nullptr;
 
     uint8_t _romBankLower = 1;
     uint8_t _bankNumberUpper = 0;
@@ -57,11 +57,8 @@ MBC3::MBC3(const CartridgeHeader &header) {
     _hasTimer = header.hasTimer();
 }
 
-MBC3::~MBC3() {
-    delete [] _ramData;
-}
-
-bool MBC3::configureWithROMData(const void *romData, size_t size) {
+bool MBC3::configureWithROMImage(const ROMImage::Ptr &rom) {
+    const size_t size = rom->size();
     if (_romBankCount == -1 || _ramBankCount == -1) {
         cerr << "Unexpected ROM/RAM configuration for MBC3" << endl;
         return false;
@@ -78,7 +75,7 @@ bool MBC3::configureWithROMData(const void *romData, size_t size) {
         _ramData = new uint8_t[ramSize]();
     }
     
-    return MemoryBankController::configureWithROMData(romData, size);
+    return MemoryBankController::configureWithROMImage(rom);
 }
 
 void MBC3::_updateBankNumbers() {
@@ -126,6 +123,15 @@ void MBC3::_updateClockCounterFromRegisters(uint8_t *clockRegisters) {
     totalSeconds += (days * 24 * 60 * 60);
     
     _clockCount = totalSeconds;
+    _clockDidChange();
+}
+
+void MBC3::_clockDidChange() {
+    if (_clockStorage) {
+        // Latching only sets bits of the days high register
+        _clockStorage[MBC3Clock::RTC_DH] = 0;
+        _latchClockRegisters(_clockStorage);
+    }
 }
 
 void MBC3::writeControlCode(uint16_t addr, uint8_t val) {
@@ -162,6 +168,10 @@ uint8_t MBC3::readROM(uint16_t addr) const {
     return _romData[romIdx];
 }
 
+const uint8_t *MBC3::switchableROMData() const {
+    return _romData + (_romBank * ROMBankSize);
+}
+
 static inline size_t _RAMDataIndex(uint16_t addr, int bankNum) {
     const size_t baseIdx = bankNum * RAMBankSize;
     const size_t ramIdx = baseIdx + (addr - SwitchableRAMBaseAddr);
@@ -184,6 +194,14 @@ uint8_t MBC3::readRAM(uint16_t addr) const {
     }
 }
 
+const uint8_t *MBC3::switchableRAMData() const {
+    // Clock registers, and banks beyond the cartridge's RAM, go through readRAM()
+    if (!_ramEnabled || _ramBank >= _ramBankCount) {
+        return nullptr;
+    }
+    return _ramData + _RAMDataIndex(SwitchableRAMBaseAddr, _ramBank);
+}
+
 void MBC3::writeRAM(uint16_t addr, uint8_t val) {
     if (!_ramEnabled || _ramBankCount <= 0) {
         return;
@@ -193,7 +211,9 @@ void MBC3::writeRAM(uint16_t addr, uint8_t val) {
         const size_t ramIdx = _RAMDataIndex(addr, _ramBank);
         if (val != _ramData[ramIdx]) {
             _ramData[ramIdx] = val;
-            _isPersistenceStale = _batteryBackup;
+            if (_batteryBackup) {
+                _saveDataDidChange(ramIdx);
+            }
         }
     } else {
         // clock register
@@ -208,6 +228,7 @@ void MBC3::updateClock(size_t secondsElapsed) {
     bool isHalted = isMaskSet(_clockRegisters[MBC3Clock::RTC_DH], 0x40);
     if (!isHalted) {
         _clockCount += secondsElapsed;
+        _clockDidChange();
     }
 }
 
@@ -289,3 +310,8 @@ bool MBC3::loadClockData(const void *clockData, size_t size) {
     _updateClockCounterFromRegisters((uint8_t *)clockData);
     return true;
 }
+
+void MBC3::useClockDataStorage(uint8_t *storage) {
+    _clockStorage = storage;
+    _clockDidChange();
+}
@@ -23,11 +23,12 @@ enum MBC3Clock : int {
 class MBC3 : public MemoryBankController {
 public:
     MBC3(const CartridgeHeader &header);
-    ~MBC3();
     
-    bool configureWithROMData(const void *romData, size_t size) override;
+    bool configureWithROMImage(const ROMImage::Ptr &rom) override;
     uint8_t readROM(uint16_t addr) const override;
+    const uint8_t *switchableROMData() const override;
     uint8_t readRAM(uint16_t addr) const override;
+    const uint8_t *switchableRAMData() const override;
     void writeRAM(uint16_t addr, uint8_t val) override;
     void writeControlCode(uint16_t addr, uint8_t val) override;
     void updateClock(size_t cpuCycles) override;
@@ -38,12 +39,12 @@ public:
     size_t clockDataSize() const override;
     size_t copyClockData(void *buffer, size_t size) const override;
     bool loadClockData(const void *clockData, size_t size) override;
+    void useClockDataStorage(uint8_t *storage) override;
     
 private:
     int _romBankCount;
     int _ramBankCount;
     bool _ramEnabled = false;
-    uint8_t *_ramData = nullptr;
     
     uint8_t _romBankCode = 0;
     uint8_t _ramBankCode = 0;
@@ -55,6 +56,8 @@ private:
     bool _hasTimer = false;
     
     uint8_t _clockRegisters[5];
+    uint8_t *_clockStorage = nullptr; // latched copy of the clock, kept up to date. See useClockDataStorage()
+    void _clockDidChange();
     
     void _updateBankNumbers();
     void _latchClockRegisters(uint8_t *clockRegisters) const;
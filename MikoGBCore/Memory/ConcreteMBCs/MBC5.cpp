@@ -88,11 +88,8 @@ MBC5::MBC5(const CartridgeHeader &header) {
     _hasBatteryBackup = header.hasBatteryBackup();
 }
 
-MBC5::~MBC5() {
-    delete [] _ramData;
-}
-
-bool MBC5::configureWithROMData(const void *romData, size_t size) {
+bool MBC5::configureWithROMImage(const ROMImage::Ptr &rom) {
+    const size_t size = rom->size();
     if (_romBankCount == -1 || _ramBankCount == -1) {
         cerr << "Unexpected ROM/RAM configuration for MBC5" << endl;
         return false;
@@ -109,7 +106,7 @@ bool MBC5::configureWithROMData(const void *romData, size_t size) {
         _ramData = new uint8_t[ramSize]();
     }
     
-    return MemoryBankController::configureWithROMData(romData, size);
+    return MemoryBankController::configureWithROMImage(rom);
 }
 
 void MBC5::_updateBankNumbers() {
@@ -157,6 +154,10 @@ uint8_t MBC5::readROM(uint16_t addr) const {
     return _romData[romIdx];
 }
 
+const uint8_t *MBC5::switchableROMData() const {
+    return _romData + (_romBank * ROMBankSize);
+}
+
 static inline size_t _RAMDataIndex(uint16_t addr, int bankNum) {
     const size_t baseIdx = bankNum * RAMBankSize;
     const size_t ramIdx = baseIdx + (addr - SwitchableRAMBaseAddr);
@@ -171,6 +172,13 @@ uint8_t MBC5::readRAM(uint16_t addr) const {
     return _ramData[ramIdx];
 }
 
+const uint8_t *MBC5::switchableRAMData() const {
+    if (!_ramEnabled || _ramBankCount <= 0) {
+        return nullptr;
+    }
+    return _ramData + _RAMDataIndex(SwitchableRAMBaseAddr, _ramBank);
+}
+
 void MBC5::writeRAM(uint16_t addr, uint8_t val) {
     if (!_ramEnabled || _ramBankCount <= 0) {
         return;
@@ -178,7 +186,9 @@ void MBC5::writeRAM(uint16_t addr, uint8_t val) {
     const size_t ramIdx = _RAMDataIndex(addr, _ramBank);
     if (val != _ramData[ramIdx]) {
         _ramData[ramIdx] = val;
-        _isPersistenceStale = _hasBatteryBackup;
+        if (_hasBatteryBackup) {
+            _saveDataDidChange(ramIdx);
+        }
     }
 }
 
@@ -16,11 +16,12 @@ namespace MikoGB {
 class MBC5 : public MemoryBankController {
 public:
     MBC5(const CartridgeHeader &header);
-    ~MBC5();
     
-    bool configureWithROMData(const void *romData, size_t size) override;
+    bool configureWithROMImage(const ROMImage::Ptr &rom) override;
     uint8_t readROM(uint16_t addr) const override;
+    const uint8_t *switchableROMData() const override;
     uint8_t readRAM(uint16_t addr) const override;
+    const uint8_t *switchableRAMData() const override;
     void writeRAM(uint16_t addr, uint8_t val) override;
     void writeControlCode(uint16_t addr, uint8_t val) override;
     int currentROMBank() const override;
@@ -32,7 +33,6 @@ private:
     int _romBankCount;
     int _ramBankCount;
     bool _ramEnabled = false;
-    uint8_t *_ramData = nullptr;
 
     uint8_t _romBankLower = 1;
     uint8_t _romBankUpper = 0;
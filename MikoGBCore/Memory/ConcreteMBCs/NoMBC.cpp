@@ -16,6 +16,7 @@ static size_t ExpectedDataSize = 1024 * 32; // 32 KiB
 static size_t RAMBankSize = 1024 * 8; // 8 KiB
 static uint16_t RAMBase = 0xA000;
 static uint16_t RAMMax = 0xC000;
+static size_t SwitchableROMBaseAddr = 0x4000;
 
 NoMBC::NoMBC(const CartridgeHeader &header) {
     switch (header.getRAMSize()) {
@@ -31,11 +32,8 @@ NoMBC::NoMBC(const CartridgeHeader &header) {
     }
 }
 
-NoMBC::~NoMBC() {
-    delete [] _ramData;
-}
-
-bool NoMBC::configureWithROMData(const void *romData, size_t size) {
+bool NoMBC::configureWithROMImage(const ROMImage::Ptr &rom) {
+    const size_t size = rom->size();
     if (size != ExpectedDataSize) {
         cerr << "Unexpected ROM data size for no MBC: " << size << endl;
         return false;
@@ -46,13 +44,17 @@ bool NoMBC::configureWithROMData(const void *romData, size_t size) {
     }
     
     _ramData = new uint8_t[RAMBankSize]();
-    return MemoryBankController::configureWithROMData(romData, size);
+    return MemoryBankController::configureWithROMImage(rom);
 }
 
 uint8_t NoMBC::readROM(uint16_t addr) const {
     return _romData[addr];
 }
 
+const uint8_t *NoMBC::switchableROMData() const {
+    return _romData + SwitchableROMBaseAddr;
+}
+
 uint8_t NoMBC::readRAM(uint16_t addr) const {
     if (_ramType == RAMType::SingleBank) {
         assert(addr >= RAMBase && addr < RAMMax);
@@ -62,6 +64,14 @@ uint8_t NoMBC::readRAM(uint16_t addr) const {
     }
 }
 
+const uint8_t *NoMBC::switchableRAMData() const {
+    if (_ramType == RAMType::SingleBank) {
+        return _ramData;
+    } else {
+        return nullptr;
+    }
+}
+
 void NoMBC::writeRAM(uint16_t addr, uint8_t val) {
     if (_ramType == RAMType::SingleBank) {
         assert(addr >= RAMBase && addr < RAMMax);
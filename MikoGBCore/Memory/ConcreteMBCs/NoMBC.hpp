@@ -19,15 +19,15 @@ class NoMBC : public MemoryBankController {
         SingleBank,
     };
     RAMType _ramType = RAMType::Invalid;
-    uint8_t *_ramData = nullptr;
     
 public:
     NoMBC(const CartridgeHeader &header);
-    ~NoMBC();
     
-    bool configureWithROMData(const void *romData, size_t size) override;
+    bool configureWithROMImage(const ROMImage::Ptr &rom) override;
     uint8_t readROM(uint16_t addr) const override;
+    const uint8_t *switchableROMData() const override;
     uint8_t readRAM(uint16_t addr) const override;
+    const uint8_t *switchableRAMData() const override;
     void writeRAM(uint16_t addr, uint8_t val) override;
     void writeControlCode(uint16_t addr, uint8_t val) override;
     int currentROMBank() const override;
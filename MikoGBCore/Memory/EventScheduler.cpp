@@ -0,0 +1,38 @@
+//
+//  EventScheduler.cpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#include "EventScheduler.hpp"
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+using namespace MikoGB;
+
+const uint64_t EventScheduler::NoEvent;
+
+EventScheduler::EventScheduler() {
+    // Every component starts out due so that it schedules its first event
+    scheduleAll();
+}
+
+void EventScheduler::scheduleAll() {
+    fill(begin(_deadlines), end(_deadlines), _masterCycles);
+    _nextEvent = _masterCycles;
+}
+
+void EventScheduler::_updateNextEvent() {
+    // Only a handful of sources, so just rescan for the earliest
+    _nextEvent = *min_element(begin(_deadlines), end(_deadlines));
+}
+
+void EventScheduler::scheduleAfterMasterCycles(EventSource source, uint64_t masterCycles) {
+    schedule(source, masterCycles == NoEvent ? NoEvent : _masterCycles + masterCycles);
+}
+
+void EventScheduler::scheduleAfterCPUCycles(EventSource source, uint64_t cpuCycles) {
+    schedule(source, cpuCycles == NoEvent ? NoEvent : _masterCycles + masterCyclesForCPUCycles(cpuCycles));
+}
@@ -0,0 +1,102 @@
+//
+//  EventScheduler.hpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#ifndef EventScheduler_hpp
+#define EventScheduler_hpp
+
+#include <cstdlib>
+#include <cstdint>
+
+namespace MikoGB {
+
+/// Keeps emulated time and the next time each component needs to be updated, e.g. a GPU mode change or TIMA overflow.
+/// The CPU runs without updating any other component until the earliest of these deadlines
+///
+/// Time is kept by a 64-bit master clock running at 2^23 Hz, twice the normal CPU speed. A CPU cycle is 2 master cycles
+/// at normal speed and 1 in double-speed mode. Components timed in real time (GPU, audio) count master cycles so they
+/// run at the same rate regardless of CPU speed. Components timed by the CPU (timer, serial) count CPU cycles
+class EventScheduler {
+public:
+    enum class EventSource : uint8_t {
+        GPU = 0,    // next LCD mode change
+        Timer,      // next TIMA overflow
+        Audio,      // upper bound on time between audio updates so that samples are emitted steadily
+        Serial,     // completion of an internally clocked transfer
+        Count,
+    };
+    static const uint64_t NoEvent = UINT64_MAX;
+    
+    EventScheduler();
+    
+    uint64_t masterCycles() const { return _masterCycles; }
+    uint64_t cpuCycles() const { return _cpuCycles; }
+    
+    bool isDoubleSpeed() const { return _isDoubleSpeed; }
+    void setDoubleSpeed(bool doubleSpeed) { _isDoubleSpeed = doubleSpeed; }
+    
+    /// Convert a duration in CPU cycles to master cycles at the current CPU speed
+    uint64_t masterCyclesForCPUCycles(uint64_t cpuCycles) const {
+        return _isDoubleSpeed ? cpuCycles : cpuCycles * 2;
+    }
+    
+    /// Advance the clock by the CPU cycles that an instruction took. Returns true if any event is due
+    bool advance(size_t cpuCycles) {
+        _cpuCycles += cpuCycles;
+        _masterCycles += masterCyclesForCPUCycles(cpuCycles);
+        return _masterCycles >= _nextEvent;
+    }
+    
+    /// Set the master cycle at which source's event is due, replacing any previous deadline for it
+    void schedule(EventSource source, uint64_t masterCycle) {
+        uint64_t &deadline = _deadlines[(size_t)source];
+        const bool wasNextEvent = deadline == _nextEvent;
+        deadline = masterCycle;
+        if (masterCycle <= _nextEvent) {
+            _nextEvent = masterCycle;
+        } else if (wasNextEvent) {
+            // The earliest event moved later, something else may be next now
+            _updateNextEvent();
+        }
+    }
+    void cancel(EventSource source) { schedule(source, NoEvent); }
+    
+    /// Schedule source's event after the given number of master or CPU cycles from now. NoEvent cancels it
+    void scheduleAfterMasterCycles(EventSource source, uint64_t masterCycles);
+    void scheduleAfterCPUCycles(EventSource source, uint64_t cpuCycles);
+    
+    /// Schedule every source's event now, e.g. when the clock conversion changes
+    void scheduleAll();
+    
+    /// CPU cycles at the current speed until the earliest event is due, rounded up. NoEvent if nothing is scheduled
+    uint64_t cpuCyclesUntilNextEvent() const {
+        if (_nextEvent == NoEvent) {
+            return NoEvent;
+        } else if (_masterCycles >= _nextEvent) {
+            return 0;
+        }
+        const uint64_t masterCycles = _nextEvent - _masterCycles;
+        return _isDoubleSpeed ? masterCycles : (masterCycles + 1) / 2;
+    }
+    
+    uint64_t deadline(EventSource source) const { return _deadlines[(size_t)source]; }
+    uint64_t nextEventMasterCycle() const { return _nextEvent; }
+    bool isEventDue(EventSource source) const { return _masterCycles >= deadline(source); }
+    
+private:
+    void _updateNextEvent();
+    
+    uint64_t _masterCycles = 0;
+    uint64_t _cpuCycles = 0;
+    bool _isDoubleSpeed = false;
+    
+    uint64_t _deadlines[(size_t)EventSource::Count];
+    uint64_t _nextEvent = NoEvent;
+};
+
+}
+
+#endif /* EventScheduler_hpp */
@@ -12,6 +12,7 @@
 #include "MBC5.hpp"
 
 #include <iostream>
+#include <algorithm>
 
 using namespace std;
 using namespace MikoGB;
@@ -44,17 +45,60 @@ MemoryBankController *MemoryBankController::CreateMBC(const CartridgeHeader &hea
     return mbc;
 }
 
-bool MemoryBankController::configureWithROMData(const void *romData, size_t size) {
-    if (_romData != nullptr) {
+MemoryBankController::~MemoryBankController() {
+    if (_ownsRAMData) {
+        delete [] _ramData;
+    }
+}
+
+bool MemoryBankController::configureWithROMImage(const ROMImage::Ptr &rom) {
+    if (_rom != nullptr) {
         cerr << "MBC may not be configured multiple times\n";
         return false;
     }
     
-    _romData = new uint8_t[size]();
-    memcpy(_romData, romData, size);
+    _rom = rom;
+    _romData = rom->data();
     return true;
 }
 
+void MemoryBankController::clearDirtySaveData() {
+    fill(_dirtySavePages.begin(), _dirtySavePages.end(), 0);
+}
+
+void MemoryBankController::_saveDataDidChange(size_t offset) {
+    const size_t page = offset / SaveDataPageSize;
+    const size_t word = page / 64;
+    if (word >= _dirtySavePages.size()) {
+        _dirtySavePages.resize(word + 1, 0);
+    }
+    _dirtySavePages[word] |= (uint64_t)1 << (page % 64);
+    _isPersistenceStale = true;
+}
+
+std::vector<SaveDataRange> MemoryBankController::dirtySaveDataRanges() const {
+    vector<SaveDataRange> ranges;
+    const size_t dataSize = saveDataSize();
+    const size_t pageCount = _dirtySavePages.size() * 64;
+    size_t page = 0;
+    while (page < pageCount) {
+        if (!(_dirtySavePages[page / 64] & ((uint64_t)1 << (page % 64)))) {
+            ++page;
+            continue;
+        }
+        // Join consecutive dirty pages into one range
+        const size_t firstPage = page;
+        while (page < pageCount && (_dirtySavePages[page / 64] & ((uint64_t)1 << (page % 64)))) {
+            ++page;
+        }
+        SaveDataRange range;
+        range.offset = firstPage * SaveDataPageSize;
+        range.size = min(page * SaveDataPageSize, dataSize) - range.offset;
+        ranges.push_back(range);
+    }
+    return ranges;
+}
+
 void MemoryBankController::updateClock(size_t secondsElapsed) {
     // no-op for some MBCs
 }
@@ -71,6 +115,18 @@ bool MemoryBankController::loadClockData(const void *clockData, size_t size) {
     return false;
 }
 
-MemoryBankController::~MemoryBankController() {
-    delete [] _romData;
+bool MemoryBankController::useSaveDataStorage(uint8_t *storage) {
+    if (saveDataSize() == 0) {
+        return false;
+    }
+    if (_ownsRAMData) {
+        delete [] _ramData;
+    }
+    _ramData = storage;
+    _ownsRAMData = false;
+    return true;
+}
+
+void MemoryBankController::useClockDataStorage(uint8_t *storage) {
+    // no-op for MBCs without a clock
 }
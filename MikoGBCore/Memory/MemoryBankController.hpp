@@ -9,7 +9,10 @@
 #define MemoryBankController_hpp
 
 #include <cstdlib>
+#include <vector>
 #include "CartridgeHeader.hpp"
+#include "ROMImage.hpp"
+#include "GameBoyCoreTypes.h"
 
 namespace MikoGB {
 
@@ -26,14 +29,24 @@ public:
     bool isClockPersistenceStale() const { return _isClockPersistenceStale; }
     void resetClockPersistence() { _isClockPersistenceStale = false; }
     
-    virtual bool configureWithROMData(const void *romData, size_t size);
+    /// ROM is read directly from the image, which is retained
+    virtual bool configureWithROMImage(const ROMImage::Ptr &rom);
     
     /// Read from currently switched ROM bank
     virtual uint8_t readROM(uint16_t addr) const = 0;
     
+    /// The 16 KiB of ROM currently switched in at 0x4000 - 0x7FFF, so that reads can skip readROM()
+    /// Only valid until the next control code write
+    virtual const uint8_t *switchableROMData() const = 0;
+    
     /// Read from currently switched external RAM bank
     virtual uint8_t readRAM(uint16_t addr) const = 0;
     
+    /// The 8 KiB of external RAM currently readable at 0xA000 - 0xBFFF, so that reads can skip readRAM(). nullptr if
+    /// reads don't come from plain RAM (e.g. disabled, or mapped to clock registers). Writes still use writeRAM()
+    /// Only valid until the next control code write
+    virtual const uint8_t *switchableRAMData() const = 0;
+    
     /// Write to external RAM, potentially switched
     virtual void writeRAM(uint16_t addr, uint8_t val) = 0;
     
@@ -50,15 +63,38 @@ public:
     virtual void *getSaveData() const = 0;
     virtual bool loadSaveData(const void *saveData, size_t size) = 0;
     
+    /// Changes to save data are tracked in pages of this many bytes, independently of the stale flag. Pages stay dirty
+    /// until cleared, so that clients can reset persistence to schedule a save and copy the changes later
+    static const size_t SaveDataPageSize = 256;
+    /// Runs of dirty save data pages, in order
+    std::vector<SaveDataRange> dirtySaveDataRanges() const;
+    void clearDirtySaveData();
+    
     virtual size_t clockDataSize() const;
     virtual size_t copyClockData(void *buffer, size_t size) const;
     virtual bool loadClockData(const void *clockData, size_t size);
+    
+    /// Keep battery RAM in storage instead of the MBC's own buffer, e.g. a mapped save file. storage holds saveDataSize()
+    /// bytes, which become the save data as they are, and must outlive the MBC. Returns false if there's no battery
+    bool useSaveDataStorage(uint8_t *storage);
+    /// Keep a copy of the clock in storage (clockDataSize() bytes, as from copyClockData()), updated whenever it changes
+    virtual void useClockDataStorage(uint8_t *storage);
         
 protected:
-    uint8_t *_romData = nullptr;
-    size_t _romSize = 0;
+    ROMImage::Ptr _rom;
+    const uint8_t *_romData = nullptr; // _rom->data()
     bool _isPersistenceStale = false;
     bool _isClockPersistenceStale = false;
+    
+    /// External RAM. Subclasses allocate it with new[] unless it's replaced by useSaveDataStorage()
+    uint8_t *_ramData = nullptr;
+    
+    /// Record a change to save data at offset into getSaveData(). Marks its page dirty and persistence stale
+    void _saveDataDidChange(size_t offset);
+    
+private:
+    bool _ownsRAMData = true;
+    std::vector<uint64_t> _dirtySavePages; // one bit per page, grown as pages are written
 };
 
 }
@@ -14,6 +14,7 @@
 #include "BitTwiddlingUtil.h"
 #include <iostream>
 #include <cassert>
+#include <vector>
 
 using namespace std;
 using namespace MikoGB;
@@ -35,21 +36,21 @@ static const uint8_t LogoData[] = {
 static const size_t PermanentROMSize = 1024 * 16;        // 16 KiB from 0x0000 - 0x3FFF
 static const uint16_t SwitchableROMBaseAddr = 0x4000;
                                                          // 16 KiB of bank switchable ROM from 0x4000 - 0x7FFF
-static const uint16_t VRAMBaseAddr = 0x8000;
-static const size_t VRAMSize = 1024 * 8;                 // 8 KiB from 0x8000 - 0x9FFF
+static const uint16_t VRAMBaseAddr = 0x8000;             // 8 KiB from 0x8000 - 0x9FFF
 static const uint16_t SwitchableRAMBaseAddr = 0xA000;    // 8 KiB of bank switchable external RAM from 0xA000 - 0xBFFF
 
 // 32 KiB of bank switchable internal working ram. Only switchable on CGB
 // 0xC000 - 0xCFFF is 4KiB bank 0, always mapped. 0xD000 - 0xDFFF is switchable bank 1-7
 static const uint16_t WorkingRAMBaseAddr = 0xC000;
 static const uint16_t SwitchableWorkingRAMBaseAddr = 0xD000;
-static const uint16_t WorkingRAMSize = 1024 * 32;
 
-static const uint16_t HighRangeMemoryBaseAddr = 0xE000;
-static const size_t HighRangeMemorySize = 1024 * 8;     // 8 KiB of internal memory for various uses from 0xE000 - 0xFFFF
+static const uint16_t HighRangeMemoryBaseAddr = 0xE000;  // 8 KiB of internal memory for various uses from 0xE000 - 0xFFFF
 
 // Relevant registers
 static const uint16_t OAMBase = 0xFE00;
+static const uint16_t OAMEnd = 0xFEA0;
+static const uint16_t IORegisterBase = 0xFF00;
+static const uint16_t HighRAMBase = 0xFF80; // 127 bytes of high RAM up to the IE register
 
 // Relevant I/O registers. Writing triggers events
 static const uint16_t VRAMBankRegister = 0xFF4F; // VRAM bank switch register (CGB only)
@@ -74,51 +75,196 @@ static const uint16_t SerialControlRegister = 0xFF02; // Control bits for serial
 static const uint16_t ColorPaletteRegisterBegin = 0xFF68; // BCPS, lowest color palette I/O register
 static const uint16_t ColorPaletteRegisterEnd = 0xFF6B; // OCPD, highest color palette I/O register
 static const uint16_t ColorCompatibilityRegister = 0xFF4C; // KEY0, color compatibility
+static const uint16_t LCDControlRegister = 0xFF40; // LCDC, high bit is LCD on
 
 
+// Master cycles in a scanline. See EventScheduler
+static const uint64_t MaxMasterCyclesBetweenAudioSyncs = 456 * 2;
+
 static void _LogMemoryControllerErr(const string &msg) {
     cerr << "MemoryController Err: " << msg << "\n";
 }
 
 static uint16_t _switchableWorkingRAMAdjustedAddr(uint16_t addr, uint8_t bank) {
     // input: global address within the switchable working RAM area (0xD000 - 0xDFFF)
-    // output: offset within the _workingRAM buffer
+    // output: offset within working RAM
     // offset by 1024 per bank
     const uint16_t baseOffset = addr - SwitchableWorkingRAMBaseAddr; // (0x0000 - 0x0FFF)
     const uint16_t bankOffset = ((uint16_t)(bank) * (4 * 1024));
     return baseOffset + bankOffset;
 }
 
+MemoryController::MemoryController() {
+    _videoRAMCurrentBank = _memory.videoRAM[0];
+    _markAllVRAMWritten();
+    for (size_t i = 0; i < IORegisterCount; ++i) {
+        _ioRegisters[i].eventSource = _eventSourceForRegister(IORegisterBase + i);
+    }
+    _registerBuiltInIOHandlers();
+    _updateMemoryMap();
+}
+
+void MemoryController::registerIOHandlers(uint16_t firstAddr, uint16_t lastAddr, IOReadHandler read, IOWriteHandler write) {
+    assert(firstAddr >= IORegisterBase && firstAddr <= lastAddr);
+    for (uint32_t addr = firstAddr; addr <= lastAddr; ++addr) {
+        IORegister &reg = _ioRegisters[addr - IORegisterBase];
+        if (read) {
+            reg.read = read;
+        }
+        if (write) {
+            reg.write = write;
+        }
+    }
+}
+
+void MemoryController::_registerBuiltInIOHandlers() {
+    // Until a joypad is attached, no buttons are pressed
+    registerIOHandlers(ControllerDataRegister, ControllerDataRegister, [](uint16_t) -> uint8_t {
+        return 0x0F;
+    }, nullptr);
+    
+    // The timer and audio controller are owned here rather than attached, so their registers are hooked up here too
+    registerIOHandlers(DIVRegister, DIVRegister, [this](uint16_t) {
+        return _timer.getDiv();
+    }, [this](uint16_t, uint8_t) {
+        _timer.resetDiv();
+        return _timer.getDiv();
+    });
+    registerIOHandlers(TIMARegister, TIMARegister, [this](uint16_t) {
+        return _timer.getTIMA();
+    }, [this](uint16_t, uint8_t val) {
+        // TODO: what happens when there's a write to TIMA is not specified
+        _timer.setTIMA(val);
+        return val;
+    });
+    registerIOHandlers(TMARegister, TMARegister, nullptr, [this](uint16_t, uint8_t val) {
+        _timer.setTMA(val);
+        return val;
+    });
+    registerIOHandlers(TACRegister, TACRegister, nullptr, [this](uint16_t, uint8_t val) {
+        _timer.setTAC(val);
+        return val;
+    });
+    registerIOHandlers(AudioRegisterBegin, AudioRegisterEnd, [this](uint16_t addr) {
+        return _audioController.readAudioRegister(addr);
+    }, [this](uint16_t addr, uint8_t val) {
+        _audioController.writeAudioRegister(addr, val);
+        return val;
+    });
+    
+    // DMA
+    registerIOHandlers(DMATransferRegister, DMATransferRegister, nullptr, [this](uint16_t, uint8_t val) {
+        _dmaTransfer(val);
+        return val;
+    });
+    registerIOHandlers(HDMA1Register, HDMA4Register, nullptr, [this](uint16_t, uint8_t val) {
+        if (_isHBlankTransferActive) {
+            // TODO: This is to verify that this doesn't happen. If it does, I'll need to handle it
+            // If it doesn't, the section can be removed
+            printf("Modified DMA transfer destinations while in progress\n");
+        }
+        return val;
+    });
+    registerIOHandlers(HDMATransferRegister, HDMATransferRegister, nullptr, [this](uint16_t, uint8_t val) -> uint8_t {
+        // Write to HDMA transfer is either a general purpose or H-blank transfer depending on high bit
+        if ((val & 0x80) == 0x80) {
+            // high bit == 1 starts an H-blank DMA transfer
+            _startHBlankDMATransfer();
+        } else {
+            // high bit == 0 either terminates an in-progress H-Blank DMA transfer or starts a general purpose one
+            if (_isHBlankTransferActive) {
+                _isHBlankTransferActive = false;
+            } else {
+                _generalPurposeDMATransfer(val);
+                // on completion of DMA transfer, the transfer register becomes 0xFF;
+                return 0xFF;
+            }
+        }
+        return val;
+    });
+    
+    // Bank switches and speed
+    registerIOHandlers(VRAMBankRegister, VRAMBankRegister, nullptr, [this](uint16_t, uint8_t val) {
+        // switch VRAM banks
+        if ((val & 0x01) == 0) {
+            _videoRAMCurrentBank = _memory.videoRAM[0];
+        } else {
+            _videoRAMCurrentBank = _memory.videoRAM[1];
+        }
+        _updateMemoryMap();
+        return (uint8_t)(0xFE | val); // top 7 bits are 1 when read
+    });
+    registerIOHandlers(WRAMBankRegister, WRAMBankRegister, nullptr, [this](uint16_t, uint8_t val) {
+        // switch WRAM banks
+        _switchableWRAMBank = (val & 0x7);
+        if (_switchableWRAMBank == 0) {
+            // writing 0 selects bank 1
+            _switchableWRAMBank = 1;
+        }
+        _updateMemoryMap();
+        return val;
+    });
+    registerIOHandlers(BootROMDisableRegister, BootROMDisableRegister, nullptr, [this](uint16_t, uint8_t val) {
+        const bool enabled = val == 0;
+        _bootROMEnabled = enabled;
+        _colorBootROMEnabled = enabled;
+        _updateMemoryMap();
+        return val;
+    });
+    registerIOHandlers(DoubleSpeedRegister, DoubleSpeedRegister, [this](uint16_t) {
+        // high bit is if we're in double-speed mode. Low bit is if a switch has been "prepared"
+        const uint8_t speedMask = _doubleSpeedModeEnabled ? 0x80 : 0x00;
+        const uint8_t pendingMask = _doubleSpeedModeTogglePending ? 0x01 : 0x00;
+        return (uint8_t)(speedMask | pendingMask);
+    }, [this](uint16_t, uint8_t val) {
+        if (isMaskSet(val, 0x01)) {
+            _doubleSpeedModeTogglePending = true;
+        }
+        return val;
+    });
+}
+
 bool MemoryController::configureWithROMData(const void *romData, size_t size) {
     if (size < PermanentROMSize) {
         _LogMemoryControllerErr("Data is too small to be a valid ROM");
         return false;
     }
-    
-    if (_permanentROM != nullptr || _videoRAMBank0 != nullptr || _videoRAMBank1 != nullptr || _workingRAM != nullptr || _highRangeMemory != nullptr || _mbc != nullptr || _colorBootROM != nullptr) {
-        _LogMemoryControllerErr("Controller should not be reused");
+    return configureWithROMImage(ROMImage::CreateByCopying(romData, size));
+}
+
+bool MemoryController::configureWithROMImage(const ROMImage::Ptr &rom) {
+    if (!rom || rom->size() < PermanentROMSize) {
+        _LogMemoryControllerErr("Data is too small to be a valid ROM");
         return false;
     }
     
-    // Map the permanent ROM and read the header data from it
-    _permanentROM = new uint8_t[PermanentROMSize]();
-    memcpy(_permanentROM, romData, PermanentROMSize);
-    _header.readHeaderData(_permanentROM);
+    if (_permanentROM != nullptr || _mbc != nullptr) {
+        // Loading over a previous ROM. Start over without anything it configured
+        _hasColorBootROM = false;
+        _resetState();
+        delete _mbc;
+        _mbc = nullptr;
+        _saveFile.reset();
+    }
+    
+    // Map the permanent ROM. The image has already parsed its header
+    _rom = rom;
+    _permanentROM = rom->data();
+    _header = rom->header();
     
+    bool success = _createMBC();
+    _updateMemoryMap();
+    return success;
+}
+
+bool MemoryController::_createMBC() {
+    delete _mbc;
     _mbc = MemoryBankController::CreateMBC(_header);
     if (!_mbc) {
         _LogMemoryControllerErr("Unable to create MBC from header data");
         return false;
     }
-    
-    _videoRAMBank0 = new uint8_t[VRAMSize]();
-    _videoRAMBank1 = new uint8_t[VRAMSize]();
-    _videoRAMCurrentBank = _videoRAMBank0;
-    _workingRAM = new uint8_t[WorkingRAMSize]();
-    _highRangeMemory = new uint8_t[HighRangeMemorySize]();
-    
-    bool success = _mbc->configureWithROMData(romData, size);
-    return success;
+    return _mbc->configureWithROMImage(_rom);
 }
 
 bool MemoryController::configureWithColorBootROM(const void *bootROMData, size_t size) {
@@ -127,46 +273,128 @@ bool MemoryController::configureWithColorBootROM(const void *bootROMData, size_t
         return false;
     }
     
-    if (_colorBootROM != nullptr) {
+    if (_hasColorBootROM) {
         _LogMemoryControllerErr("Initialized color boot ROM multiple times");
         return false;
     }
     
-    _colorBootROM = new uint8_t[ColorBootROMSize];
+    if (_colorBootROM == nullptr) {
+        _colorBootROM = new uint8_t[ColorBootROMSize];
+    }
     memcpy(_colorBootROM, bootROMData, ColorBootROMSize);
+    _hasColorBootROM = true;
     _bootROMEnabled = false;
     _colorBootROMEnabled = true;
+    _updateMemoryMap();
     
     return true;
 }
 
 bool MemoryController::configureWithEmptyData() {
-    assert(_permanentROM == nullptr && _videoRAMBank0 == nullptr && _videoRAMBank1 == nullptr && _workingRAM == nullptr && _highRangeMemory == nullptr && _mbc == nullptr && _colorBootROM == nullptr);
-    _permanentROM = new uint8_t[PermanentROMSize]();
-    _videoRAMBank0 = new uint8_t[VRAMSize]();
-    _videoRAMBank1 = new uint8_t[VRAMSize]();
-    _videoRAMCurrentBank = _videoRAMBank0;
-    _workingRAM = new uint8_t[WorkingRAMSize]();
-    _highRangeMemory = new uint8_t[HighRangeMemorySize]();
-    
+    assert(_permanentROM == nullptr && _mbc == nullptr && !_hasColorBootROM);
+    vector<uint8_t> emptyROM(PermanentROMSize);
     const size_t ptr = 0x104;
     for (size_t i = 0; i < 48; ++i) {
-        _permanentROM[ptr + i] = LogoData[i];
+        emptyROM[ptr + i] = LogoData[i];
     }
+    _rom = ROMImage::CreateByCopying(emptyROM.data(), emptyROM.size());
+    _permanentROM = _rom->data();
+    _updateMemoryMap();
     
     return true;
 }
 
+void MemoryController::reset() {
+    _resetState();
+    if (_mbc) {
+        _createMBC();
+        if (_saveFile) {
+            // Battery RAM survives a power cycle
+            _attachSaveFile();
+        }
+    }
+    _updateMemoryMap();
+}
+
+void MemoryController::_resetState() {
+    _memory = {};
+    _videoRAMCurrentBank = _memory.videoRAM[0];
+    _markAllVRAMWritten();
+    ++_oamWriteCount;
+    _switchableWRAMBank = 1;
+    _bootROMEnabled = !_hasColorBootROM;
+    _colorBootROMEnabled = _hasColorBootROM;
+    _doubleSpeedModeEnabled = false;
+    _doubleSpeedModeTogglePending = false;
+    _isHBlankTransferActive = false;
+    _hBlankTransferSource = 0;
+    _hBlankTransferDst = 0;
+    
+    _timer = Timer();
+    _audioController.reset();
+    scheduler = EventScheduler();
+    _gpuSyncedMasterCycles = 0;
+    _timerSyncedCPUCycles = 0;
+    _audioSyncedMasterCycles = 0;
+    _serialSyncedCPUCycles = 0;
+    _isSyncingPeripherals = false;
+    
+    // Whatever was mapped into the ROM space may change
+    ++_romMappingGeneration;
+}
+
 MemoryController::~MemoryController() {
-    delete [] _permanentROM;
-    delete [] _videoRAMBank0;
-    delete [] _videoRAMBank1;
-    delete [] _workingRAM;
-    delete [] _highRangeMemory;
     delete _mbc;
+    delete [] _colorBootROM;
+}
+
+void MemoryController::_updateMemoryMap() {
+    for (size_t i = 0; i < MemoryPageCount; ++i) {
+        _readPages[i] = nullptr;
+        _writePages[i] = nullptr;
+    }
+    const size_t vramPage = VRAMBaseAddr >> MemoryPageShift;
+    const size_t wramPage = WorkingRAMBaseAddr >> MemoryPageShift;
+    const size_t highRangePage = HighRangeMemoryBaseAddr >> MemoryPageShift;
+    
+    // ROM is never written directly, since writes are MBC control codes. The boot ROM overlays part of the first page
+    if (_permanentROM) {
+        for (size_t i = isBootROMMapped() ? 1 : 0; i < (SwitchableROMBaseAddr >> MemoryPageShift); ++i) {
+            _readPages[i] = _permanentROM + (i << MemoryPageShift);
+        }
+    }
+    if (_mbc) {
+        const uint8_t *switchableROM = _mbc->switchableROMData();
+        for (size_t i = SwitchableROMBaseAddr >> MemoryPageShift; i < vramPage; ++i) {
+            _readPages[i] = switchableROM + ((i << MemoryPageShift) - SwitchableROMBaseAddr);
+        }
+    }
+    // VRAM writes go through the handlers to mark the tiles they change
+    for (size_t i = vramPage; i < (SwitchableRAMBaseAddr >> MemoryPageShift); ++i) {
+        _readPages[i] = _videoRAMCurrentBank + ((i << MemoryPageShift) - VRAMBaseAddr);
+    }
+    // External RAM is read directly when the MBC has plain RAM switched in. Writes go through the MBC, which tracks
+    // unsaved changes
+    if (_mbc) {
+        const uint8_t *switchableRAM = _mbc->switchableRAMData();
+        if (switchableRAM) {
+            for (size_t i = SwitchableRAMBaseAddr >> MemoryPageShift; i < wramPage; ++i) {
+                _readPages[i] = switchableRAM + ((i << MemoryPageShift) - SwitchableRAMBaseAddr);
+            }
+        }
+    }
+    _readPages[wramPage] = _memory.workingRAM;
+    _writePages[wramPage] = _memory.workingRAM;
+    uint8_t *switchableWRAM = _memory.workingRAM + _switchableWorkingRAMAdjustedAddr(SwitchableWorkingRAMBaseAddr, _switchableWRAMBank);
+    _readPages[wramPage + 1] = switchableWRAM;
+    _writePages[wramPage + 1] = switchableWRAM;
+    // The last page has OAM and the I/O registers, so only the first page of high range memory is plain memory
+    _readPages[highRangePage] = _memory.highRange;
+    _writePages[highRangePage] = _memory.highRange;
 }
 
-uint8_t MemoryController::readByte(uint16_t addr) const {
+uint8_t MemoryController::_readUnmappedByte(uint16_t addr) {
+    // Handles any address, though mapped pages never get here
     if (addr < SwitchableROMBaseAddr) {
         if (_bootROMEnabled) {
             if (addr < BootROMSize) {
@@ -192,38 +420,26 @@ uint8_t MemoryController::readByte(uint16_t addr) const {
         return _mbc->readRAM(addr);
     } else if (addr < SwitchableWorkingRAMBaseAddr) {
         // Read from bank 0 of WRAM
-        return _workingRAM[addr - WorkingRAMBaseAddr];
+        return _memory.workingRAM[addr - WorkingRAMBaseAddr];
     } else if (addr < HighRangeMemoryBaseAddr) {
         // Read from switchable bank of WRAM
         const uint16_t workingRAMAddr = _switchableWorkingRAMAdjustedAddr(addr, _switchableWRAMBank);
-        return _workingRAM[workingRAMAddr];
+        return _memory.workingRAM[workingRAMAddr];
+    } else if (addr < IORegisterBase) {
+        // Echo RAM and OAM
+        return _memory.highRange[addr - HighRangeMemoryBaseAddr];
     } else {
         
-        if (addr == ControllerDataRegister) {
-            if (joypad) {
-                return joypad->readJoypadRegister();
-            } else {
-                // no buttons pressed
-                return 0x0F;
-            }
-        } else if (addr == DIVRegister) {
-            return _timer.getDiv();
-        } else if (addr == TIMARegister) {
-            return _timer.getTIMA();
-        } else if (addr >= AudioRegisterBegin && addr <= AudioRegisterEnd) {
-            // read from audio controller
-            return _audioController.readAudioRegister(addr);
-        } else if (addr >= ColorPaletteRegisterBegin && addr <= ColorPaletteRegisterEnd) {
-            return gpu->colorPaletteRegisterRead(addr);
-        } else if (addr == DoubleSpeedRegister) {
-            // high bit is if we're in double-speed mode. Low bit is if a switch has been "prepared"
-            const uint8_t speedMask = _doubleSpeedModeEnabled ? 0x80 : 0x00;
-            const uint8_t pendingMask = _doubleSpeedModeTogglePending ? 0x01 : 0x00;
-            return speedMask | pendingMask;
+        // Registers that depend on time are only correct once their component has caught up
+        _syncForRegister(addr);
+        
+        const IORegister &reg = _ioRegisters[addr - IORegisterBase];
+        if (reg.read) {
+            return reg.read(addr);
         }
         
         // Read from the high range memory
-        return _highRangeMemory[addr - HighRangeMemoryBaseAddr];
+        return _memory.highRange[addr - HighRangeMemoryBaseAddr];
     }
 }
 
@@ -232,124 +448,277 @@ uint8_t MemoryController::readVRAMByte(uint16_t addr, int bank) const {
     assert(bank == 0 || bank == 1);
     
     if (bank == 0) {
-        return _videoRAMBank0[addr - VRAMBaseAddr];
+        return _memory.videoRAM[0][addr - VRAMBaseAddr];
     } else if (bank == 1) {
-        return _videoRAMBank1[addr - VRAMBaseAddr];
+        return _memory.videoRAM[1][addr - VRAMBaseAddr];
     }
     
     // Unreachable except by client error
     assert(false);
 }
 
-void MemoryController::setByte(uint16_t addr, uint8_t val) {
+void MemoryController::_setUnmappedByte(uint16_t addr, uint8_t val) {
+    // Handles any address, though mapped pages never get here
     if (addr < VRAMBaseAddr) {
         // Write to ROM area means potentially an MBC control code
         _mbc->writeControlCode(addr, val);
+        ++_romMappingGeneration;
+        _updateMemoryMap();
     } else if (addr < SwitchableRAMBaseAddr) {
-        // Write to VRAM
-        _videoRAMCurrentBank[addr - VRAMBaseAddr] = val;
+        // Write to VRAM. Writing the value that's already there changes nothing for the GPU to notice
+        uint8_t &vramByte = _videoRAMCurrentBank[addr - VRAMBaseAddr];
+        if (vramByte != val) {
+            vramByte = val;
+            _markVRAMWritten(addr, 1);
+        }
     } else if (addr < WorkingRAMBaseAddr) {
         // Write to switchable external RAM
         _mbc->writeRAM(addr, val);
     } else if (addr < SwitchableWorkingRAMBaseAddr) {
         // Write to bank 0 of working RAM
-        _workingRAM[addr - WorkingRAMBaseAddr] = val;
+        _memory.workingRAM[addr - WorkingRAMBaseAddr] = val;
     } else if (addr < HighRangeMemoryBaseAddr) {
         // Write to switchable bank of working RAM
         const uint16_t workingRAMAddr = _switchableWorkingRAMAdjustedAddr(addr, _switchableWRAMBank);
-        _workingRAM[workingRAMAddr] = val;
+        _memory.workingRAM[workingRAMAddr] = val;
+    } else if (addr < IORegisterBase) {
+        // Write to echo RAM or OAM
+        if (addr >= OAMBase && addr < OAMEnd && _memory.highRange[addr - HighRangeMemoryBaseAddr] != val) {
+            ++_oamWriteCount;
+        }
+        _directSetHighRange(addr, val);
     } else {
         
+        // Catch up the register's component before the write, and again once this instruction completes since the
+        // write may change when its next event happens (e.g. turning on the LCD or enabling the timer)
+        const EventScheduler::EventSource syncedSource = _syncForRegister(addr);
+        if (syncedSource != EventScheduler::EventSource::Count) {
+            scheduler.schedule(syncedSource, scheduler.masterCycles());
+        }
+        
         // Several special events are triggered when writing to the I/O registers in high range memory
-        uint8_t toWrite = val;
+        const IORegister &reg = _ioRegisters[addr - IORegisterBase];
+        const uint8_t toWrite = reg.write ? reg.write(addr, val) : val;
         
-        if (addr == DMATransferRegister) {
-            _dmaTransfer(val);
-        } else if (addr == HDMATransferRegister) {
-            // Write to HDMA transfer is either a general purpose or H-blank transfer depending on high bit
-            if ((val & 0x80) == 0x80) {
-                // high bit == 1 starts an H-blank DMA transfer
-                _startHBlankDMATransfer();
-            } else {
-                // high bit == 0 either terminates an in-progress H-Blank DMA transfer or starts a general purpose one
-                if (_isHBlankTransferActive) {
-                    _isHBlankTransferActive = false;
-                } else {
-                    _generalPurposeDMATransfer(val);
-                    // on completion of DMA transfer, the transfer register becomes 0xFF;
-                    toWrite = 0xFF;
+        // Write to high range memory
+        _directSetHighRange(addr, toWrite);
+    }
+}
+
+void MemoryController::_directSetHighRange(uint16_t addr, uint8_t val) {
+    _memory.highRange[addr - HighRangeMemoryBaseAddr] = val;
+}
+
+void MemoryController::_markVRAMWritten(uint16_t addr, size_t count) {
+    const int bank = _videoRAMCurrentBank == _memory.videoRAM[1] ? 1 : 0;
+    const size_t offset = addr - VRAMBaseAddr;
+    const size_t end = min(offset + count, (size_t)VRAMBankSize);
+    for (size_t tile = offset / 16; tile < VRAMTileCount && tile * 16 < end; ++tile) {
+        _dirtyTiles[bank][tile] = 0xFF;
+    }
+    // Tile maps. An entry's attributes in bank 1 are at the same address as its code in bank 0
+    for (size_t entry = max<size_t>(offset, VRAMTileDataSize); entry < end; ++entry) {
+        _dirtyTileMapEntries[entry - VRAMTileDataSize] = true;
+    }
+    ++_vramWriteCount;
+}
+
+void MemoryController::_markAllVRAMWritten() {
+    memset(_dirtyTiles, 0xFF, sizeof(_dirtyTiles));
+    memset(_dirtyTileMapEntries, true, sizeof(_dirtyTileMapEntries));
+    ++_vramWriteCount;
+}
+
+bool MemoryController::_isLCDOn() const {
+    return isMaskSet(_memory.highRange[LCDControlRegister - HighRangeMemoryBaseAddr], 0x80);
+}
+
+uint8_t *MemoryController::_bulkMemory(uint16_t addr, size_t &count, bool forWrite) {
+    // The GPU reads VRAM and OAM as it renders, so writing them all at once is only unobservable with the LCD off
+    const bool videoMemoryAllowed = !forWrite || !_isLCDOn();
+    uint8_t *base = nullptr;
+    size_t regionEnd = 0;
+    bool isVRAM = false;
+    bool isOAM = false;
+    if (addr >= VRAMBaseAddr && addr < SwitchableRAMBaseAddr && videoMemoryAllowed) {
+        base = _videoRAMCurrentBank + (addr - VRAMBaseAddr);
+        regionEnd = SwitchableRAMBaseAddr;
+        isVRAM = true;
+    } else if (addr >= WorkingRAMBaseAddr && addr < SwitchableWorkingRAMBaseAddr) {
+        base = _memory.workingRAM + (addr - WorkingRAMBaseAddr);
+        regionEnd = SwitchableWorkingRAMBaseAddr;
+    } else if (addr >= SwitchableWorkingRAMBaseAddr && addr < HighRangeMemoryBaseAddr) {
+        base = _memory.workingRAM + _switchableWorkingRAMAdjustedAddr(addr, _switchableWRAMBank);
+        regionEnd = HighRangeMemoryBaseAddr;
+    } else if (addr >= OAMBase && addr < OAMEnd && videoMemoryAllowed) {
+        base = _memory.highRange + (addr - HighRangeMemoryBaseAddr);
+        regionEnd = OAMEnd;
+        isOAM = true;
+    } else if (addr >= HighRAMBase && addr < IERegister) {
+        base = _memory.highRange + (addr - HighRangeMemoryBaseAddr);
+        regionEnd = IERegister;
+    } else {
+        // External RAM (MBC controlled), echo RAM and I/O registers
+        return nullptr;
+    }
+    count = min(count, regionEnd - addr);
+    if (forWrite && isVRAM) {
+        // The caller may end up writing fewer bytes. Marking extra tiles only means decoding them again
+        _markVRAMWritten(addr, count);
+    }
+    if (forWrite && isOAM) {
+        ++_oamWriteCount;
+    }
+    return base;
+}
+
+size_t MemoryController::bulkCopy(uint16_t dst, uint16_t src, size_t maxCount) {
+    if (_isHBlankTransferActive) {
+        // H-blank DMA may read the source or destination between lines
+        return 0;
+    }
+    size_t count = maxCount;
+    uint8_t *dstMemory = _bulkMemory(dst, count, true);
+    if (!dstMemory) {
+        return 0;
+    }
+    
+    if (src < SwitchableROMBaseAddr) {
+        if (isBootROMMapped()) {
+            return 0;
+        }
+        count = min<size_t>(count, SwitchableROMBaseAddr - src);
+        memcpy(dstMemory, _permanentROM + src, count);
+    } else if (src < VRAMBaseAddr) {
+        count = min<size_t>(count, VRAMBaseAddr - src);
+        memcpy(dstMemory, _mbc->switchableROMData() + (src - SwitchableROMBaseAddr), count);
+    } else {
+        const uint8_t *srcMemory = _bulkMemory(src, count, false);
+        if (!srcMemory) {
+            return 0;
+        }
+        if (dst > src && dst < src + count) {
+            // Copying forward one byte at a time would re-read bytes it has already written. Stop before that happens
+            count = dst - src;
+        }
+        // Otherwise, a byte-by-byte copy behaves like memmove
+        memmove(dstMemory, srcMemory, count);
+    }
+    return count;
+}
+
+size_t MemoryController::bulkFill(uint16_t dst, uint8_t val, size_t maxCount) {
+    if (_isHBlankTransferActive) {
+        return 0;
+    }
+    size_t count = maxCount;
+    uint8_t *dstMemory = _bulkMemory(dst, count, true);
+    if (!dstMemory) {
+        return 0;
+    }
+    memset(dstMemory, val, count);
+    return count;
+}
+
+EventScheduler::EventSource MemoryController::_eventSourceForRegister(uint16_t addr) const {
+    using EventSource = EventScheduler::EventSource;
+    if (addr == SerialDataRegister || addr == SerialControlRegister) {
+        return EventSource::Serial;
+    } else if (addr >= DIVRegister && addr <= TACRegister) {
+        return EventSource::Timer;
+    } else if (addr >= AudioRegisterBegin && addr <= AudioRegisterEnd) {
+        return EventSource::Audio;
+    } else if ((addr >= LCDControlRegister && addr <= ColorCompatibilityRegister) ||
+               (addr >= HDMA1Register && addr <= HDMATransferRegister) ||
+               (addr >= ColorPaletteRegisterBegin && addr <= ColorPaletteRegisterEnd)) {
+        return EventSource::GPU;
+    }
+    // The joypad and interrupt requests don't depend on time, nor do the bank and speed switches
+    return EventSource::Count;
+}
+
+EventScheduler::EventSource MemoryController::_syncForRegister(uint16_t addr) {
+    if (_isSyncingPeripherals || addr < IORegisterBase) {
+        return EventScheduler::EventSource::Count;
+    }
+    const EventScheduler::EventSource source = _ioRegisters[addr - IORegisterBase].eventSource;
+    if (source != EventScheduler::EventSource::Count) {
+        _syncEventSource(source);
+    }
+    return source;
+}
+
+void MemoryController::_syncEventSource(EventScheduler::EventSource source) {
+    using EventSource = EventScheduler::EventSource;
+    // Components write registers and request interrupts as they update. Those writes shouldn't sync again
+    _isSyncingPeripherals = true;
+    switch (source) {
+        case EventSource::GPU: {
+            const uint64_t now = scheduler.masterCycles();
+            if (gpu) {
+                if (now != _gpuSyncedMasterCycles) {
+                    gpu->updateWithMasterCycles(now - _gpuSyncedMasterCycles);
                 }
-            }
-        } else if (addr >= HDMA1Register && addr <= HDMA4Register) {
-            if (_isHBlankTransferActive) {
-                // TODO: This is to verify that this doesn't happen. If it does, I'll need to handle it
-                // If it doesn't, the section can be removed
-                printf("Modified DMA transfer destinations while in progress\n");
-            }
-        } else if (addr == VRAMBankRegister) {
-            // switch VRAM banks
-            if ((val & 0x01) == 0) {
-                _videoRAMCurrentBank = _videoRAMBank0;
+                scheduler.scheduleAfterMasterCycles(source, gpu->masterCyclesUntilNextEvent());
             } else {
-                _videoRAMCurrentBank = _videoRAMBank1;
+                scheduler.cancel(source);
             }
-            toWrite = 0xFE | val; // top 7 bits are 1 when read
-        } else if (addr == WRAMBankRegister) {
-            // switch WRAM banks
-            _switchableWRAMBank = (val & 0x7);
-            if (_switchableWRAMBank == 0) {
-                // writing 0 selects bank 1
-                _switchableWRAMBank = 1;
+            _gpuSyncedMasterCycles = now;
+            break;
+        }
+        case EventSource::Timer: {
+            const uint64_t now = scheduler.cpuCycles();
+            if (now != _timerSyncedCPUCycles && _timer.updateWithCPUCycles(now - _timerSyncedCPUCycles)) {
+                requestInterrupt(TIMA);
             }
-        } else if (addr == BootROMDisableRegister) {
-            const bool enabled = val == 0;
-            _bootROMEnabled = enabled;
-            _colorBootROMEnabled = enabled;
-        } else if (addr == DIVRegister) {
-            _timer.resetDiv();
-            return;
-        } else if (addr == TIMARegister) {
-            // TODO: what happens when there's a write to TIMA is not specified
-            _timer.setTIMA(val);
-            return;
-        } else if (addr == TMARegister) {
-            _timer.setTMA(val);
-        } else if (addr == TACRegister) {
-            _timer.setTAC(val);
-        } else if (addr >= AudioRegisterBegin && addr <= AudioRegisterEnd) {
-            // write to audio controller
-            _audioController.writeAudioRegister(addr, val);
-        } else if (addr == SerialDataRegister) {
-            serialController->serialDataWillWrite(val);
-        } else if (addr == SerialControlRegister) {
-            serialController->serialControlWillWrite(val);
-        } else if (addr == DoubleSpeedRegister) {
-            if (isMaskSet(val, 0x01)) {
-                _doubleSpeedModeTogglePending = true;
+            _timerSyncedCPUCycles = now;
+            scheduler.scheduleAfterCPUCycles(source, _timer.cpuCyclesUntilOverflow());
+            break;
+        }
+        case EventSource::Audio: {
+            // Audio has no events of its own, but is kept within a scanline so that samples are emitted steadily
+            const uint64_t now = scheduler.masterCycles();
+            if (now != _audioSyncedMasterCycles) {
+                _audioController.updateWithMasterCycles((int)(now - _audioSyncedMasterCycles));
             }
-        } else if (addr >= ColorPaletteRegisterBegin && addr <= ColorPaletteRegisterEnd) {
-            gpu->colorPaletteRegisterWrite(addr, val);
-        } else if (addr == ColorCompatibilityRegister) {
-            gpu->colorModeRegisterWrite(val);
+            _audioSyncedMasterCycles = now;
+            scheduler.scheduleAfterMasterCycles(source, MaxMasterCyclesBetweenAudioSyncs);
+            break;
         }
-        
-        // Write to high range memory
-        _directSetHighRange(addr, toWrite);
+        case EventSource::Serial: {
+            const uint64_t now = scheduler.cpuCycles();
+            if (serialController) {
+                if (now != _serialSyncedCPUCycles) {
+                    serialController->updateWithCPUCycles((int)(now - _serialSyncedCPUCycles));
+                }
+                scheduler.scheduleAfterCPUCycles(source, serialController->cpuCyclesUntilTransferComplete());
+            } else {
+                scheduler.cancel(source);
+            }
+            _serialSyncedCPUCycles = now;
+            break;
+        }
+        case EventSource::Count:
+            assert(false);
+            break;
     }
+    _isSyncingPeripherals = false;
 }
 
-void MemoryController::_directSetHighRange(uint16_t addr, uint8_t val) {
-    _highRangeMemory[addr - HighRangeMemoryBaseAddr] = val;
+void MemoryController::runDueEvents() {
+    ++_dueEventCount;
+    for (size_t i = 0; i < (size_t)EventScheduler::EventSource::Count; ++i) {
+        const EventScheduler::EventSource source = (EventScheduler::EventSource)i;
+        if (scheduler.isEventDue(source)) {
+            _syncEventSource(source);
+        }
+    }
 }
 
-void MemoryController::updateWithCPUCycles(size_t cpuCycles) {
-    bool interrupt = _timer.updateWithCPUCycles(cpuCycles);
-    if (interrupt) {
-        requestInterrupt(TIMA);
+void MemoryController::syncPeripherals() {
+    for (size_t i = 0; i < (size_t)EventScheduler::EventSource::Count; ++i) {
+        _syncEventSource((EventScheduler::EventSource)i);
     }
-    const size_t audioCycles = _doubleSpeedModeEnabled ? cpuCycles : cpuCycles * 2;
-    _audioController.updateWithCPUCycles((int)audioCycles);
-    serialController->updateWithCPUCycles((int)cpuCycles);
 }
 
 void MemoryController::updateWithRealTimeSeconds(size_t secondsElapsed) {
@@ -360,8 +729,12 @@ bool MemoryController::toggleDoubleSpeedModeIfNecessary() {
     if (!_doubleSpeedModeTogglePending) {
         return false;
     }
+    // Time up to now elapsed at the old speed. Events are rescheduled once the instruction completes
+    syncPeripherals();
     _doubleSpeedModeTogglePending = false;
     _doubleSpeedModeEnabled = !_doubleSpeedModeEnabled;
+    scheduler.setDoubleSpeed(_doubleSpeedModeEnabled);
+    scheduler.scheduleAll();
     return true;
 }
 
@@ -372,7 +745,7 @@ void MemoryController::requestInterrupt(InterruptFlag flag) {
 
 MemoryController::InputMask MemoryController::selectedInputMask() const {
     uint16_t idx = ControllerDataRegister - HighRangeMemoryBaseAddr;
-    uint8_t regVal = _highRangeMemory[idx] & 0x30;
+    uint8_t regVal = _memory.highRange[idx] & 0x30;
     return static_cast<InputMask>(regVal);
 }
 
@@ -420,12 +793,7 @@ void MemoryController::_dmaTransfer(uint8_t byte) {
     assert(byte <= 0xDF);
     const uint16_t sourceBase = ((uint16_t)byte) << 8;
     const uint16_t toTransfer = 0xA0; // 160 bytes
-    
-    for (uint16_t i = 0; i < toTransfer; ++i) {
-        const uint16_t src = sourceBase + i;
-        const uint16_t dst = OAMBase + i;
-        setByte(dst, readByte(src));
-    }
+    _dmaCopy(OAMBase, sourceBase, toTransfer);
 }
 
 // CGB general-purpose DMA transfer
@@ -445,11 +813,7 @@ void MemoryController::_generalPurposeDMATransfer(uint8_t byte) {
     // amount to transfer is low-7 bits in the HDMA control register plus 1 times 16.
     // Result is in the range of 16 - 2048
     const uint16_t toTransfer = (((uint16_t)(byte & 0x7F)) + 1) << 4;
-    for (uint16_t i = 0; i < toTransfer; ++i) {
-        const uint16_t src = sourceBase + i;
-        const uint16_t dst = dstBase + i;
-        setByte(dst, readByte(src));
-    }
+    _dmaCopy(dstBase, sourceBase, toTransfer);
 }
 
 void MemoryController::_startHBlankDMATransfer() {
@@ -475,13 +839,7 @@ void MemoryController::hBlankDMATransferStep() {
         return;
     }
     
-    const uint16_t sourceBase = _hBlankTransferSource;
-    const uint16_t dstBase = _hBlankTransferDst;
-    for (uint16_t i = 0; i < 16; ++i) {
-        const uint16_t src = sourceBase + i;
-        const uint16_t dst = dstBase + i;
-        setByte(dst, readByte(src));
-    }
+    _dmaCopy(_hBlankTransferDst, _hBlankTransferSource, 16);
     
     // Next step will transfer 16 bytes to/from the next 16 byte window
     // TODO: Is this the correct approach or do programs move the pointers themselves?
@@ -500,6 +858,54 @@ void MemoryController::hBlankDMATransferStep() {
     }
 }
 
+void MemoryController::_dmaCopy(uint16_t dst, uint16_t src, uint16_t count) {
+    while (count > 0) {
+        // Spans end at the end of a page (or OAM) for both source and destination. Addresses wrap like a byte-by-byte copy
+        uint16_t spanCount = min<uint16_t>(count, (MemoryPageMask + 1) - (src & MemoryPageMask));
+        const uint8_t *srcPage = _readPages[src >> MemoryPageShift];
+        const uint8_t *srcMemory = srcPage ? srcPage + (src & MemoryPageMask) : nullptr;
+        uint8_t *dstMemory = nullptr;
+        if (dst >= OAMBase && dst < OAMEnd) {
+            // OAM shares its page with the I/O registers, so it's never mapped, but writing it has no side effects
+            spanCount = min<uint16_t>(spanCount, OAMEnd - dst);
+            dstMemory = _memory.highRange + (dst - HighRangeMemoryBaseAddr);
+        } else if (dst >= VRAMBaseAddr && dst < SwitchableRAMBaseAddr) {
+            // VRAM isn't mapped for writes so that written tiles are marked, which is done here for the whole span
+            spanCount = min<uint16_t>(spanCount, SwitchableRAMBaseAddr - dst);
+            dstMemory = _videoRAMCurrentBank + (dst - VRAMBaseAddr);
+        } else {
+            spanCount = min<uint16_t>(spanCount, (MemoryPageMask + 1) - (dst & MemoryPageMask));
+            uint8_t *dstPage = _writePages[dst >> MemoryPageShift];
+            dstMemory = dstPage ? dstPage + (dst & MemoryPageMask) : nullptr;
+        }
+        
+        if (!srcMemory || !dstMemory) {
+            // One byte through the full handlers, since a write may change what's mapped
+            setByte(dst, readByte(src));
+            spanCount = 1;
+        } else if (memcmp(dstMemory, srcMemory, spanCount) == 0) {
+            // Already there, e.g. OAM DMA of the same sprites as last frame. Nothing changes for the GPU to notice
+        } else {
+            if (dstMemory > srcMemory && dstMemory < srcMemory + spanCount) {
+                // Copying forward one byte at a time re-reads bytes it has already written. Keep that behavior
+                for (uint16_t i = 0; i < spanCount; ++i) {
+                    dstMemory[i] = srcMemory[i];
+                }
+            } else {
+                memmove(dstMemory, srcMemory, spanCount);
+            }
+            if (dst >= VRAMBaseAddr && dst < SwitchableRAMBaseAddr) {
+                _markVRAMWritten(dst, spanCount);
+            } else if (dst >= OAMBase && dst < OAMEnd) {
+                ++_oamWriteCount;
+            }
+        }
+        src += spanCount;
+        dst += spanCount;
+        count -= spanCount;
+    }
+}
+
 size_t MemoryController::saveDataSize() const {
     if (_mbc) {
         return _mbc->saveDataSize();
@@ -524,12 +930,93 @@ size_t MemoryController::copySaveData(void *buffer, size_t size) const {
     return dataSize;
 }
 
+size_t MemoryController::copyDirtySaveData(void *buffer, size_t size, std::vector<SaveDataRange> &ranges) {
+    if (!_mbc || size < _mbc->saveDataSize()) {
+        return 0;
+    }
+    
+    const uint8_t *saveData = static_cast<const uint8_t *>(_mbc->getSaveData());
+    size_t copiedSize = 0;
+    for (const SaveDataRange &range : _mbc->dirtySaveDataRanges()) {
+        memcpy(static_cast<uint8_t *>(buffer) + range.offset, saveData + range.offset, range.size);
+        copiedSize += range.size;
+        ranges.push_back(range);
+    }
+    // Nothing runs between the copy and clearing, so no change can be missed
+    _mbc->clearDirtySaveData();
+    return copiedSize;
+}
+
 bool MemoryController::loadSaveData(const void *saveData, size_t size) {
     if (!_mbc) {
         return false;
     }
     
-    return _mbc->loadSaveData(saveData, size);
+    if (!_mbc->loadSaveData(saveData, size)) {
+        return false;
+    }
+    // The client has what was just loaded
+    _mbc->clearDirtySaveData();
+    if (_saveFile) {
+        return _saveFile->flush(0, size);
+    }
+    return true;
+}
+
+bool MemoryController::mapSaveFile(const char *path) {
+    const size_t saveSize = saveDataSize();
+    if (saveSize == 0) {
+        _LogMemoryControllerErr("Cartridge has no battery backed RAM to map");
+        return false;
+    }
+    
+    const size_t clockSize = _mbc->clockDataSize();
+    SaveFile::Ptr file = SaveFile::CreateByMapping(path, saveSize + clockSize, saveSize);
+    if (!file) {
+        return false;
+    }
+    // Whatever the file doesn't have yet comes from the current state
+    if (file->originalSize() == 0) {
+        memcpy(file->data(), _mbc->getSaveData(), saveSize);
+    }
+    if (file->originalSize() < saveSize + clockSize) {
+        _mbc->copyClockData(file->data() + saveSize, clockSize);
+    }
+    _saveFile = std::move(file);
+    _attachSaveFile();
+    _updateMemoryMap();
+    return true;
+}
+
+void MemoryController::_attachSaveFile() {
+    uint8_t *saveData = _saveFile->data();
+    const size_t saveSize = _mbc->saveDataSize();
+    _mbc->useSaveDataStorage(saveData);
+    const size_t clockSize = _mbc->clockDataSize();
+    if (clockSize > 0) {
+        _mbc->loadClockData(saveData + saveSize, clockSize);
+        _mbc->useClockDataStorage(saveData + saveSize);
+    }
+    _mbc->clearDirtySaveData();
+}
+
+bool MemoryController::flushSaveData() {
+    if (!_saveFile) {
+        return false;
+    }
+    
+    bool success = true;
+    for (const SaveDataRange &range : _mbc->dirtySaveDataRanges()) {
+        success = _saveFile->flush(range.offset, range.size) && success;
+    }
+    const size_t clockSize = _mbc->clockDataSize();
+    if (clockSize > 0) {
+        success = _saveFile->flush(_mbc->saveDataSize(), clockSize) && success;
+    }
+    if (success) {
+        _mbc->clearDirtySaveData();
+    }
+    return success;
 }
 
 size_t MemoryController::clockDataSize() const {
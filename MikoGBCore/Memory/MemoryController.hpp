@@ -9,9 +9,15 @@
 #define MemoryController_hpp
 
 #include <cstdlib>
+#include <functional>
+#include <type_traits>
+#include <vector>
 #include "CartridgeHeader.hpp"
 #include "Timer.hpp"
 #include "AudioController.hpp"
+#include "EventScheduler.hpp"
+#include "ROMImage.hpp"
+#include "SaveFile.hpp"
 
 namespace MikoGB {
 
@@ -22,24 +28,88 @@ class GPUCore;
 
 class MemoryController {
 public:
-    MemoryController() = default;
+    MemoryController();
     ~MemoryController();
     using Ptr = std::shared_ptr<MemoryController>;
     
+    /// Copies the ROM data once. Use configureWithROMImage() to map a file or use caller-owned data instead
     bool configureWithROMData(const void *romData, size_t size);
+    /// The fixed bank and the MBC read directly from the image, which is retained
+    /// Configuring a controller that already has a ROM replaces it, drops any color boot ROM and resets everything else
+    bool configureWithROMImage(const ROMImage::Ptr &rom);
     bool configureWithEmptyData();
     bool configureWithColorBootROM(const void *romData, size_t size);
+    bool hasColorBootROM() const { return _hasColorBootROM; }
+    
+    /// Return to power-on state with the same ROM and color boot ROM, reusing all buffers. Memory, registers and the
+    /// timer, audio and scheduler start over. The MBC is recreated, so cartridge RAM and the clock are cleared too,
+    /// unless they're in a file from mapSaveFile(). I/O handlers and the audio sample callback are kept
+    void reset();
         
-    uint8_t readByte(uint16_t addr) const;
+    /// Reading or writing a time-dependent I/O register first brings its component up to date
+    /// Plain memory is accessed directly through the memory map. See _updateMemoryMap()
+    uint8_t readByte(uint16_t addr);
     uint8_t readVRAMByte(uint16_t addr, int bank) const;
+    /// All of VRAM bank 0 or 1, for the renderer to read tile data without going through readVRAMByte() per byte
+    const uint8_t *videoRAMBank(int bank) const { return _memory.videoRAM[bank]; }
+    
+    // VRAM tile data
+    static const uint16_t VRAMTileDataSize = 0x1800;        // 0x8000 - 0x97FF in each bank
+    static const uint16_t VRAMTileCount = VRAMTileDataSize / 16;
+    static const uint16_t VRAMTileMapEntryCount = 0x800;     // 0x9800 - 0x9FFF, codes in bank 0 and attributes in bank 1
+    /// Each part of the GPU that keeps something derived from VRAM is told about every write separately
+    enum VRAMReader : uint8_t {
+        TileCacheReader = 0x1,
+        BackgroundLayerReader = 0x2,
+    };
+    /// Whether the tile (bank 0 or 1, index from 0x8000) was written since the reader last called this for it, or since
+    /// a reset. Every write marks its tile, including DMA and bulk writes. For the GPU to know when to decode a tile again
+    bool takeDirtyTile(VRAMReader reader, int bank, uint16_t tileIndex) {
+        const bool isDirty = (_dirtyTiles[bank][tileIndex] & reader) != 0;
+        _dirtyTiles[bank][tileIndex] &= ~reader;
+        return isDirty;
+    }
+    /// Whether the tile map entry (index from 0x9800) had its code or CGB attributes written since this was last called
+    /// for it, or since a reset. Only the background layer reads these
+    bool takeDirtyTileMapEntry(uint16_t entryIndex) {
+        const bool isDirty = _dirtyTileMapEntries[entryIndex];
+        _dirtyTileMapEntries[entryIndex] = false;
+        return isDirty;
+    }
+    /// Changes with every VRAM write, so that readers can tell when there's nothing new without checking each tile.
+    /// Writes and DMA that leave the bytes as they were don't count
+    uint32_t getVRAMWriteCount() const { return _vramWriteCount; }
+    /// Changes with every OAM write that changes its contents, e.g. not an OAM DMA of the same sprites as last frame
+    uint32_t getOAMWriteCount() const { return _oamWriteCount; }
     void setByte(uint16_t addr, uint8_t val);
     
-    void updateWithCPUCycles(size_t cpuCycles);
+    // I/O registers
+    /// Components handle their I/O registers (0xFF00 - 0xFFFF) by registering handlers, usually when constructed. A read
+    /// handler returns the register's value. A write handler returns the value to store, which is what the register
+    /// reads as without a read handler. Registers without handlers are plain memory
+    using IOReadHandler = std::function<uint8_t(uint16_t addr)>;
+    using IOWriteHandler = std::function<uint8_t(uint16_t addr, uint8_t val)>;
+    /// Set the handlers of every register from firstAddr through lastAddr. An empty handler leaves the existing one
+    void registerIOHandlers(uint16_t firstAddr, uint16_t lastAddr, IOReadHandler read, IOWriteHandler write);
+    
+    // Timing
+    EventScheduler scheduler;
+    
+    /// The GPU, timer, audio and serial each record when they were last updated and only catch up when one of their
+    /// events is due or the CPU accesses one of their registers. The CPU observes the same state as if they were
+    /// updated after every instruction
+    void runDueEvents();
+    /// Incremented each time runDueEvents() runs, so clients can tell whether any component may have changed
+    size_t dueEventCount() const { return _dueEventCount; }
+    /// Catch up every component, regardless of whether its event is due
+    void syncPeripherals();
+    
     void updateWithRealTimeSeconds(size_t seconds);
     bool isDoubleSpeedModeEnabled() const { return _doubleSpeedModeEnabled; }
     bool toggleDoubleSpeedModeIfNecessary();
         
     const CartridgeHeader &getHeader() const { return _header; }
+    const ROMImage::Ptr &getROMImage() const { return _rom; }
     
     // Interrupts
     enum InterruptFlag : uint8_t {
@@ -53,8 +123,10 @@ public:
     static const uint16_t IFRegister = 0xFF0F; // Interrupt Request
     static const uint16_t IERegister = 0xFFFF; // Interrupt Enable
     
+    // Components that own registers. They live alongside the controller (see GameBoyCoreImp) and may be null
+    
     // GPU
-    std::shared_ptr<GPUCore> gpu;
+    GPUCore *gpu = nullptr;
     
     // Joypad
     enum InputMask : uint8_t {
@@ -62,15 +134,27 @@ public:
         Button = 0x20, // A, B, Sel, Start
     };
     InputMask selectedInputMask() const;
-    std::shared_ptr<Joypad> joypad;
+    Joypad *joypad = nullptr;
     
     // Serial
-    std::shared_ptr<SerialController> serialController;
+    SerialController *serialController = nullptr;
     
     // Audio
     void setAudioSampleCallback(AudioSampleCallback callback);
     
     // Persistence
+    /// Copy the save data pages that changed since the last call (or loadSaveData()) to the same offsets of buffer,
+    /// which must hold the previous copy, and clear them. The copied ranges are appended. Returns the number of bytes
+    /// copied. Doesn't affect isPersistenceStale()
+    size_t copyDirtySaveData(void *buffer, size_t size, std::vector<SaveDataRange> &ranges);
+    /// Keep battery RAM in the file at path, mapped read-write and shared, so that writes to external RAM go straight to
+    /// the page cache without being copied. The clock, if any, is kept right after it. Save data (and the clock) already
+    /// in the file is loaded, a new file starts with the current ones. Kept across reset(), until another ROM is loaded
+    /// Returns false if the cartridge has no battery backed RAM or the file can't be mapped
+    bool mapSaveFile(const char *path);
+    /// Write the save data changed since the last flush, and the clock, back to the mapped file. Uses the same changed
+    /// pages as copyDirtySaveData(), so use one or the other. Returns false if nothing is mapped or writing failed
+    bool flushSaveData();
     bool isPersistenceStale() const;
     void resetPersistence();
     bool isClockPersistenceStale() const;
@@ -80,6 +164,11 @@ public:
     int currentROMBank() const;
     
     bool bootROMEnabled() const { return _bootROMEnabled; }
+    bool isBootROMMapped() const { return _bootROMEnabled || _colorBootROMEnabled; }
+    
+    /// Incremented on every write that may change what is mapped into the ROM address space (MBC control codes)
+    /// Lets clients that cache ROM contents, like decoded instructions, cheaply detect bank switches
+    uint32_t romMappingGeneration() const { return _romMappingGeneration; }
     size_t saveDataSize() const;
     size_t copySaveData(void *buffer, size_t size) const;
     bool loadSaveData(const void *saveData, size_t size);
@@ -88,24 +177,62 @@ public:
     bool loadClockData(const void *clockData, size_t size);
     
     void hBlankDMATransferStep();
+    /// Whether an H-blank DMA transfer is in progress. It copies between instructions, so anything that combines several
+    /// instructions' memory accesses into one must not run while it is
+    bool isHBlankTransferActive() const { return _isHBlankTransferActive; }
+    
+    // Bulk access
+    // Used to execute recognized copy and fill loops natively. Each is equivalent to writing the bytes one at a time
+    // in order, but stops early at the end of a memory region. Only plain memory whose contents nothing else observes
+    // mid-frame is written: working RAM, high RAM, and VRAM and OAM while the LCD is off. Never touches I/O registers,
+    // external RAM or MBC control space. Return the number of bytes written, which may be 0
+    
+    /// Copy up to maxCount bytes from [src, src + maxCount) to [dst, dst + maxCount)
+    size_t bulkCopy(uint16_t dst, uint16_t src, size_t maxCount);
+    
+    /// Fill up to maxCount bytes of [dst, dst + maxCount) with val
+    size_t bulkFill(uint16_t dst, uint8_t val, size_t maxCount);
     
 private:
-    uint8_t *_permanentROM = nullptr;
-    uint8_t *_videoRAMBank0 = nullptr;
-    uint8_t *_videoRAMBank1 = nullptr;
-    uint8_t *_videoRAMCurrentBank = nullptr;
-    uint8_t *_workingRAM = nullptr;
-    uint8_t *_highRangeMemory = nullptr;
+    ROMImage::Ptr _rom;
+    const uint8_t *_permanentROM = nullptr; // first 16 KiB of _rom
+    
+    // The console's own memory, held by value in one block so that it's contiguous with the rest of the controller and
+    // can be copied as a whole
+    static const size_t VRAMBankSize = 1024 * 8;            // 0x8000 - 0x9FFF, 2 banks on CGB
+    static const size_t WorkingRAMSize = 1024 * 32;         // 0xC000 - 0xDFFF, 8 banks of 4 KiB on CGB
+    static const size_t HighRangeMemorySize = 1024 * 8;     // 0xE000 - 0xFFFF, OAM, I/O registers and high RAM
+    struct InternalMemory {
+        uint8_t videoRAM[2][VRAMBankSize];
+        uint8_t workingRAM[WorkingRAMSize];
+        uint8_t highRange[HighRangeMemorySize];
+    };
+    static_assert(std::is_trivially_copyable<InternalMemory>::value, "Internal memory must be copyable as bytes");
+    InternalMemory _memory = {};
+    uint8_t *_videoRAMCurrentBank = nullptr; // one of _memory.videoRAM
+    uint8_t _dirtyTiles[2][VRAMTileCount]; // VRAMReader bits of the readers that haven't seen the latest write
+    bool _dirtyTileMapEntries[VRAMTileMapEntryCount];
+    uint32_t _vramWriteCount = 0;
+    uint32_t _oamWriteCount = 0;
+    /// Mark the tiles and tile map entries in count bytes from addr in the current VRAM bank as written
+    void _markVRAMWritten(uint16_t addr, size_t count);
+    void _markAllVRAMWritten();
+    
     CartridgeHeader _header;
     bool _bootROMEnabled = true;
     bool _colorBootROMEnabled = false;
-    uint8_t *_colorBootROM = nullptr;
+    bool _hasColorBootROM = false;
+    uint8_t *_colorBootROM = nullptr; // kept allocated once loaded, even if a later ROM has no color boot ROM
     size_t _saveDataSize = false;
     uint8_t _switchableWRAMBank = 1;
     bool _doubleSpeedModeEnabled = false;
     bool _doubleSpeedModeTogglePending = false;
     
     MemoryBankController *_mbc = nullptr;
+    bool _createMBC();
+    SaveFile::Ptr _saveFile; // outlives _mbc, which may use it as RAM
+    void _attachSaveFile();
+    uint32_t _romMappingGeneration = 0;
     Timer _timer;
     AudioController _audioController;
     
@@ -115,9 +242,67 @@ private:
     void _dmaTransfer(uint8_t);
     void _generalPurposeDMATransfer(uint8_t);
     void _startHBlankDMATransfer();
+    /// Copy count bytes as if by readByte() and setByte() one at a time, in order. Spans of mapped memory (and OAM) are
+    /// copied directly. Anything else, like external RAM or the boot ROM overlay, goes byte by byte
+    void _dmaCopy(uint16_t dst, uint16_t src, uint16_t count);
     void _directSetHighRange(uint16_t addr, uint8_t val);
+    
+    struct IORegister {
+        IOReadHandler read;
+        IOWriteHandler write;
+        EventScheduler::EventSource eventSource = EventScheduler::EventSource::Count; // Synced before any access
+    };
+    static const size_t IORegisterCount = 256;
+    IORegister _ioRegisters[IORegisterCount];
+    void _registerBuiltInIOHandlers();
+    
+    uint64_t _gpuSyncedMasterCycles = 0;
+    uint64_t _timerSyncedCPUCycles = 0;
+    uint64_t _audioSyncedMasterCycles = 0;
+    uint64_t _serialSyncedCPUCycles = 0;
+    bool _isSyncingPeripherals = false;
+    size_t _dueEventCount = 0;
+    EventScheduler::EventSource _eventSourceForRegister(uint16_t addr) const;
+    EventScheduler::EventSource _syncForRegister(uint16_t addr);
+    void _syncEventSource(EventScheduler::EventSource source);
+    bool _isLCDOn() const;
+    /// Everything that reset() clears, except the MBC
+    void _resetState();
+    uint8_t *_bulkMemory(uint16_t addr, size_t &count, bool forWrite);
+    
+    // Memory map. One entry per 4 KiB page of the address space, pointing at the memory currently mapped there, or
+    // nullptr if accesses to the page have side effects or depend on more than the page (boot ROM overlay, MBC control
+    // codes, external RAM writes and clock registers, VRAM writes, I/O registers). Those go through the full handlers below
+    static const uint16_t MemoryPageShift = 12;
+    static const uint16_t MemoryPageMask = 0x0FFF;
+    static const size_t MemoryPageCount = 16;
+    const uint8_t *_readPages[MemoryPageCount] = {};
+    uint8_t *_writePages[MemoryPageCount] = {};
+    /// Rebuild the memory map. Called whenever the banks or overlays that are mapped change
+    void _updateMemoryMap();
+    uint8_t _readUnmappedByte(uint16_t addr);
+    void _setUnmappedByte(uint16_t addr, uint8_t val);
 };
 
+// Inline memory access fast paths
+
+inline uint8_t MemoryController::readByte(uint16_t addr) {
+    const uint8_t *page = _readPages[addr >> MemoryPageShift];
+    if (page) {
+        return page[addr & MemoryPageMask];
+    }
+    return _readUnmappedByte(addr);
+}
+
+inline void MemoryController::setByte(uint16_t addr, uint8_t val) {
+    uint8_t *page = _writePages[addr >> MemoryPageShift];
+    if (page) {
+        page[addr & MemoryPageMask] = val;
+    } else {
+        _setUnmappedByte(addr, val);
+    }
+}
+
 }
 
 #endif /* MemoryController_hpp */
@@ -0,0 +1,90 @@
+//
+//  ROMImage.cpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#include "ROMImage.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace MikoGB;
+
+// The cartridge header ends at 0x14F
+static const size_t MinimumHeaderSize = 0x150;
+
+static void _LogROMImageErr(const string &msg) {
+    cerr << "ROMImage Err: " << msg << "\n";
+}
+
+ROMImage::ROMImage(const uint8_t *data, size_t size, Storage storage): _data(data), _size(size), _storage(storage) {
+    if (size >= MinimumHeaderSize) {
+        _header.readHeaderData(data);
+    }
+}
+
+uint64_t ROMImage::contentHash() const {
+    call_once(_contentHashOnce, [this]() {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < _size; ++i) {
+            hash = (hash ^ _data[i]) * 1099511628211ULL;
+        }
+        _contentHash = hash;
+    });
+    return _contentHash;
+}
+
+ROMImage::Ptr ROMImage::CreateByMappingFile(const char *path) {
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        _LogROMImageErr(string("Unable to open ") + path + ": " + strerror(errno));
+        return nullptr;
+    }
+    
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0 || fileInfo.st_size <= 0) {
+        _LogROMImageErr(string("Unable to read the size of ") + path);
+        close(fd);
+        return nullptr;
+    }
+    
+    const size_t size = (size_t)fileInfo.st_size;
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the file is closed
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        _LogROMImageErr(string("Unable to map ") + path + ": " + strerror(errno));
+        return nullptr;
+    }
+    return Ptr(new ROMImage((const uint8_t *)mapping, size, Storage::Mapped));
+}
+
+ROMImage::Ptr ROMImage::CreateByCopying(const void *data, size_t size) {
+    uint8_t *copy = new uint8_t[size];
+    memcpy(copy, data, size);
+    return Ptr(new ROMImage(copy, size, Storage::Owned));
+}
+
+ROMImage::Ptr ROMImage::CreateWithUnownedData(const void *data, size_t size) {
+    return Ptr(new ROMImage((const uint8_t *)data, size, Storage::Unowned));
+}
+
+ROMImage::~ROMImage() {
+    switch (_storage) {
+        case Storage::Owned:
+            delete [] _data;
+            break;
+        case Storage::Unowned:
+            break;
+        case Storage::Mapped:
+            munmap((void *)_data, _size);
+            break;
+    }
+}
@@ -0,0 +1,71 @@
+//
+//  ROMImage.hpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#ifndef ROMImage_hpp
+#define ROMImage_hpp
+
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "CartridgeHeader.hpp"
+
+namespace MikoGB {
+
+/// Read-only cartridge ROM contents and its parsed header. The memory controller reads the fixed bank and the MBC reads
+/// switchable banks straight from it, so a ROM is never copied per bank or per component. Immutable, so one image can be
+/// created once and loaded by any number of cores (see GameBoyCore::loadROMImage()). Each core only allocates its own
+/// mutable state: RAM, bank registers and the real-time clock
+class ROMImage {
+public:
+    using Ptr = std::shared_ptr<const ROMImage>;
+    
+    /// Map the file at path read-only. Pages are loaded on demand and shared with every other mapping of the file.
+    /// Returns nullptr if the file can't be opened or mapped
+    static Ptr CreateByMappingFile(const char *path);
+    
+    /// Copy size bytes of data
+    static Ptr CreateByCopying(const void *data, size_t size);
+    
+    /// Use data without copying it. The caller owns data and must keep it alive and unmodified until the image is
+    /// destroyed, i.e. until every core that loaded it is destroyed
+    static Ptr CreateWithUnownedData(const void *data, size_t size);
+    
+    ~ROMImage();
+    ROMImage(const ROMImage &) = delete;
+    ROMImage &operator=(const ROMImage &) = delete;
+    
+    const uint8_t *data() const { return _data; }
+    size_t size() const { return _size; }
+    
+    /// Parsed from the ROM data when the image is created. Only meaningful if the data is large enough to have a header
+    const CartridgeHeader &header() const { return _header; }
+    
+    /// 64-bit FNV-1a hash of the whole ROM, to identify its contents (e.g. to key caches or saves). Computed the first
+    /// time it's requested since it reads every page of a mapped file
+    uint64_t contentHash() const;
+    
+private:
+    enum class Storage {
+        Owned,      // allocated with new[]
+        Unowned,    // caller-owned
+        Mapped,     // mmap of a file
+    };
+    ROMImage(const uint8_t *data, size_t size, Storage storage);
+    
+    const uint8_t *_data;
+    size_t _size;
+    Storage _storage;
+    CartridgeHeader _header;
+    
+    mutable std::once_flag _contentHashOnce;
+    mutable uint64_t _contentHash = 0;
+};
+
+}
+
+#endif /* ROMImage_hpp */
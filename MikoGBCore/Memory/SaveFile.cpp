@@ -0,0 +1,101 @@
+//
+//  SaveFile.cpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#include "SaveFile.hpp"
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace MikoGB;
+
+static void _LogSaveFileErr(const string &msg) {
+    cerr << "SaveFile Err: " << msg << "\n";
+}
+
+/// Undo CreateByMapping()'s changes to the file after a failure: remove it if it was just created, otherwise
+/// truncate it back to its original size
+static void _CloseAndRestore(int fd, const char *path, bool isCreated, size_t originalSize) {
+    if (isCreated) {
+        unlink(path);
+    } else if (ftruncate(fd, (off_t)originalSize) != 0) {
+        _LogSaveFileErr(string("Unable to restore the size of ") + path + ": " + strerror(errno));
+    }
+    close(fd);
+}
+
+SaveFile::SaveFile(uint8_t *data, size_t size, size_t originalSize): _data(data), _size(size), _originalSize(originalSize) {}
+
+SaveFile::Ptr SaveFile::CreateByMapping(const char *path, size_t size, size_t minimumSize) {
+    // Only create the file if it's missing, so that a failure below knows whether to remove it again
+    bool isCreated = false;
+    int fd = open(path, O_RDWR);
+    if (fd < 0 && errno == ENOENT) {
+        fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+        isCreated = fd >= 0;
+    }
+    if (fd < 0) {
+        _LogSaveFileErr(string("Unable to open ") + path + ": " + strerror(errno));
+        return nullptr;
+    }
+    
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0) {
+        _LogSaveFileErr(string("Unable to read the size of ") + path);
+        _CloseAndRestore(fd, path, isCreated, 0);
+        return nullptr;
+    }
+    
+    const size_t originalSize = (size_t)fileInfo.st_size;
+    if (originalSize != 0 && (originalSize < minimumSize || originalSize > size)) {
+        _LogSaveFileErr(string("Unexpected save file size for ") + path + ": " + to_string(originalSize));
+        _CloseAndRestore(fd, path, isCreated, originalSize);
+        return nullptr;
+    }
+    
+    // Mapping past the end of the file would fault, so extend it first. The new bytes read as 0
+    if (originalSize < size && ftruncate(fd, (off_t)size) != 0) {
+        _LogSaveFileErr(string("Unable to extend ") + path + ": " + strerror(errno));
+        _CloseAndRestore(fd, path, isCreated, originalSize);
+        return nullptr;
+    }
+    
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        _LogSaveFileErr(string("Unable to map ") + path + ": " + strerror(errno));
+        _CloseAndRestore(fd, path, isCreated, originalSize);
+        return nullptr;
+    }
+    // The mapping stays valid after the file is closed
+    close(fd);
+    return Ptr(new SaveFile((uint8_t *)mapping, size, originalSize));
+}
+
+SaveFile::~SaveFile() {
+    munmap(_data, _size);
+}
+
+bool SaveFile::flush(size_t offset, size_t size) {
+    if (size == 0 || offset >= _size) {
+        return true;
+    }
+    // msync works on whole pages
+    const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t start = offset - (offset % pageSize);
+    const size_t end = min(offset + size, _size);
+    if (msync(_data + start, end - start, MS_SYNC) != 0) {
+        _LogSaveFileErr(string("Unable to write back save data: ") + strerror(errno));
+        return false;
+    }
+    return true;
+}
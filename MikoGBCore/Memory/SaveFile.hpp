@@ -0,0 +1,51 @@
+//
+//  SaveFile.hpp
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#ifndef SaveFile_hpp
+#define SaveFile_hpp
+
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+
+namespace MikoGB {
+
+/// A battery save file mapped read-write and shared, for the MBC to use directly as its RAM. Writes land in the page
+/// cache without any copies and reach the file whenever the system writes the pages back, or when flushed
+class SaveFile {
+public:
+    using Ptr = std::unique_ptr<SaveFile>;
+    
+    /// Map size bytes of the file at path. A missing file is created and a shorter one is extended with zeros. Files
+    /// that aren't empty must be at least minimumSize and at most size bytes, anything else is probably another game's
+    /// Returns nullptr without changing the file if it can't be opened or mapped or has the wrong size
+    static Ptr CreateByMapping(const char *path, size_t size, size_t minimumSize);
+    
+    ~SaveFile();
+    SaveFile(const SaveFile &) = delete;
+    SaveFile &operator=(const SaveFile &) = delete;
+    
+    uint8_t *data() const { return _data; }
+    size_t size() const { return _size; }
+    
+    /// Size of the file before it was mapped, 0 if it was just created
+    size_t originalSize() const { return _originalSize; }
+    
+    /// Write size bytes from offset back to the file now rather than whenever the system gets to it
+    bool flush(size_t offset, size_t size);
+    
+private:
+    SaveFile(uint8_t *data, size_t size, size_t originalSize);
+    
+    uint8_t *_data;
+    size_t _size;
+    size_t _originalSize;
+};
+
+}
+
+#endif /* SaveFile_hpp */
@@ -7,18 +7,17 @@
 
 #include "Timer.hpp"
 #include "BitTwiddlingUtil.h"
+#include "EventScheduler.hpp"
 #include <cassert>
 
 using namespace MikoGB;
 
-static const uint32_t DivMax = 0xFFFF;
+static const uint32_t DivMask = 0xFFFF;
 
 bool Timer::updateWithCPUCycles(size_t cpuCycles) {
     // update DIV
-    _divRegister += cpuCycles;
-    if (_divRegister > DivMax) {
-        _divRegister -= DivMax;
-    }
+    // 16-bit counter, so wrap exactly regardless of how many cycles elapsed since the last update
+    _divRegister = (_divRegister + cpuCycles) & DivMask;
     
     // update TIMA
     bool overflowed = false;
@@ -37,6 +36,17 @@ bool Timer::updateWithCPUCycles(size_t cpuCycles) {
     return overflowed;
 }
 
+uint64_t Timer::cpuCyclesUntilOverflow() const {
+    if (!_timaEnabled) {
+        return EventScheduler::NoEvent;
+    }
+    // TIMA overflows on the increment past 0xFF
+    const uint64_t increments = 0x100 - _tima;
+    const uint64_t cycles = increments * _timaClockIncRate;
+    // The clock can already be past the increment rate if TAC was just changed to a faster one
+    return cycles > _timaClock ? cycles - _timaClock : 0;
+}
+
 uint8_t Timer::getDiv() const {
     // Div internally is a 16-bit counter, reading gives the most-significant 8 bits
     uint8_t divVal = (_divRegister & 0xFF00) >> 8;
@@ -9,6 +9,7 @@
 #define Timer_hpp
 
 #include <cstdlib>
+#include <cstdint>
 
 namespace MikoGB {
 
@@ -18,6 +19,9 @@ public:
     /// Returns whether or not there was a TIMA overflow which triggers an interrupt
     bool updateWithCPUCycles(size_t cpuCycles);
     
+    /// CPU cycles until TIMA next overflows, or EventScheduler::NoEvent if the timer is stopped
+    uint64_t cpuCyclesUntilOverflow() const;
+    
     uint8_t getDiv() const;
     void resetDiv();
     
@@ -19,6 +19,17 @@ static const uint16_t SerialControlRegister = 0xFF02; // Control bits for serial
 // that means that given the base clock speed of 2^22Hz, it will take 4096 cycles to transfer a byte
 static const int CyclesPerTransfer = 4096; // 2^22 base clock speed
 
+SerialController::SerialController(MemoryController *memoryController): _memoryController(memoryController) {
+    memoryController->registerIOHandlers(SerialDataRegister, SerialDataRegister, nullptr, [this](uint16_t, uint8_t val) {
+        serialDataWillWrite(val);
+        return val;
+    });
+    memoryController->registerIOHandlers(SerialControlRegister, SerialControlRegister, nullptr, [this](uint16_t, uint8_t val) {
+        serialControlWillWrite(val);
+        return val;
+    });
+}
+
 void SerialController::serialDataWillWrite(uint8_t dataByte) const {
     uint8_t lastKnownByte = _memoryController->readByte(SerialDataRegister);
     if (lastKnownByte != dataByte) {
@@ -46,6 +57,14 @@ void SerialController::serialControlWillWrite(uint8_t controlByte) {
     }
 }
 
+void SerialController::reset() {
+    // Set directly rather than through _setState(), there's no transfer to report to the client
+    _state = SerialState::Idle;
+    _transferCounter = 0;
+    _incomingByteToCommit = 0;
+    _hasIncomingByte = false;
+}
+
 uint8_t SerialController::getCurrentDataByte() const {
     uint8_t dataByte = _memoryController->readByte(SerialDataRegister);
     return dataByte;
@@ -153,3 +172,11 @@ void SerialController::updateWithCPUCycles(int cycles) {
         }
     }
 }
+
+uint64_t SerialController::cpuCyclesUntilTransferComplete() const {
+    if (_state == SerialState::Transferring && _transferCounter > 0) {
+        return _transferCounter;
+    }
+    // Either idle or waiting on the other side
+    return EventScheduler::NoEvent;
+}
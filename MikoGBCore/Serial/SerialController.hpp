@@ -16,12 +16,15 @@ namespace MikoGB {
 
 class SerialController {
 public:
-    SerialController(MemoryController::Ptr &memoryController): _memoryController(memoryController) {}
+    SerialController(MemoryController *memoryController);
     using Ptr = std::shared_ptr<SerialController>;
     
     // CPU cycles are 4x instruction cycles. 4.2MHz (2^22)
     void updateWithCPUCycles(int cycles);
     
+    /// CPU cycles until an internally clocked transfer is expected to complete, or EventScheduler::NoEvent
+    uint64_t cpuCyclesUntilTransferComplete() const;
+    
     void serialDataWillWrite(uint8_t dataByte) const;
     void serialControlWillWrite(uint8_t controlByte);
     
@@ -33,8 +36,11 @@ public:
         _eventCallback = callback;
     }
     
+    /// Abandon any transfer and return to idle. The event callback is kept
+    void reset();
+    
 private:
-    MemoryController::Ptr &_memoryController;
+    MemoryController *const _memoryController;
     SerialEventCallback _eventCallback;
     
     enum class SerialState {
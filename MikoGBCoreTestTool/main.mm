@@ -9,6 +9,7 @@
 #import <ImageIO/ImageIO.h>
 #include "GameboyCore.hpp"
 #include <iostream>
+#include <chrono>
 
 using namespace std;
 
@@ -72,11 +73,13 @@ int main(int argc, const char * argv[]) {
     MikoGB::GameBoyCore gbCore;
     gbCore.prepTestROM();
     int numFrames = 0;
+    const auto start = chrono::steady_clock::now();
     while (gbCore.getPC() < 0xfa) {
         gbCore.emulateFrame();
         numFrames++;
     }
-    cout << "Emulated " << numFrames << " frames\n";
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "Emulated " << numFrames << " frames in " << elapsed.count() << "s (" << numFrames / elapsed.count() << " fps)\n";
     
     void (^tileMapBlock)(const MikoGB::PixelBuffer &) = ^void(const MikoGB::PixelBuffer &pixelBuffer) {
         writePNG(pixelBuffer, @"tileMap.png");
@@ -54,4 +54,22 @@ using namespace std;
     XCTAssertEqual(totalCycles, 161); // docs say it's a 160-cycle wait. May be a case of "close enough"
 }
 
+- (void)testFlagsRegisterAfterArithmetic {
+    vector<uint8_t> mem = {
+        0x31, 0xFE, 0xFF,   // LD SP, $FFFE
+        0x3E, 0x10,         // LD A, $10
+        0xD6, 0x10,         // SUB A, $10
+        0xF5,               // PUSH AF
+    };
+    
+    MikoGB::CPUCore core(mem.data(), mem.size());
+    for (int i = 0; i < 4; ++i) {
+        core.step();
+    }
+    // Z and N set. Flags must be correct in F when pushed, even if not yet read by anything else
+    XCTAssertEqual(core.mainMemory[0xFFFD], 0x00);
+    XCTAssertEqual(core.mainMemory[0xFFFC], 0xC0);
+    XCTAssertEqual(core.getFlagsRegister(), 0xC0);
+}
+
 @end
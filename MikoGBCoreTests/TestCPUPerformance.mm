@@ -0,0 +1,206 @@
+//
+//  TestCPUPerformance.mm
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#import <XCTest/XCTest.h>
+#include "CPUCore.hpp"
+#include "MemoryController.hpp"
+#include "GPUCore.hpp"
+#include <vector>
+
+using namespace std;
+
+@interface TestCPUPerformance : XCTestCase
+
+@end
+
+@implementation TestCPUPerformance
+
+- (void)testInstructionDispatchPerformance {
+    // Mix of loads, arithmetic, extended opcodes and jumps that loops forever
+    vector<uint8_t> mem = {
+        0x21, 0x00, 0xC0,   // LD HL, $C000
+        0x11, 0x00, 0xC1,   // LD DE, $C100
+        0x06, 0x40,         // LD B, $40
+        0x2A,               // LD A, (HL+)
+        0x12,               // LD (DE), A
+        0x13,               // INC DE
+        0x80,               // ADD A, B
+        0xA9,               // XOR C
+        0xCB, 0x37,         // SWAP A
+        0x05,               // DEC B
+        0x20, 0xF6,         // JR NZ, -10 (jump back to the LD A, (HL+))
+        0xC3, 0x00, 0x00,   // JP $0000
+    };
+    
+    MikoGB::CPUCore core(mem.data(), mem.size());
+    MikoGB::CPUCore *corePtr = &core; // blocks copy captured C++ objects, so capture a pointer instead
+    const int instructionCount = 1000000;
+    [self measureBlock:^{
+        for (int i = 0; i < instructionCount; ++i) {
+            corePtr->step();
+        }
+    }];
+    XCTAssertTrue(core.programCounter < mem.size());
+}
+
+- (void)testALUPerformance {
+    // Flag-setting arithmetic. Most of the flags are overwritten before anything reads them
+    vector<uint8_t> mem = {
+        0x06, 0x00,         // LD B, $00
+        0x80,               // ADD A, B
+        0x89,               // ADC A, C
+        0x92,               // SUB A, D
+        0xA3,               // AND A, E
+        0xB4,               // OR A, H
+        0xAD,               // XOR A, L
+        0xBA,               // CP A, D
+        0x0C,               // INC C
+        0x05,               // DEC B
+        0x20, 0xF5,         // JR NZ, -11 (jump back to the ADD)
+        0x18, 0xF1,         // JR -15 (jump back to the start)
+    };
+    
+    MikoGB::CPUCore core(mem.data(), mem.size());
+    MikoGB::CPUCore *corePtr = &core; // blocks copy captured C++ objects, so capture a pointer instead
+    const int instructionCount = 1000000;
+    [self measureBlock:^{
+        for (int i = 0; i < instructionCount; ++i) {
+            corePtr->step();
+        }
+    }];
+    XCTAssertTrue(core.programCounter < mem.size());
+}
+
+- (void)testMemoryAccessPerformance {
+    // Reads and writes typical of game code: ROM data, working RAM, VRAM and high RAM
+    MikoGB::MemoryController::Ptr memoryController = std::make_shared<MikoGB::MemoryController>();
+    XCTAssertTrue(memoryController->configureWithEmptyData());
+    MikoGB::MemoryController *memPtr = memoryController.get();
+    const int iterationCount = 1000000;
+    __block uint8_t sum = 0;
+    [self measureBlock:^{
+        for (int i = 0; i < iterationCount; ++i) {
+            const uint16_t offset = i & 0x0FFF;
+            const uint8_t romVal = memPtr->readByte(0x1000 + offset);
+            memPtr->setByte(0xC000 + offset, romVal + 1);
+            memPtr->setByte(0xD000 + offset, memPtr->readByte(0xC000 + offset));
+            memPtr->setByte(0x8000 + offset, memPtr->readByte(0xD000 + offset));
+            memPtr->setByte(0xFF80 + (i & 0x3F), romVal);
+            sum += memPtr->readByte(0x8000 + offset) + memPtr->readByte(0xFF80 + (i & 0x3F));
+        }
+    }];
+    XCTAssertEqual(memoryController->readByte(0xC000), 1);
+}
+
+- (void)testDMAFramePerformance {
+    // DMA typical of a CGB frame: a general purpose transfer of tiles, an H-blank transfer on every visible line and
+    // a sprite transfer to OAM
+    MikoGB::MemoryController::Ptr memoryController = std::make_shared<MikoGB::MemoryController>();
+    XCTAssertTrue(memoryController->configureWithEmptyData());
+    MikoGB::MemoryController *memPtr = memoryController.get();
+    const int frameCount = 1000;
+    [self measureBlock:^{
+        for (int frame = 0; frame < frameCount; ++frame) {
+            // 2 KiB from working RAM to VRAM
+            memPtr->setByte(0xFF51, 0xC0);
+            memPtr->setByte(0xFF52, 0x00);
+            memPtr->setByte(0xFF53, 0x00);
+            memPtr->setByte(0xFF54, 0x00);
+            memPtr->setByte(0xFF55, 0x7F);
+            
+            // 144 lines of 16 bytes from ROM to VRAM
+            memPtr->setByte(0xFF51, 0x10);
+            memPtr->setByte(0xFF52, 0x00);
+            memPtr->setByte(0xFF53, 0x08);
+            memPtr->setByte(0xFF54, 0x00);
+            memPtr->setByte(0xFF55, 0x80 | 143);
+            for (int line = 0; line < 144; ++line) {
+                memPtr->hBlankDMATransferStep();
+            }
+            
+            // Sprites from working RAM to OAM
+            memPtr->setByte(0xFF46, 0xD0);
+        }
+    }];
+    XCTAssertEqual(memoryController->readByte(0xFF55), 0xFF);
+}
+
+- (void)testBankedMemoryPerformance {
+    // Game code that switches ROM banks to read data, and reads and writes save RAM. 1 MiB MBC5 ROM with 32 KiB of RAM
+    vector<uint8_t> rom(1024 * 1024);
+    rom[0x147] = 0x1B;
+    rom[0x148] = 0x05;
+    rom[0x149] = 0x03;
+    for (size_t i = 0; i < rom.size(); i += 0x100) {
+        rom[i + 0xFF] = (uint8_t)(i >> 14); // bank number at the end of every 256 bytes
+    }
+    MikoGB::MemoryController::Ptr memoryController = std::make_shared<MikoGB::MemoryController>();
+    XCTAssertTrue(memoryController->configureWithROMData(rom.data(), rom.size()));
+    MikoGB::MemoryController *memPtr = memoryController.get();
+    memPtr->setByte(0x0000, 0x0A);
+    const int iterationCount = 1000000;
+    __block uint8_t sum = 0;
+    [self measureBlock:^{
+        for (int i = 0; i < iterationCount; ++i) {
+            if ((i & 0xFF) == 0) {
+                memPtr->setByte(0x2000, 1 + ((i >> 8) & 0x3F));
+                memPtr->setByte(0x4000, (i >> 8) & 0x03);
+            }
+            const uint16_t offset = i & 0x0FFF;
+            sum += memPtr->readByte(0x4000 + offset) + memPtr->readByte(0x7FFF - offset);
+            sum += memPtr->readByte(0xA000 + offset) + memPtr->readByte(0xB000 + offset);
+            if ((i & 0x0F) == 0) {
+                memPtr->setByte(0xA000 + offset, sum);
+            }
+        }
+    }];
+    XCTAssertTrue(memoryController->currentROMBank() > 0);
+}
+
+- (void)testScanlineRenderPerformance {
+    // Full frames of background, window and 10 sprites per line, with a fine X scroll and X-flipped sprites so that
+    // partial and flipped tile rows are drawn too
+    MikoGB::MemoryController::Ptr memoryController = std::make_shared<MikoGB::MemoryController>();
+    XCTAssertTrue(memoryController->configureWithEmptyData());
+    MikoGB::MemoryController *memPtr = memoryController.get();
+    MikoGB::GPUCore gpu(memPtr);
+    MikoGB::GPUCore *gpuPtr = &gpu; // blocks copy captured C++ objects, so capture a pointer instead
+    size_t lineCount = 0;
+    gpu.setScanlineCallback([&lineCount](const MikoGB::PixelBuffer &, size_t) {
+        lineCount += 1;
+    });
+    for (uint16_t addr = 0x8000; addr < 0xA000; ++addr) {
+        // Tile data, then tile codes
+        memPtr->setByte(addr, addr < 0x9800 ? (uint8_t)(addr * 37) : (uint8_t)addr);
+    }
+    for (uint16_t i = 0; i < 40; ++i) {
+        memPtr->setByte(0xFE00 + (i * 4), 16 + (i % 18) * 8);
+        memPtr->setByte(0xFE01 + (i * 4), 8 + (i * 4));
+        memPtr->setByte(0xFE02 + (i * 4), i);
+        memPtr->setByte(0xFE03 + (i * 4), (i & 1) ? 0x20 : 0x80);
+    }
+    memPtr->setByte(0xFF43, 3);     // SCX
+    memPtr->setByte(0xFF47, 0xE4);  // BGP
+    memPtr->setByte(0xFF48, 0xD2);  // OBP0
+    memPtr->setByte(0xFF49, 0x1B);  // OBP1
+    memPtr->setByte(0xFF4A, 72);    // WY
+    memPtr->setByte(0xFF4B, 87);    // WX
+    memPtr->setByte(0xFF40, 0xF3);  // LCD, window, sprites and background on
+    const int frameCount = 1000;
+    const size_t masterCyclesPerFrame = 456 * 2 * 154;
+    [self measureBlock:^{
+        for (int frame = 0; frame < frameCount; ++frame) {
+            // Scroll every frame so that lines are rendered rather than reused from the previous frame
+            memPtr->setByte(0xFF43, 3 + (frame & 1));
+            gpuPtr->updateWithMasterCycles(masterCyclesPerFrame);
+        }
+    }];
+    XCTAssertTrue(lineCount >= frameCount * 144);
+    XCTAssertEqual(gpu.getScanlineCounters().reusedCount, 0);
+}
+
+@end
@@ -0,0 +1,97 @@
+//
+//  TestEventScheduler.mm
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#import <XCTest/XCTest.h>
+#include "EventScheduler.hpp"
+#include "Timer.hpp"
+
+using namespace MikoGB;
+using EventSource = EventScheduler::EventSource;
+
+@interface TestEventScheduler : XCTestCase
+
+@end
+
+@implementation TestEventScheduler
+
+- (void)testEarliestEventIsDue {
+    EventScheduler scheduler;
+    // Every source is due immediately so that components schedule their first events
+    XCTAssertEqual(scheduler.nextEventMasterCycle(), 0);
+    XCTAssertTrue(scheduler.isEventDue(EventSource::GPU));
+    XCTAssertTrue(scheduler.isEventDue(EventSource::Serial));
+    scheduler.cancel(EventSource::Audio);
+    scheduler.cancel(EventSource::Serial);
+    scheduler.cancel(EventSource::Timer);
+    scheduler.cancel(EventSource::GPU);
+    XCTAssertEqual(scheduler.nextEventMasterCycle(), EventScheduler::NoEvent);
+
+    scheduler.schedule(EventSource::Timer, 100);
+    scheduler.schedule(EventSource::GPU, 40);
+    XCTAssertEqual(scheduler.nextEventMasterCycle(), 40);
+
+    // 16 CPU cycles is 32 master cycles at normal speed
+    XCTAssertFalse(scheduler.advance(16));
+    XCTAssertEqual(scheduler.masterCycles(), 32);
+    XCTAssertEqual(scheduler.cpuCycles(), 16);
+    XCTAssertTrue(scheduler.advance(4));
+    XCTAssertTrue(scheduler.isEventDue(EventSource::GPU));
+    XCTAssertFalse(scheduler.isEventDue(EventSource::Timer));
+
+    // Moving the earliest event later makes the next one the earliest
+    scheduler.scheduleAfterMasterCycles(EventSource::GPU, 200);
+    XCTAssertEqual(scheduler.nextEventMasterCycle(), 100);
+    scheduler.scheduleAfterCPUCycles(EventSource::Timer, EventScheduler::NoEvent);
+    XCTAssertEqual(scheduler.nextEventMasterCycle(), 240);
+}
+
+- (void)testDoubleSpeed {
+    EventScheduler scheduler;
+    scheduler.cancel(EventSource::GPU);
+    scheduler.cancel(EventSource::Audio);
+    scheduler.cancel(EventSource::Serial);
+    scheduler.setDoubleSpeed(true);
+    XCTAssertEqual(scheduler.masterCyclesForCPUCycles(8), 8);
+
+    scheduler.scheduleAfterCPUCycles(EventSource::Timer, 16);
+    XCTAssertFalse(scheduler.advance(12));
+    XCTAssertTrue(scheduler.advance(4));
+    XCTAssertEqual(scheduler.masterCycles(), 16);
+    XCTAssertEqual(scheduler.cpuCycles(), 16);
+
+    // Back at normal speed CPU cycles take twice as long
+    scheduler.setDoubleSpeed(false);
+    scheduler.scheduleAfterCPUCycles(EventSource::Timer, 16);
+    XCTAssertEqual(scheduler.deadline(EventSource::Timer), 48);
+    XCTAssertEqual(scheduler.cpuCyclesUntilNextEvent(), 16);
+
+    // An odd number of master cycles rounds up to the CPU cycle that reaches it
+    scheduler.schedule(EventSource::GPU, 21);
+    XCTAssertEqual(scheduler.cpuCyclesUntilNextEvent(), 3);
+    scheduler.cancel(EventSource::GPU);
+
+    // Rescheduling everything makes all sources due now
+    scheduler.scheduleAll();
+    XCTAssertEqual(scheduler.nextEventMasterCycle(), 16);
+    XCTAssertTrue(scheduler.isEventDue(EventSource::Audio));
+}
+
+- (void)testTimerOverflowDeadline {
+    Timer timer;
+    XCTAssertEqual(timer.cpuCyclesUntilOverflow(), EventScheduler::NoEvent);
+
+    // Enabled at 262144 Hz, TIMA increments every 16 CPU cycles
+    timer.setTAC(0x05);
+    timer.setTIMA(0xFE);
+    XCTAssertEqual(timer.cpuCyclesUntilOverflow(), 32);
+    XCTAssertFalse(timer.updateWithCPUCycles(20));
+    XCTAssertEqual(timer.cpuCyclesUntilOverflow(), 12);
+    XCTAssertFalse(timer.updateWithCPUCycles(11));
+    XCTAssertTrue(timer.updateWithCPUCycles(1));
+}
+
+@end
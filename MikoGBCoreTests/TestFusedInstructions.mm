@@ -0,0 +1,357 @@
+//
+//  TestFusedInstructions.mm
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#import <XCTest/XCTest.h>
+#include "CPUCore.hpp"
+#include "CPUInstruction.hpp"
+#include "TestCPUCoreUtilities.hpp"
+#include <vector>
+
+using namespace std;
+
+/// Execute the fused instruction at the program counter the same way CPUCore::step() would. Returns cycles or -1 if
+/// the bytes at the program counter aren't a recognized idiom
+static int _StepFused(MikoGB::CPUCore &core) {
+    const uint8_t *opcode = core.mainMemory + core.programCounter;
+    const MikoGB::CPUInstruction *instruction = MikoGB::CPUInstruction::LookupFusedInstruction(opcode, 8);
+    if (!instruction) {
+        return -1;
+    }
+    core.programCounter += instruction->size;
+    return instruction->func(opcode, core);
+}
+
+static void _AssertSameState(MikoGB::CPUCore &a, MikoGB::CPUCore &b) {
+    for (int i = 0; i < REGISTER_COUNT; ++i) {
+        if (i != REGISTER_F) {
+            XCTAssertEqual(a.registers[i], b.registers[i]);
+        }
+    }
+    XCTAssertEqual(a.getFlagsRegister(), b.getFlagsRegister());
+    XCTAssertEqual(a.programCounter, b.programCounter);
+    XCTAssertEqual(a.stackPointer, b.stackPointer);
+}
+
+/// Run until the program counter reaches pc, using fused instructions where possible. Returns elapsed cycles
+static int _RunFusedUntil(MikoGB::CPUCore &core, uint16_t pc) {
+    int cycles = 0;
+    while (core.programCounter != pc) {
+        int fusedCycles = _StepFused(core);
+        cycles += fusedCycles >= 0 ? fusedCycles : core.step();
+    }
+    return cycles;
+}
+
+static int _StepUntil(MikoGB::CPUCore &core, uint16_t pc) {
+    int cycles = 0;
+    while (core.programCounter != pc) {
+        cycles += core.step();
+    }
+    return cycles;
+}
+
+static vector<uint8_t> _SequentialBytes(size_t count) {
+    vector<uint8_t> bytes(count);
+    for (size_t i = 0; i < count; ++i) {
+        bytes[i] = (uint8_t)(i * 7 + 3);
+    }
+    return bytes;
+}
+
+@interface TestFusedInstructions : XCTestCase
+
+@end
+
+@implementation TestFusedInstructions
+
+- (void)testCopyByte {
+    vector<uint8_t> mem = {
+        0x2A,   // LD A, (HL+)
+        0x12,   // LD (DE), A
+        0x13,   // INC DE
+    };
+    map<uint16_t, uint8_t> otherVals = { { 0xC000, 0x5A } };
+    vector<uint8_t> allocatedMemory = createGBMemory(mem, otherVals);
+    MikoGB::CPUCore fused(allocatedMemory.data(), allocatedMemory.size());
+    MikoGB::CPUCore stepped(allocatedMemory.data(), allocatedMemory.size());
+    for (MikoGB::CPUCore *core : { &fused, &stepped }) {
+        core->registers[REGISTER_H] = 0xC0;
+        core->registers[REGISTER_L] = 0x00;
+        core->registers[REGISTER_D] = 0xC1;
+        core->registers[REGISTER_E] = 0xFF;
+    }
+    
+    int steppedCycles = 0;
+    for (int i = 0; i < 3; ++i) {
+        steppedCycles += stepped.step();
+    }
+    XCTAssertEqual(_StepFused(fused), steppedCycles);
+    _AssertSameState(fused, stepped);
+    XCTAssertEqual(fused.mainMemory[0xC1FF], 0x5A);
+    XCTAssertEqual(fused.getHLptr(), 0xC001);
+    XCTAssertEqual(fused.getDEptr(), 0xC200);
+    XCTAssertEqual(fused.fusionCounters.fusedCount, 1);
+    XCTAssertEqual(fused.fusionCounters.fallbackCount, 0);
+}
+
+- (void)testCopyByteToVRAMIsNotFused {
+    vector<uint8_t> mem = {
+        0x2A,   // LD A, (HL+)
+        0x12,   // LD (DE), A
+        0x13,   // INC DE
+    };
+    map<uint16_t, uint8_t> otherVals = { { 0xC000, 0x5A } };
+    vector<uint8_t> allocatedMemory = createGBMemory(mem, otherVals);
+    MikoGB::CPUCore core(allocatedMemory.data(), allocatedMemory.size());
+    core.registers[REGISTER_H] = 0xC0;
+    core.registers[REGISTER_D] = 0x80;
+    
+    // Only the load executes
+    XCTAssertEqual(_StepFused(core), 2);
+    XCTAssertEqual(core.programCounter, 1);
+    XCTAssertEqual(core.registers[REGISTER_A], 0x5A);
+    XCTAssertEqual(core.getHLptr(), 0xC001);
+    XCTAssertEqual(core.mainMemory[0x8000], 0x00);
+    XCTAssertEqual(core.fusionCounters.fusedCount, 0);
+    XCTAssertEqual(core.fusionCounters.fallbackCount, 1);
+}
+
+- (void)testCopyByteDuringHBlankDMAIsNotFused {
+    vector<uint8_t> mem = {
+        0x2A,   // LD A, (HL+)
+        0x12,   // LD (DE), A
+        0x13,   // INC DE
+    };
+    map<uint16_t, uint8_t> otherVals = { { 0xC000, 0x5A } };
+    vector<uint8_t> allocatedMemory = createGBMemory(mem, otherVals);
+    MikoGB::CPUCore fused(allocatedMemory.data(), allocatedMemory.size());
+    MikoGB::CPUCore stepped(allocatedMemory.data(), allocatedMemory.size());
+    for (MikoGB::CPUCore *core : { &fused, &stepped }) {
+        core->registers[REGISTER_H] = 0xC0;
+        core->registers[REGISTER_L] = 0x00;
+        core->registers[REGISTER_D] = 0xC1;
+        core->registers[REGISTER_E] = 0xF0;
+    }
+    
+    // An H-blank DMA from the block DE points to. It could copy between any two of the instructions
+    MikoGB::MemoryController &memoryController = *fused.memoryController;
+    memoryController.configureWithEmptyData();
+    memoryController.setByte(0xFF51, 0xC1);
+    memoryController.setByte(0xFF52, 0xF0);
+    memoryController.setByte(0xFF53, 0x80);
+    memoryController.setByte(0xFF54, 0x00);
+    memoryController.setByte(0xFF55, 0x80);
+    XCTAssertTrue(memoryController.isHBlankTransferActive());
+    
+    // Only the load executes, then the rest steps like the unfused instructions
+    XCTAssertEqual(_StepFused(fused), 2);
+    XCTAssertEqual(fused.programCounter, 1);
+    XCTAssertEqual(fused.mainMemory[0xC1F0], 0x00);
+    XCTAssertEqual(fused.fusionCounters.fusedCount, 0);
+    XCTAssertEqual(fused.fusionCounters.fallbackCount, 1);
+    const int fusedCycles = 2 + fused.step() + fused.step();
+    int steppedCycles = 0;
+    for (int i = 0; i < 3; ++i) {
+        steppedCycles += stepped.step();
+    }
+    XCTAssertEqual(fusedCycles, steppedCycles);
+    _AssertSameState(fused, stepped);
+    XCTAssertEqual(fused.mainMemory[0xC1F0], stepped.mainMemory[0xC1F0]);
+    
+    // The test memory controller is shared, so stop the transfer
+    memoryController.setByte(0xFF55, 0x00);
+    XCTAssertFalse(memoryController.isHBlankTransferActive());
+}
+
+- (void)testDecrementJumpNotZero {
+    vector<uint8_t> mem = {
+        0x0D,       // DEC C
+        0x20, 0xFD, // JR NZ, -3 (jump back to the DEC)
+    };
+    MikoGB::CPUCore fused(mem.data(), mem.size());
+    MikoGB::CPUCore stepped(mem.data(), mem.size());
+    fused.registers[REGISTER_C] = 3;
+    stepped.registers[REGISTER_C] = 3;
+    
+    // Two iterations jump back, the last falls through
+    for (int i = 0; i < 3; ++i) {
+        int steppedCycles = stepped.step();
+        steppedCycles += stepped.step();
+        XCTAssertEqual(_StepFused(fused), steppedCycles);
+        _AssertSameState(fused, stepped);
+    }
+    XCTAssertEqual(fused.registers[REGISTER_C], 0);
+    XCTAssertEqual(fused.programCounter, 3);
+    XCTAssertEqual(fused.fusionCounters.fusedCount, 3);
+}
+
+- (void)testPollCompareJump {
+    vector<uint8_t> mem = {
+        0xF0, 0x44, // LD A, (LY)
+        0xFE, 0x90, // CP $90
+        0x20, 0xFA, // JR NZ, -6 (jump back to the LD)
+    };
+    map<uint16_t, uint8_t> otherVals = { { 0xFF44, 0x8F } };
+    vector<uint8_t> allocatedMemory = createGBMemory(mem, otherVals);
+    MikoGB::CPUCore fused(allocatedMemory.data(), allocatedMemory.size());
+    MikoGB::CPUCore stepped(allocatedMemory.data(), allocatedMemory.size());
+    
+    for (uint8_t ly = 0x8F; ly <= 0x90; ++ly) {
+        fused.mainMemory[0xFF44] = ly;
+        stepped.mainMemory[0xFF44] = ly;
+        int steppedCycles = 0;
+        for (int i = 0; i < 3; ++i) {
+            steppedCycles += stepped.step();
+        }
+        XCTAssertEqual(_StepFused(fused), steppedCycles);
+        _AssertSameState(fused, stepped);
+    }
+    XCTAssertEqual(fused.programCounter, 6);
+    XCTAssertTrue(fused.getFlag(MikoGB::FlagBit::Zero));
+}
+
+- (void)testInterruptsEnabledFallsBack {
+    vector<uint8_t> mem = {
+        0x05,       // DEC B
+        0x20, 0xFD, // JR NZ, -3 (jump back to the DEC)
+    };
+    MikoGB::CPUCore core(mem.data(), mem.size());
+    core.registers[REGISTER_B] = 2;
+    core.interruptState = MikoGB::CPUCore::InterruptState::Enabled;
+    
+    XCTAssertEqual(_StepFused(core), 1);
+    XCTAssertEqual(core.programCounter, 1);
+    XCTAssertEqual(core.registers[REGISTER_B], 1);
+    XCTAssertEqual(core.fusionCounters.fallbackCount, 1);
+}
+
+- (void)testUnrecognizedSequence {
+    vector<uint8_t> mem = {
+        0x2A,   // LD A, (HL+)
+        0x12,   // LD (DE), A
+        0x23,   // INC HL
+    };
+    MikoGB::CPUCore core(mem.data(), mem.size());
+    XCTAssertEqual(_StepFused(core), -1);
+}
+
+- (void)testCopyLoopBC {
+    vector<uint8_t> mem = {
+        0x2A,       // LD A, (HL+)
+        0x12,       // LD (DE), A
+        0x13,       // INC DE
+        0x0B,       // DEC BC
+        0x78,       // LD A, B
+        0xB1,       // OR C
+        0x20, 0xF8, // JR NZ, -8
+    };
+    map<uint16_t, vector<uint8_t>> otherVals = { { 0x4000, _SequentialBytes(300) } };
+    vector<uint8_t> allocatedMemory = createGBMemory(mem, otherVals);
+    MikoGB::CPUCore fused(allocatedMemory.data(), allocatedMemory.size());
+    MikoGB::CPUCore stepped(allocatedMemory.data(), allocatedMemory.size());
+    for (MikoGB::CPUCore *core : { &fused, &stepped }) {
+        core->registers[REGISTER_B] = 0x01;
+        core->registers[REGISTER_C] = 0x2C; // 300 bytes
+        core->registers[REGISTER_H] = 0x40;
+        core->registers[REGISTER_D] = 0xC1;
+    }
+    
+    XCTAssertEqual(_RunFusedUntil(fused, 8), _StepUntil(stepped, 8));
+    _AssertSameState(fused, stepped);
+    XCTAssertEqual(memcmp(fused.mainMemory + 0xC100, stepped.mainMemory + 0xC100, 300), 0);
+    XCTAssertEqual(memcmp(fused.mainMemory + 0xC100, fused.mainMemory + 0x4000, 300), 0);
+    XCTAssertEqual(fused.getBCptr(), 0);
+    XCTAssertEqual(fused.getDEptr(), 0xC100 + 300);
+    // 13 cycles per iteration, so 8 fit in a step without running past one scanline. Each step executes its last
+    // iteration normally
+    XCTAssertEqual(fused.fusionCounters.bulkLoopCount, 38);
+    XCTAssertEqual(fused.fusionCounters.acceleratedCycles, (300 - 38) * 13);
+}
+
+- (void)testCopyLoopOverlapping {
+    // Copying forward onto an overlapping destination repeats the first bytes rather than moving them
+    vector<uint8_t> mem = {
+        0x2A,       // LD A, (HL+)
+        0x12,       // LD (DE), A
+        0x13,       // INC DE
+        0x05,       // DEC B
+        0x20, 0xFA, // JR NZ, -6
+    };
+    map<uint16_t, vector<uint8_t>> otherVals = { { 0xC000, { 0x11, 0x22, 0x33 } } };
+    vector<uint8_t> allocatedMemory = createGBMemory(mem, otherVals);
+    MikoGB::CPUCore fused(allocatedMemory.data(), allocatedMemory.size());
+    MikoGB::CPUCore stepped(allocatedMemory.data(), allocatedMemory.size());
+    for (MikoGB::CPUCore *core : { &fused, &stepped }) {
+        core->registers[REGISTER_B] = 30;
+        core->registers[REGISTER_H] = 0xC0;
+        core->registers[REGISTER_D] = 0xC0;
+        core->registers[REGISTER_E] = 0x03;
+    }
+    
+    XCTAssertEqual(_RunFusedUntil(fused, 6), _StepUntil(stepped, 6));
+    _AssertSameState(fused, stepped);
+    XCTAssertEqual(memcmp(fused.mainMemory + 0xC000, stepped.mainMemory + 0xC000, 40), 0);
+    XCTAssertEqual(fused.mainMemory[0xC000 + 30], 0x11);
+    XCTAssertEqual(fused.mainMemory[0xC000 + 32], 0x33);
+}
+
+- (void)testFillLoops {
+    vector<uint8_t> fillLoop8 = {
+        0x22,       // LD (HL+), A
+        0x0D,       // DEC C
+        0x20, 0xFC, // JR NZ, -4
+    };
+    vector<uint8_t> clearLoopBC = {
+        0xAF,       // XOR A
+        0x22,       // LD (HL+), A
+        0x0B,       // DEC BC
+        0x79,       // LD A, C
+        0xB0,       // OR B
+        0x20, 0xF9, // JR NZ, -7
+    };
+    for (const vector<uint8_t> &mem : { fillLoop8, clearLoopBC }) {
+        map<uint16_t, vector<uint8_t>> otherVals = { { 0xC000, vector<uint8_t>(512, 0xEE) } };
+        vector<uint8_t> allocatedMemory = createGBMemory(mem, otherVals);
+        MikoGB::CPUCore fused(allocatedMemory.data(), allocatedMemory.size());
+        MikoGB::CPUCore stepped(allocatedMemory.data(), allocatedMemory.size());
+        for (MikoGB::CPUCore *core : { &fused, &stepped }) {
+            core->registers[REGISTER_A] = 0x5A;
+            core->registers[REGISTER_B] = 0x01;
+            core->registers[REGISTER_C] = 0x00; // 256 iterations for either counter
+            core->registers[REGISTER_H] = 0xC0;
+            core->registers[REGISTER_L] = 0x10;
+        }
+        
+        const uint16_t loopEnd = mem.size();
+        XCTAssertEqual(_RunFusedUntil(fused, loopEnd), _StepUntil(stepped, loopEnd));
+        _AssertSameState(fused, stepped);
+        XCTAssertEqual(memcmp(fused.mainMemory + 0xC000, stepped.mainMemory + 0xC000, 512), 0);
+        XCTAssertEqual(fused.getHLptr(), 0xC110);
+        XCTAssertGreaterThan(fused.fusionCounters.acceleratedCycles, 0);
+    }
+}
+
+- (void)testFillLoopIntoIORegistersIsNotAccelerated {
+    vector<uint8_t> mem = {
+        0x22,       // LD (HL+), A
+        0x05,       // DEC B
+        0x20, 0xFC, // JR NZ, -4
+    };
+    MikoGB::CPUCore core(mem.data(), mem.size());
+    core.registers[REGISTER_B] = 4;
+    core.registers[REGISTER_H] = 0xFF;
+    core.registers[REGISTER_L] = 0x10;
+    
+    // Only the store executes
+    XCTAssertEqual(_StepFused(core), 2);
+    XCTAssertEqual(core.programCounter, 1);
+    XCTAssertEqual(core.getHLptr(), 0xFF11);
+    XCTAssertEqual(core.fusionCounters.bulkLoopCount, 0);
+    XCTAssertEqual(core.fusionCounters.fallbackCount, 1);
+}
+
+@end
@@ -0,0 +1,81 @@
+//
+//  TestGPUCore.mm
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#import <XCTest/XCTest.h>
+#include "GPUCore.hpp"
+#include "MemoryController.hpp"
+#include <vector>
+
+using namespace std;
+using namespace MikoGB;
+
+@interface TestGPUCore : XCTestCase
+
+@end
+
+@implementation TestGPUCore
+
+- (void)testUnchangedScanlinesAreReused {
+    MemoryController::Ptr memoryController = make_shared<MemoryController>();
+    XCTAssertTrue(memoryController->configureWithEmptyData());
+    GPUCore gpu(memoryController.get());
+    vector<vector<uint8_t>> lines(144);
+    size_t unchangedCount = 0;
+    gpu.setScanlineCallback([&](const PixelBuffer &buffer, size_t lineNum) {
+        vector<uint8_t> line;
+        for (const Pixel &px : buffer.pixels) {
+            line.push_back(px.red);
+        }
+        if (gpu.isScanlineUnchanged()) {
+            XCTAssertTrue(line == lines[lineNum]);
+            unchangedCount += 1;
+        }
+        lines[lineNum] = line;
+    });
+    for (uint16_t addr = 0x8000; addr < 0xA000; ++addr) {
+        // Tile data, then tile codes
+        memoryController->setByte(addr, addr < 0x9800 ? (uint8_t)(addr * 37) : (uint8_t)addr);
+    }
+    memoryController->setByte(0xFF47, 0xE4);
+    memoryController->setByte(0xFF40, 0x93); // LCD, sprites and background on with tiles from 0x8000
+    
+    // Returns how many lines were rendered in a frame, after checking that the rest were reused
+    auto renderFrame = [&]() {
+        const ScanlineCounters before = gpu.getScanlineCounters();
+        unchangedCount = 0;
+        gpu.updateWithMasterCycles(456 * 2 * 154);
+        const ScanlineCounters &after = gpu.getScanlineCounters();
+        XCTAssertEqual(after.renderedCount + after.reusedCount - before.renderedCount - before.reusedCount, 144);
+        XCTAssertEqual(after.reusedCount - before.reusedCount, unchangedCount);
+        return after.renderedCount - before.renderedCount;
+    };
+    XCTAssertEqual(renderFrame(), 144);
+    XCTAssertEqual(renderFrame(), 0);
+    
+    // Writing what's already in VRAM or OAM changes nothing
+    memoryController->setByte(0x8000, 0x00);
+    memoryController->setByte(0xFE00, 0x00);
+    XCTAssertEqual(renderFrame(), 0);
+    
+    // But other writes to VRAM, OAM, registers and palettes do
+    memoryController->setByte(0x8000, 0xFF);
+    XCTAssertEqual(renderFrame(), 144);
+    memoryController->setByte(0xFE00, 0x20);
+    XCTAssertEqual(renderFrame(), 144);
+    memoryController->setByte(0xFF43, 0x01);
+    XCTAssertEqual(renderFrame(), 144);
+    memoryController->setByte(0xFF47, 0x1B);
+    XCTAssertEqual(renderFrame(), 144);
+    XCTAssertEqual(renderFrame(), 0);
+    
+    gpu.reset();
+    memoryController->setByte(0xFF40, 0x00);
+    memoryController->setByte(0xFF40, 0x93);
+    XCTAssertEqual(renderFrame(), 144);
+}
+
+@end
@@ -0,0 +1,109 @@
+//
+//  TestIdleLoopDetector.mm
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#import <XCTest/XCTest.h>
+#include "CPUCore.hpp"
+#include "IdleLoopDetector.hpp"
+#include <vector>
+
+using namespace std;
+using namespace MikoGB;
+using EventSource = EventScheduler::EventSource;
+
+/// Clear out the shared test memory controller's schedule and put the next event cpuCycles from now
+static void _ScheduleNextEvent(CPUCore &core, uint64_t cpuCycles) {
+    EventScheduler &scheduler = core.memoryController->scheduler;
+    scheduler.setDoubleSpeed(false);
+    for (size_t i = 0; i < (size_t)EventSource::Count; ++i) {
+        scheduler.cancel((EventSource)i);
+    }
+    scheduler.scheduleAfterCPUCycles(EventSource::GPU, cpuCycles);
+}
+
+@interface TestIdleLoopDetector : XCTestCase
+
+@end
+
+@implementation TestIdleLoopDetector
+
+- (void)testPollingLoopIsSkipped {
+    vector<uint8_t> mem = {
+        0xF0, 0x44,         // LDH A, (LY)
+        0xFE, 0x90,         // CP $90
+        0x20, 0xFA,         // JR NZ, -6
+    };
+    CPUCore core(mem.data(), mem.size());
+    core.registers[REGISTER_A] = 0x10;
+    IdleLoopDetector detector;
+    _ScheduleNextEvent(core, 1000);
+    const uint64_t now = core.memoryController->scheduler.cpuCycles();
+
+    // One iteration is 8 instruction cycles, 32 CPU cycles. The first jump back only records the state
+    XCTAssertEqual(detector.loopDidJumpBack(core, 4, 2, now + 32), 0);
+    XCTAssertEqual(detector.counters().detectedLoopCount, 0);
+
+    // The same state again means nothing changes until the event. Iterations ending at 96, 128 ... 992 can be skipped
+    // but the one ending at 1024 would cross the event, so it has to run
+    XCTAssertEqual(detector.loopDidJumpBack(core, 4, 2, now + 64), 29 * 32);
+    XCTAssertEqual(detector.counters().detectedLoopCount, 1);
+    XCTAssertEqual(detector.counters().skipCount, 1);
+    XCTAssertEqual(detector.counters().skippedCycles, 29 * 32);
+
+    // A different state after an iteration means the loop is doing something
+    core.registers[REGISTER_A] = 0x11;
+    XCTAssertEqual(detector.loopDidJumpBack(core, 4, 2, now + 64 + 29 * 32 + 32), 0);
+    XCTAssertEqual(detector.counters().skipCount, 1);
+}
+
+- (void)testEventsAndInterruptsRestartDetection {
+    vector<uint8_t> mem = {
+        0xF0, 0x41,         // LDH A, (STAT)
+        0xE6, 0x03,         // AND $03
+        0x20, 0xFA,         // JR NZ, -6
+    };
+    CPUCore core(mem.data(), mem.size());
+    IdleLoopDetector detector;
+    _ScheduleNextEvent(core, 1000);
+    const uint64_t now = core.memoryController->scheduler.cpuCycles();
+
+    XCTAssertEqual(detector.loopDidJumpBack(core, 4, 2, now + 32), 0);
+    // An event during the iteration may have changed what it read
+    core.memoryController->runDueEvents();
+    XCTAssertEqual(detector.loopDidJumpBack(core, 4, 2, now + 64), 0);
+    // As may an interrupt handler
+    detector.interrupted();
+    XCTAssertEqual(detector.loopDidJumpBack(core, 4, 2, now + 96), 0);
+    XCTAssertTrue(detector.loopDidJumpBack(core, 4, 2, now + 128) > 0);
+}
+
+- (void)testLoopsWithSideEffectsAreNotSkipped {
+    vector<uint8_t> mem = {
+        0x77,               // LD (HL), A
+        0x18, 0xFD,         // JR -3
+        0xF0, 0x04,         // LDH A, (DIV)
+        0xFE, 0x90,         // CP $90
+        0x20, 0xFA,         // JR NZ, -6
+    };
+    CPUCore core(mem.data(), mem.size());
+    IdleLoopDetector detector;
+    _ScheduleNextEvent(core, 1000);
+    const uint64_t now = core.memoryController->scheduler.cpuCycles();
+
+    // Writes memory
+    for (int i = 1; i <= 3; ++i) {
+        XCTAssertEqual(detector.loopDidJumpBack(core, 1, 2, now + i * 16), 0);
+    }
+
+    // DIV changes without any event
+    core.programCounter = 3;
+    for (int i = 1; i <= 3; ++i) {
+        XCTAssertEqual(detector.loopDidJumpBack(core, 7, 2, now + 64 + i * 32), 0);
+    }
+    XCTAssertEqual(detector.counters().detectedLoopCount, 0);
+}
+
+@end
@@ -0,0 +1,148 @@
+//
+//  TestInstructionBlockCache.mm
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#import <XCTest/XCTest.h>
+#include "InstructionBlockCache.hpp"
+#include <vector>
+
+using namespace std;
+
+/// 64 KiB MBC1 ROM (4 banks) with distinct code at the start of banks 1 and 2
+static vector<uint8_t> _CreateBankedROM() {
+    vector<uint8_t> rom(0x4000 * 4, 0);
+    rom[0x147] = 0x01; // MBC1
+    rom[0x148] = 0x01; // 64 KiB
+    rom[0x149] = 0x00; // No RAM
+    
+    // Bank 0
+    rom[0x100] = 0x00; // NOP
+    rom[0x101] = 0xC3; // JP $4000
+    rom[0x102] = 0x00;
+    rom[0x103] = 0x40;
+    
+    // Bank 1
+    rom[0x4000] = 0x3E; // LD A, $11
+    rom[0x4001] = 0x11;
+    rom[0x4002] = 0xCB; // SWAP A
+    rom[0x4003] = 0x37;
+    rom[0x4004] = 0x18; // JR -6
+    rom[0x4005] = 0xFA;
+    
+    // Bank 2
+    rom[0x8000] = 0x06; // LD B, $22
+    rom[0x8001] = 0x22;
+    return rom;
+}
+
+@interface TestInstructionBlockCache : XCTestCase
+
+@end
+
+@implementation TestInstructionBlockCache
+
+- (void)testBlockDecoding {
+    vector<uint8_t> rom = _CreateBankedROM();
+    MikoGB::MemoryController::Ptr mem = make_shared<MikoGB::MemoryController>();
+    XCTAssertTrue(mem->configureWithROMData(rom.data(), rom.size()));
+    MikoGB::InstructionBlockCache cache;
+    
+    // Boot ROM is still mapped over the start of ROM so nothing should be cached
+    XCTAssertTrue(cache.lookup(mem.get(), 0x0000) == nullptr);
+    mem->setByte(0xFF50, 0x01);
+    
+    const MikoGB::DecodedInstruction *first = cache.lookup(mem.get(), 0x4000);
+    XCTAssertTrue(first != nullptr);
+    XCTAssertEqual(first->bytes[0], 0x3E);
+    XCTAssertEqual(first->bytes[1], 0x11);
+    XCTAssertEqual(first->size, 2);
+    
+    // Sequential lookups walk the block
+    const MikoGB::DecodedInstruction *second = cache.lookup(mem.get(), 0x4002);
+    XCTAssertTrue(second == first + 1);
+    XCTAssertEqual(second->bytes[0], 0xCB);
+    XCTAssertEqual(second->bytes[1], 0x37);
+    XCTAssertEqual(second->size, 2);
+    const MikoGB::DecodedInstruction *third = cache.lookup(mem.get(), 0x4004);
+    XCTAssertTrue(third == first + 2);
+    XCTAssertEqual(third->bytes[0], 0x18);
+    
+    // The jump ends the block, so jumping back finds the same block again rather than decoding
+    XCTAssertTrue(cache.lookup(mem.get(), 0x4000) == first);
+    XCTAssertEqual(cache.blockCount(), 1);
+    
+    // Bank 0 is cached too
+    const MikoGB::DecodedInstruction *bank0 = cache.lookup(mem.get(), 0x0100);
+    XCTAssertTrue(bank0 != nullptr);
+    XCTAssertEqual(bank0->bytes[0], 0x00);
+}
+
+- (void)testBankSwitching {
+    vector<uint8_t> rom = _CreateBankedROM();
+    MikoGB::MemoryController::Ptr mem = make_shared<MikoGB::MemoryController>();
+    XCTAssertTrue(mem->configureWithROMData(rom.data(), rom.size()));
+    mem->setByte(0xFF50, 0x01);
+    MikoGB::InstructionBlockCache cache;
+    
+    const MikoGB::DecodedInstruction *bank1 = cache.lookup(mem.get(), 0x4000);
+    XCTAssertEqual(bank1->bytes[0], 0x3E);
+    
+    // Switch to bank 2. Same address must now decode different code
+    mem->setByte(0x2000, 0x02);
+    const MikoGB::DecodedInstruction *bank2 = cache.lookup(mem.get(), 0x4000);
+    XCTAssertTrue(bank2 != bank1);
+    XCTAssertEqual(bank2->bytes[0], 0x06);
+    XCTAssertEqual(bank2->bytes[1], 0x22);
+    
+    // And switching back reuses the bank 1 block
+    mem->setByte(0x2000, 0x01);
+    XCTAssertTrue(cache.lookup(mem.get(), 0x4000) == bank1);
+    XCTAssertEqual(cache.blockCount(), 2);
+}
+
+- (void)testBlockProfile {
+    vector<uint8_t> rom = _CreateBankedROM();
+    MikoGB::MemoryController::Ptr mem = make_shared<MikoGB::MemoryController>();
+    XCTAssertTrue(mem->configureWithROMData(rom.data(), rom.size()));
+    mem->setByte(0xFF50, 0x01);
+    MikoGB::InstructionBlockCache cache;
+    
+    // Run the bank 0 entry once and the bank 1 loop 3 times
+    cache.lookup(mem.get(), 0x0100);
+    cache.lookup(mem.get(), 0x0101);
+    for (int i = 0; i < 3; ++i) {
+        cache.lookup(mem.get(), 0x4000);
+        cache.lookup(mem.get(), 0x4002);
+        cache.lookup(mem.get(), 0x4004);
+    }
+    
+    vector<MikoGB::InstructionBlockProfile> profile = cache.hottestBlocks(5);
+    XCTAssertEqual(profile.size(), 2);
+    XCTAssertEqual(profile[0].romBank, 1);
+    XCTAssertEqual(profile[0].addr, 0x4000);
+    XCTAssertEqual(profile[0].instructionCount, 3);
+    XCTAssertEqual(profile[0].entryCount, 3);
+    XCTAssertEqual(profile[1].romBank, 0);
+    XCTAssertEqual(profile[1].addr, 0x0100);
+    XCTAssertEqual(profile[1].instructionCount, 2);
+    XCTAssertEqual(profile[1].entryCount, 1);
+    
+    XCTAssertEqual(cache.hottestBlocks(1).size(), 1);
+}
+
+- (void)testRAMIsNotCached {
+    vector<uint8_t> rom = _CreateBankedROM();
+    MikoGB::MemoryController::Ptr mem = make_shared<MikoGB::MemoryController>();
+    XCTAssertTrue(mem->configureWithROMData(rom.data(), rom.size()));
+    mem->setByte(0xFF50, 0x01);
+    MikoGB::InstructionBlockCache cache;
+    
+    XCTAssertTrue(cache.lookup(mem.get(), 0xC000) == nullptr); // WRAM
+    XCTAssertTrue(cache.lookup(mem.get(), 0xFF80) == nullptr); // HRAM
+    XCTAssertEqual(cache.blockCount(), 0);
+}
+
+@end
@@ -0,0 +1,219 @@
+//
+//  TestInstructionJIT.mm
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#import <XCTest/XCTest.h>
+#include "CPUCore.hpp"
+#include "CPUInstruction.hpp"
+#include "InstructionJIT.hpp"
+#include <vector>
+
+using namespace std;
+
+/// Decode count instructions from addr in the core's memory, the same way the instruction cache does
+static vector<MikoGB::DecodedInstruction> _Decode(const MikoGB::CPUCore &core, uint16_t addr, size_t count) {
+    vector<MikoGB::DecodedInstruction> instructions;
+    for (size_t i = 0; i < count; ++i) {
+        MikoGB::DecodedInstruction decoded;
+        memcpy(decoded.bytes, core.mainMemory + addr, sizeof(decoded.bytes));
+        const MikoGB::CPUInstruction &instruction = MikoGB::CPUInstruction::LookupInstruction(decoded.bytes);
+        decoded.func = instruction.func;
+        decoded.size = instruction.size;
+        instructions.push_back(decoded);
+        addr += decoded.size;
+    }
+    return instructions;
+}
+
+static const MikoGB::NativeBlock *_Compile(MikoGB::InstructionJIT &jit, const MikoGB::CPUCore &core, size_t count) {
+    const vector<MikoGB::DecodedInstruction> instructions = _Decode(core, core.programCounter, count);
+    return jit.compile(core, instructions.data(), instructions.size(), 0, core.programCounter);
+}
+
+@interface TestInstructionJIT : XCTestCase
+
+@end
+
+@implementation TestInstructionJIT
+
+- (void)testNativeBlockMatchesStepping {
+    if (!MikoGB::InstructionJIT::IsSupported()) {
+        return;
+    }
+    vector<uint8_t> code = {
+        0x06, 0x12,         // LD B, $12
+        0x48,               // LD C, B
+        0x03,               // INC BC
+        0x21, 0x00, 0xC0,   // LD HL, $C000
+        0x3E, 0x5A,         // LD A, $5A
+        0x77,               // LD (HL), A
+        0x80,               // ADD A, B
+        0x31, 0xFE, 0xDF,   // LD SP, $DFFE
+        0xC5,               // PUSH BC
+        0xD1,               // POP DE
+        0x1B,               // DEC DE
+        0x2B,               // DEC HL
+        0xCB, 0x37,         // SWAP A
+        0x18, 0xEA,         // JR -22
+    };
+    const size_t instructionCount = 14;
+    MikoGB::CPUCore native(code.data(), code.size());
+    MikoGB::CPUCore stepped(code.data(), code.size());
+    stepped.setJITEnabled(false);
+    
+    MikoGB::InstructionJIT jit;
+    const MikoGB::NativeBlock *block = _Compile(jit, native, instructionCount);
+    XCTAssertTrue(block != nullptr);
+    XCTAssertEqual(block->instructionCount, instructionCount);
+    const MikoGB::InstructionJIT::RunResult result = MikoGB::InstructionJIT::Run(*block, native, 1000);
+    XCTAssertEqual(result.instructionCount, instructionCount);
+    
+    int steppedCycles = 0;
+    for (size_t i = 0; i < instructionCount; ++i) {
+        steppedCycles += stepped.step();
+    }
+    XCTAssertEqual(result.cycles, steppedCycles);
+    for (int i = 0; i < REGISTER_COUNT; ++i) {
+        if (i != REGISTER_F) {
+            XCTAssertEqual(native.registers[i], stepped.registers[i]);
+        }
+    }
+    XCTAssertEqual(native.getFlagsRegister(), stepped.getFlagsRegister());
+    XCTAssertEqual(native.programCounter, stepped.programCounter);
+    XCTAssertEqual(native.programCounter, 0x0000);
+    XCTAssertEqual(native.stackPointer, stepped.stackPointer);
+    XCTAssertEqual(native.mainMemory[0xC000], 0x5A);
+    XCTAssertEqual(native.mainMemory[0xDFFC], stepped.mainMemory[0xDFFC]);
+    XCTAssertEqual(native.mainMemory[0xDFFD], stepped.mainMemory[0xDFFD]);
+}
+
+- (void)testNativeBlockStopsBeforeIOAndROMWrites {
+    if (!MikoGB::InstructionJIT::IsSupported()) {
+        return;
+    }
+    MikoGB::InstructionJIT jit;
+    
+    // Stops before the I/O write, with the program counter at it
+    vector<uint8_t> ioWrite = { 0x21, 0x40, 0xFF, 0x77, 0x00 }; // LD HL, $FF40; LD (HL), A; NOP
+    MikoGB::CPUCore core(ioWrite.data(), ioWrite.size());
+    const MikoGB::NativeBlock *block = _Compile(jit, core, 3);
+    XCTAssertEqual(block->instructionCount, 3);
+    MikoGB::InstructionJIT::RunResult result = MikoGB::InstructionJIT::Run(*block, core, 1000);
+    XCTAssertEqual(result.instructionCount, 1);
+    XCTAssertEqual(result.cycles, 3);
+    XCTAssertEqual(core.programCounter, 0x0003);
+    
+    // Nothing runs if the first instruction needs the interpreter
+    result = MikoGB::InstructionJIT::Run(*_Compile(jit, core, 2), core, 1000);
+    XCTAssertEqual(result.instructionCount, 0);
+    XCTAssertEqual(core.programCounter, 0x0003);
+    XCTAssertEqual(core.mainMemory[0xFF40], 0x00);
+    
+    // Writing the ROM area may switch banks
+    vector<uint8_t> romWrite = { 0x21, 0x00, 0x20, 0x77 }; // LD HL, $2000; LD (HL), A
+    MikoGB::CPUCore romCore(romWrite.data(), romWrite.size());
+    result = MikoGB::InstructionJIT::Run(*_Compile(jit, romCore, 2), romCore, 1000);
+    XCTAssertEqual(result.instructionCount, 1);
+    
+    // A push with SP at 1 would wrap around to IE
+    vector<uint8_t> stackWrap = { 0x31, 0x01, 0x00, 0xC5 }; // LD SP, $0001; PUSH BC
+    MikoGB::CPUCore stackCore(stackWrap.data(), stackWrap.size());
+    result = MikoGB::InstructionJIT::Run(*_Compile(jit, stackCore, 2), stackCore, 1000);
+    XCTAssertEqual(result.instructionCount, 1);
+    XCTAssertEqual(stackCore.stackPointer, 0x0001);
+    
+    // High RAM is plain memory
+    vector<uint8_t> highRAM = { 0x21, 0x80, 0xFF, 0x77, 0x00 }; // LD HL, $FF80; LD (HL), A; NOP
+    MikoGB::CPUCore highRAMCore(highRAM.data(), highRAM.size());
+    highRAMCore.registers[REGISTER_A] = 0x42;
+    result = MikoGB::InstructionJIT::Run(*_Compile(jit, highRAMCore, 3), highRAMCore, 1000);
+    XCTAssertEqual(result.instructionCount, 3);
+    XCTAssertEqual(highRAMCore.mainMemory[0xFF80], 0x42);
+}
+
+- (void)testNativeBlockCycleBudget {
+    if (!MikoGB::InstructionJIT::IsSupported()) {
+        return;
+    }
+    vector<uint8_t> code = { 0x00, 0x00, 0x3E, 0x01, 0x00 }; // NOP; NOP; LD A, $01; NOP
+    MikoGB::CPUCore core(code.data(), code.size());
+    MikoGB::InstructionJIT jit;
+    const MikoGB::NativeBlock *block = _Compile(jit, core, 4);
+    
+    // An instruction only starts while the elapsed cycles are under the budget
+    MikoGB::InstructionJIT::RunResult result = MikoGB::InstructionJIT::Run(*block, core, 2);
+    XCTAssertEqual(result.instructionCount, 2);
+    XCTAssertEqual(result.cycles, 2);
+    XCTAssertEqual(core.programCounter, 0x0002);
+    
+    // The first instruction always runs
+    core.programCounter = 0;
+    result = MikoGB::InstructionJIT::Run(*block, core, 0);
+    XCTAssertEqual(result.instructionCount, 1);
+    XCTAssertEqual(core.programCounter, 0x0001);
+    
+    core.programCounter = 0;
+    result = MikoGB::InstructionJIT::Run(*block, core, 5);
+    XCTAssertEqual(result.instructionCount, 4);
+    XCTAssertEqual(result.cycles, 5);
+    XCTAssertEqual(core.registers[REGISTER_A], 0x01);
+    
+    // Resuming partway through the block
+    core.programCounter = 2;
+    core.registers[REGISTER_A] = 0;
+    result = MikoGB::InstructionJIT::Run(*block, core, 0, 2);
+    XCTAssertEqual(result.instructionCount, 1);
+    XCTAssertEqual(result.cycles, 2);
+    XCTAssertEqual(core.programCounter, 0x0004);
+    XCTAssertEqual(core.registers[REGISTER_A], 0x01);
+    result = MikoGB::InstructionJIT::Run(*block, core, 5, 3);
+    XCTAssertEqual(result.instructionCount, 1);
+    XCTAssertEqual(core.programCounter, 0x0005);
+}
+
+- (void)testCompilationStops {
+    if (!MikoGB::InstructionJIT::IsSupported()) {
+        return;
+    }
+    MikoGB::InstructionJIT jit;
+    
+    // HALT is left to the interpreter
+    vector<uint8_t> halt = { 0x00, 0x76, 0x00 };
+    MikoGB::CPUCore haltCore(halt.data(), halt.size());
+    XCTAssertEqual(_Compile(jit, haltCore, 3)->instructionCount, 1);
+    haltCore.programCounter = 1;
+    XCTAssertTrue(_Compile(jit, haltCore, 2) == nullptr);
+    
+    // Interrupts are checked between steps, so native code returns after EI
+    vector<uint8_t> enableInterrupts = { 0xFB, 0x00 };
+    MikoGB::CPUCore eiCore(enableInterrupts.data(), enableInterrupts.size());
+    XCTAssertEqual(_Compile(jit, eiCore, 2)->instructionCount, 1);
+    
+    // Known I/O accesses aren't compiled at all, but high RAM accesses are
+    vector<uint8_t> ioWrite = { 0xE0, 0x40, 0x00 }; // LDH ($40), A; NOP
+    MikoGB::CPUCore ioCore(ioWrite.data(), ioWrite.size());
+    XCTAssertTrue(_Compile(jit, ioCore, 2) == nullptr);
+    vector<uint8_t> highRAMWrite = { 0xE0, 0x80, 0x00 }; // LDH ($80), A; NOP
+    MikoGB::CPUCore highRAMCore(highRAMWrite.data(), highRAMWrite.size());
+    XCTAssertEqual(_Compile(jit, highRAMCore, 2)->instructionCount, 2);
+    
+    // Fused idioms keep their own handlers
+    vector<uint8_t> copyByte = { 0x2A, 0x12, 0x13, 0x00 }; // LD A, (HL+); LD (DE), A; INC DE
+    MikoGB::CPUCore fusedCore(copyByte.data(), copyByte.size());
+    MikoGB::DecodedInstruction fused = {};
+    memcpy(fused.bytes, copyByte.data(), copyByte.size());
+    const MikoGB::CPUInstruction *instruction = MikoGB::CPUInstruction::LookupFusedInstruction(fused.bytes, copyByte.size());
+    XCTAssertTrue(instruction != nullptr);
+    fused.func = instruction->func;
+    fused.size = instruction->size;
+    XCTAssertTrue(jit.compile(fusedCore, &fused, 1, 0, 0) == nullptr);
+    
+    XCTAssertEqual(jit.compiledBlockCount(), 3);
+    jit.invalidate();
+    XCTAssertEqual(jit.compiledBlockCount(), 0);
+}
+
+@end
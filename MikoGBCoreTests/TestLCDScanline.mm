@@ -0,0 +1,179 @@
+//
+//  TestLCDScanline.mm
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#import <XCTest/XCTest.h>
+#include "LCDScanline.hpp"
+#include "MonochromePalette.hpp"
+#include "ColorPalette.hpp"
+#include "BackgroundLayer.hpp"
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace MikoGB;
+
+/// Per-pixel layers and compositor, as LCDScanline was before it composited in bulk
+struct ReferenceScanline {
+    enum class Priority { Undefined, Transparent, Low, High };
+    vector<Pixel> bgPixels, objPixels;
+    vector<Priority> bgPriority, objPriority;
+    
+    ReferenceScanline(size_t width): bgPixels(width), objPixels(width), bgPriority(width, Priority::Undefined), objPriority(width, Priority::Undefined) {}
+    
+    void writePixel(size_t idx, uint8_t code, const Palette &palette, LCDScanline::WriteType writeType) {
+        const Pixel &px = palette.pixelForCode(code);
+        const bool isTransparentPixel = (code & 0x3) == 0;
+        switch (writeType) {
+            case LCDScanline::WriteType::BackgroundDeferToObj:
+                bgPixels[idx] = px;
+                bgPriority[idx] = isTransparentPixel ? Priority::Transparent : Priority::Low;
+                break;
+            case LCDScanline::WriteType::BackgroundPrioritizeBG:
+                bgPixels[idx] = px;
+                bgPriority[idx] = isTransparentPixel ? Priority::Transparent : Priority::High;
+                break;
+            case LCDScanline::WriteType::WindowDeferToObj:
+                bgPixels[idx] = px;
+                bgPriority[idx] = Priority::Low;
+                break;
+            case LCDScanline::WriteType::WindowPrioritizeBG:
+                bgPixels[idx] = px;
+                bgPriority[idx] = Priority::High;
+                break;
+            case LCDScanline::WriteType::ObjectLow:
+                if (objPriority[idx] == Priority::Undefined || !isTransparentPixel) {
+                    objPixels[idx] = px;
+                    objPriority[idx] = isTransparentPixel ? Priority::Transparent : Priority::Low;
+                }
+                break;
+            case LCDScanline::WriteType::ObjectHigh:
+                if (objPriority[idx] == Priority::Undefined || !isTransparentPixel) {
+                    objPixels[idx] = px;
+                    objPriority[idx] = isTransparentPixel ? Priority::Transparent : Priority::High;
+                }
+                break;
+        }
+    }
+    
+    Pixel compositedPixel(size_t i) const {
+        if (objPriority[i] == Priority::Undefined) {
+            return bgPixels[i];
+        } else if (bgPriority[i] == Priority::Undefined) {
+            return objPixels[i];
+        } else if (objPriority[i] == Priority::Transparent) {
+            return bgPixels[i];
+        } else if (bgPriority[i] == Priority::Transparent) {
+            return objPixels[i];
+        } else if (bgPriority[i] == Priority::High) {
+            return bgPixels[i];
+        } else {
+            return objPriority[i] == Priority::High ? objPixels[i] : bgPixels[i];
+        }
+    }
+};
+
+@interface TestLCDScanline : XCTestCase
+
+@end
+
+@implementation TestLCDScanline
+
+- (void)testCompositingMatchesReference {
+    // Random runs of every write type with random palettes, including lines with no background or no objects at all.
+    // 165 is wider than the screen and not a multiple of the vector width, so the scalar tail is covered too
+    mt19937 rng(0x4D494B4F);
+    const LCDScanline::WriteType writeTypes[] = {
+        LCDScanline::WriteType::BackgroundDeferToObj,
+        LCDScanline::WriteType::BackgroundPrioritizeBG,
+        LCDScanline::WriteType::WindowDeferToObj,
+        LCDScanline::WriteType::WindowPrioritizeBG,
+        LCDScanline::WriteType::ObjectLow,
+        LCDScanline::WriteType::ObjectHigh,
+    };
+    for (size_t width : { 160, 165 }) {
+        LCDScanline scanline(width);
+        for (int line = 0; line < 2000; ++line) {
+            ReferenceScanline reference(width);
+            scanline.clear();
+            const int writeCount = rng() % 48;
+            const bool skipBackground = line % 7 == 0;
+            const bool skipObjects = line % 5 == 0;
+            for (int write = 0; write < writeCount; ++write) {
+                const LCDScanline::WriteType writeType = writeTypes[rng() % 6];
+                const bool isObject = writeType == LCDScanline::WriteType::ObjectLow || writeType == LCDScanline::WriteType::ObjectHigh;
+                if ((isObject && skipObjects) || (!isObject && skipBackground)) {
+                    continue;
+                }
+                const MonochromePalette palette((uint8_t)rng());
+                const uint16_t codes = (uint16_t)rng();
+                const size_t idx = rng() % width;
+                const size_t count = min<size_t>(1 + rng() % 8, width - idx);
+                scanline.writeTileRow(idx, codes, count, palette, writeType);
+                for (size_t i = 0; i < count; ++i) {
+                    reference.writePixel(idx + i, (codes >> (2 * i)) & 0x3, palette, writeType);
+                }
+            }
+            
+            const PixelBuffer &composited = scanline.getCompositedPixelData();
+            for (size_t i = 0; i < width; ++i) {
+                const Pixel expected = reference.compositedPixel(i);
+                const Pixel &actual = composited.pixels[i];
+                XCTAssertTrue(actual.red == expected.red && actual.green == expected.green && actual.blue == expected.blue, @"Line %d pixel %zu", line, i);
+            }
+        }
+    }
+}
+
+- (void)testBackgroundIndicesMatchTileRows {
+    // A run of BackgroundLayer indices draws the same as the equivalent tile row
+    mt19937 rng(0x4D494B4F);
+    vector<ColorPalette> palettes(8);
+    for (ColorPalette &palette : palettes) {
+        for (uint8_t control = 0; control < 8; ++control) {
+            palette.paletteDataWrite(control, (uint8_t)rng());
+        }
+    }
+    vector<Pixel> palettePixels;
+    for (const ColorPalette &palette : palettes) {
+        for (uint8_t code = 0; code < 4; ++code) {
+            palettePixels.push_back(palette.pixelForCode(code));
+        }
+    }
+    
+    LCDScanline scanline(8);
+    LCDScanline reference(8);
+    for (int run = 0; run < 1000; ++run) {
+        const uint16_t codes = (uint16_t)rng();
+        const uint8_t paletteNumber = rng() % 8;
+        const bool priorityToBG = rng() % 2;
+        uint8_t indices[8];
+        for (int i = 0; i < 8; ++i) {
+            indices[i] = ((codes >> (2 * i)) & 0x3) | (paletteNumber << BackgroundLayer::PaletteNumberShift) | (priorityToBG ? BackgroundLayer::PriorityMask : 0);
+        }
+        scanline.clear();
+        reference.clear();
+        scanline.writeBackgroundIndices(0, indices, 8, palettePixels.data());
+        reference.writeTileRow(0, codes, 8, palettes[paletteNumber], priorityToBG ? LCDScanline::WriteType::BackgroundPrioritizeBG : LCDScanline::WriteType::BackgroundDeferToObj);
+        
+        // An object under every pixel makes the priorities visible too
+        const MonochromePalette objPalette(0xE4);
+        const uint16_t objCodes = (uint16_t)rng() | 0x5555;
+        const LCDScanline::WriteType objWriteType = rng() % 2 ? LCDScanline::WriteType::ObjectHigh : LCDScanline::WriteType::ObjectLow;
+        scanline.writeTileRow(0, objCodes, 8, objPalette, objWriteType);
+        reference.writeTileRow(0, objCodes, 8, objPalette, objWriteType);
+        
+        const PixelBuffer &actual = scanline.getCompositedPixelData();
+        const PixelBuffer &expected = reference.getCompositedPixelData();
+        for (size_t i = 0; i < 8; ++i) {
+            const Pixel &a = actual.pixels[i];
+            const Pixel &e = expected.pixels[i];
+            XCTAssertTrue(a.red == e.red && a.green == e.green && a.blue == e.blue, @"Run %d pixel %zu", run, i);
+        }
+    }
+}
+
+@end
@@ -0,0 +1,473 @@
+//
+//  TestMemoryController.mm
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#import <XCTest/XCTest.h>
+#include "MemoryController.hpp"
+#include "TileCache.hpp"
+#include "BackgroundLayer.hpp"
+#include "SaveFile.hpp"
+#include <vector>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace MikoGB;
+
+@interface TestMemoryController : XCTestCase
+
+@end
+
+@implementation TestMemoryController
+
+- (void)testIORegisterHandlers {
+    MemoryController::Ptr memoryController = make_shared<MemoryController>();
+    XCTAssertTrue(memoryController->configureWithEmptyData());
+    
+    // Unused registers are plain memory
+    memoryController->setByte(0xFF72, 0x12);
+    XCTAssertEqual(memoryController->readByte(0xFF72), 0x12);
+    
+    int writeCount = 0;
+    memoryController->registerIOHandlers(0xFF72, 0xFF73, [](uint16_t addr) -> uint8_t {
+        return addr & 0xFF;
+    }, [&writeCount](uint16_t addr, uint8_t val) -> uint8_t {
+        ++writeCount;
+        return val | 0x80;
+    });
+    XCTAssertEqual(memoryController->readByte(0xFF72), 0x72);
+    XCTAssertEqual(memoryController->readByte(0xFF73), 0x73);
+    memoryController->setByte(0xFF73, 0x01);
+    XCTAssertEqual(writeCount, 1);
+    
+    // An empty handler keeps the existing one. The stored value is what's read without a read handler
+    memoryController->registerIOHandlers(0xFF73, 0xFF73, nullptr, [](uint16_t addr, uint8_t val) -> uint8_t {
+        return val;
+    });
+    XCTAssertEqual(memoryController->readByte(0xFF73), 0x73);
+    memoryController->setByte(0xFF73, 0x02);
+    XCTAssertEqual(writeCount, 1);
+    memoryController->registerIOHandlers(0xFF74, 0xFF74, nullptr, [](uint16_t addr, uint8_t val) -> uint8_t {
+        return val | 0x80;
+    });
+    memoryController->setByte(0xFF74, 0x01);
+    XCTAssertEqual(memoryController->readByte(0xFF74), 0x81);
+}
+
+- (void)testBuiltInIORegisters {
+    MemoryController::Ptr memoryController = make_shared<MemoryController>();
+    XCTAssertTrue(memoryController->configureWithEmptyData());
+    
+    // No joypad attached means no buttons pressed
+    XCTAssertEqual(memoryController->readByte(0xFF00), 0x0F);
+    
+    // VRAM bank switch reads back with the top bits set and changes what's mapped at 0x8000
+    memoryController->setByte(0x8000, 0xAA);
+    memoryController->setByte(0xFF4F, 0x01);
+    XCTAssertEqual(memoryController->readByte(0xFF4F), 0xFF);
+    XCTAssertEqual(memoryController->readByte(0x8000), 0x00);
+    memoryController->setByte(0xFF4F, 0x00);
+    XCTAssertEqual(memoryController->readByte(0x8000), 0xAA);
+    
+    // Same for working RAM. Bank 0 selects bank 1
+    memoryController->setByte(0xD000, 0x11);
+    memoryController->setByte(0xFF70, 0x02);
+    XCTAssertEqual(memoryController->readByte(0xD000), 0x00);
+    memoryController->setByte(0xFF70, 0x00);
+    XCTAssertEqual(memoryController->readByte(0xD000), 0x11);
+    
+    // High RAM is plain memory
+    memoryController->setByte(0xFF80, 0x34);
+    XCTAssertEqual(memoryController->readByte(0xFF80), 0x34);
+}
+
+- (void)testROMImageIsNotCopied {
+    // 32 KiB ROM without an MBC
+    vector<uint8_t> rom(32 * 1024);
+    rom[0x4000] = 0x12;
+    
+    MemoryController::Ptr memoryController = make_shared<MemoryController>();
+    XCTAssertTrue(memoryController->configureWithROMImage(ROMImage::CreateWithUnownedData(rom.data(), rom.size())));
+    XCTAssertEqual(memoryController->readByte(0x4000), 0x12);
+    
+    // Reads go straight to the caller's data
+    rom[0x1000] = 0x34;
+    rom[0x4000] = 0x56;
+    XCTAssertEqual(memoryController->readByte(0x1000), 0x34);
+    XCTAssertEqual(memoryController->readByte(0x4000), 0x56);
+}
+
+- (void)testDMATransfers {
+    // 64 KiB MBC1 ROM with 8 KiB of RAM
+    vector<uint8_t> rom(64 * 1024);
+    rom[0x147] = 0x02;
+    rom[0x148] = 0x01;
+    rom[0x149] = 0x02;
+    for (size_t i = 0; i < 0x100; ++i) {
+        rom[0x4000 + i] = (uint8_t)i;
+    }
+    MemoryController::Ptr memoryController = make_shared<MemoryController>();
+    XCTAssertTrue(memoryController->configureWithROMImage(ROMImage::CreateWithUnownedData(rom.data(), rom.size())));
+    
+    // OAM DMA from switchable ROM
+    memoryController->setByte(0xFF46, 0x40);
+    for (uint16_t i = 0; i < 0xA0; ++i) {
+        XCTAssertEqual(memoryController->readByte(0xFE00 + i), i);
+    }
+    
+    // General purpose DMA of 32 bytes from the end of WRAM bank 0 into the switchable bank, to VRAM across a page
+    for (uint16_t i = 0; i < 0x20; ++i) {
+        memoryController->setByte(0xCFF0 + i, 0x80 + i);
+    }
+    memoryController->setByte(0xFF51, 0xCF);
+    memoryController->setByte(0xFF52, 0xF0);
+    memoryController->setByte(0xFF53, 0x0F);
+    memoryController->setByte(0xFF54, 0xF0);
+    memoryController->setByte(0xFF55, 0x01);
+    XCTAssertEqual(memoryController->readByte(0xFF55), 0xFF);
+    for (uint16_t i = 0; i < 0x20; ++i) {
+        XCTAssertEqual(memoryController->readByte(0x8FF0 + i), 0x80 + i);
+    }
+    
+    // H-blank DMA from external RAM, which goes through the MBC, 16 bytes per step
+    memoryController->setByte(0x0000, 0x0A);
+    for (uint16_t i = 0; i < 0x20; ++i) {
+        memoryController->setByte(0xA000 + i, 0x40 + i);
+    }
+    memoryController->setByte(0xFF51, 0xA0);
+    memoryController->setByte(0xFF52, 0x00);
+    memoryController->setByte(0xFF53, 0x01);
+    memoryController->setByte(0xFF54, 0x00);
+    memoryController->setByte(0xFF55, 0x81);
+    memoryController->hBlankDMATransferStep();
+    XCTAssertEqual(memoryController->readByte(0x810F), 0x4F);
+    XCTAssertEqual(memoryController->readByte(0x8110), 0x00);
+    memoryController->hBlankDMATransferStep();
+    XCTAssertEqual(memoryController->readByte(0xFF55), 0xFF);
+    for (uint16_t i = 0; i < 0x20; ++i) {
+        XCTAssertEqual(memoryController->readByte(0x8100 + i), 0x40 + i);
+    }
+}
+
+- (void)testExternalRAMMapping {
+    // 64 KiB MBC1 ROM with 8 KiB of battery backed RAM
+    vector<uint8_t> rom(64 * 1024);
+    rom[0x147] = 0x03;
+    rom[0x148] = 0x01;
+    rom[0x149] = 0x02;
+    MemoryController::Ptr memoryController = make_shared<MemoryController>();
+    XCTAssertTrue(memoryController->configureWithROMImage(ROMImage::CreateWithUnownedData(rom.data(), rom.size())));
+    
+    // Disabled RAM reads as 0xFF and ignores writes
+    memoryController->setByte(0xA000, 0x12);
+    XCTAssertEqual(memoryController->readByte(0xA000), 0xFF);
+    XCTAssertFalse(memoryController->isPersistenceStale());
+    
+    // Writes still go through the MBC so that they're saved
+    memoryController->setByte(0x0000, 0x0A);
+    memoryController->setByte(0xA000, 0x12);
+    memoryController->setByte(0xBFFF, 0x34);
+    XCTAssertEqual(memoryController->readByte(0xA000), 0x12);
+    XCTAssertEqual(memoryController->readByte(0xBFFF), 0x34);
+    XCTAssertTrue(memoryController->isPersistenceStale());
+    
+    memoryController->setByte(0x0000, 0x00);
+    XCTAssertEqual(memoryController->readByte(0xA000), 0xFF);
+}
+
+- (void)testDirtySaveDataRanges {
+    // 64 KiB MBC5 ROM with 32 KiB of battery backed RAM
+    vector<uint8_t> rom(64 * 1024);
+    rom[0x147] = 0x1B;
+    rom[0x148] = 0x01;
+    rom[0x149] = 0x03;
+    MemoryController::Ptr memoryController = make_shared<MemoryController>();
+    XCTAssertTrue(memoryController->configureWithROMImage(ROMImage::CreateWithUnownedData(rom.data(), rom.size())));
+    const size_t saveSize = memoryController->saveDataSize();
+    XCTAssertEqual(saveSize, 32 * 1024);
+    vector<uint8_t> saved(saveSize);
+    vector<SaveDataRange> ranges;
+    
+    // Writes to neighboring pages are joined, writes of the same value aren't changes
+    memoryController->setByte(0x0000, 0x0A);
+    memoryController->setByte(0xA010, 0x11);
+    memoryController->setByte(0xA1FF, 0x22);
+    memoryController->setByte(0xB000, 0x00);
+    memoryController->setByte(0x4000, 0x02);
+    memoryController->setByte(0xA300, 0x33);
+    XCTAssertTrue(memoryController->isPersistenceStale());
+    // Clients reset persistence to schedule a save before copying
+    memoryController->resetPersistence();
+    XCTAssertEqual(memoryController->copyDirtySaveData(saved.data(), saved.size(), ranges), 0x200 + 0x100);
+    XCTAssertEqual(ranges.size(), 2);
+    XCTAssertEqual(ranges[0].offset, 0x0000);
+    XCTAssertEqual(ranges[0].size, 0x200);
+    XCTAssertEqual(ranges[1].offset, 2 * 0x2000 + 0x300);
+    XCTAssertEqual(ranges[1].size, 0x100);
+    XCTAssertEqual(saved[0x010], 0x11);
+    XCTAssertEqual(saved[0x1FF], 0x22);
+    XCTAssertEqual(saved[2 * 0x2000 + 0x300], 0x33);
+    
+    // Copied ranges are clean until written again. The incremental copies add up to a full copy
+    ranges.clear();
+    XCTAssertEqual(memoryController->copyDirtySaveData(saved.data(), saved.size(), ranges), 0);
+    XCTAssertTrue(ranges.empty());
+    memoryController->setByte(0xBFFF, 0x44);
+    XCTAssertEqual(memoryController->copyDirtySaveData(saved.data(), saved.size(), ranges), 0x100);
+    vector<uint8_t> full(saveSize);
+    XCTAssertEqual(memoryController->copySaveData(full.data(), full.size()), saveSize);
+    XCTAssertTrue(full == saved);
+    
+    // Loaded save data is clean
+    memoryController->setByte(0xA000, 0x55);
+    XCTAssertTrue(memoryController->loadSaveData(full.data(), full.size()));
+    ranges.clear();
+    XCTAssertEqual(memoryController->copyDirtySaveData(saved.data(), saved.size(), ranges), 0);
+}
+
+- (void)testMappedSaveFile {
+    // 64 KiB MBC3 ROM with a clock and 32 KiB of battery backed RAM
+    vector<uint8_t> rom(64 * 1024);
+    rom[0x147] = 0x10;
+    rom[0x148] = 0x01;
+    rom[0x149] = 0x03;
+    const ROMImage::Ptr image = ROMImage::CreateWithUnownedData(rom.data(), rom.size());
+    char path[] = "/tmp/TestMappedSaveFile.XXXXXX";
+    const int fd = mkstemp(path);
+    XCTAssertGreaterThanOrEqual(fd, 0);
+    close(fd);
+    const size_t saveSize = 32 * 1024;
+    const size_t fileSize = saveSize + 5;
+    
+    // Writes to RAM and the clock show up in the file without copying
+    MemoryController::Ptr memoryController = make_shared<MemoryController>();
+    XCTAssertTrue(memoryController->configureWithROMImage(image));
+    XCTAssertTrue(memoryController->mapSaveFile(path));
+    memoryController->setByte(0x0000, 0x0A);
+    memoryController->setByte(0xA123, 0x5A);
+    memoryController->setByte(0x4000, 0x08);
+    memoryController->setByte(0xA000, 30);
+    XCTAssertTrue(memoryController->flushSaveData());
+    vector<uint8_t> contents(fileSize + 1);
+    FILE *file = fopen(path, "rb");
+    XCTAssertEqual(fread(contents.data(), 1, contents.size(), file), fileSize);
+    fclose(file);
+    XCTAssertEqual(contents[0x123], 0x5A);
+    XCTAssertEqual(contents[saveSize], 30);
+    
+    // Still mapped after a reset. Nothing is dirty after a flush
+    memoryController->reset();
+    vector<SaveDataRange> ranges;
+    XCTAssertEqual(memoryController->copyDirtySaveData(contents.data(), saveSize, ranges), 0);
+    memoryController->setByte(0x0000, 0x0A);
+    XCTAssertEqual(memoryController->readByte(0xA123), 0x5A);
+    memoryController->setByte(0xA124, 0x6B);
+    memoryController.reset();
+    
+    // Mapping the file again picks up its save data and clock
+    memoryController = make_shared<MemoryController>();
+    XCTAssertTrue(memoryController->configureWithROMImage(image));
+    XCTAssertTrue(memoryController->mapSaveFile(path));
+    memoryController->setByte(0x0000, 0x0A);
+    XCTAssertEqual(memoryController->readByte(0xA123), 0x5A);
+    XCTAssertEqual(memoryController->readByte(0xA124), 0x6B);
+    memoryController->setByte(0x4000, 0x08);
+    memoryController->setByte(0x6000, 0x00);
+    memoryController->setByte(0x6000, 0x01);
+    XCTAssertEqual(memoryController->readByte(0xA000), 30);
+    
+    // Files sized for another cartridge are left alone
+    vector<uint8_t> otherROM(64 * 1024);
+    otherROM[0x147] = 0x03;
+    otherROM[0x148] = 0x01;
+    otherROM[0x149] = 0x02;
+    MemoryController::Ptr otherController = make_shared<MemoryController>();
+    XCTAssertTrue(otherController->configureWithROMImage(ROMImage::CreateWithUnownedData(otherROM.data(), otherROM.size())));
+    XCTAssertFalse(otherController->mapSaveFile(path));
+    XCTAssertFalse(otherController->flushSaveData());
+    unlink(path);
+}
+
+- (void)testSaveFileMappingFailureRestoresFile {
+    // Too large to map, so each attempt fails after the file was created or extended
+    const size_t impossibleSize = (size_t)1 << 62;
+    char path[] = "/tmp/TestSaveFileRestore.XXXXXX";
+    const int fd = mkstemp(path);
+    XCTAssertGreaterThanOrEqual(fd, 0);
+    close(fd);
+    
+    // A file that was just created is removed again
+    unlink(path);
+    XCTAssertTrue(SaveFile::CreateByMapping(path, impossibleSize, 0) == nullptr);
+    struct stat fileInfo;
+    XCTAssertNotEqual(stat(path, &fileInfo), 0);
+    
+    // An existing file keeps its size and contents
+    FILE *file = fopen(path, "wb");
+    const uint8_t contents[5] = { 1, 2, 3, 4, 5 };
+    XCTAssertEqual(fwrite(contents, 1, sizeof(contents), file), sizeof(contents));
+    fclose(file);
+    XCTAssertTrue(SaveFile::CreateByMapping(path, impossibleSize, 0) == nullptr);
+    XCTAssertEqual(stat(path, &fileInfo), 0);
+    XCTAssertEqual(fileInfo.st_size, sizeof(contents));
+    unlink(path);
+}
+
+- (void)testTileCacheInvalidation {
+    MemoryController::Ptr memoryController = make_shared<MemoryController>();
+    XCTAssertTrue(memoryController->configureWithEmptyData());
+    TileCache tileCache;
+    
+    // Tile 1's first row in bank 0 is 0x0F, 0x33: codes 0, 0, 2, 2, 1, 1, 3, 3 from the left
+    memoryController->setByte(0x8010, 0x0F);
+    memoryController->setByte(0x8011, 0x33);
+    XCTAssertEqual(tileCache.tileRow(*memoryController, 0, 0x8010, 0, false), 0xF5A0);
+    XCTAssertEqual(tileCache.tileRow(*memoryController, 0, 0x8010, 0, false), 0xF5A0);
+    XCTAssertEqual(tileCache.tileRow(*memoryController, 0, 0x8010, 0, true), 0x0A5F);
+    XCTAssertEqual(tileCache.counters().missCount, 2);
+    XCTAssertEqual(tileCache.counters().hitCount, 1);
+    
+    // Writes to another tile, the other bank or the tile maps don't invalidate it
+    memoryController->setByte(0x8020, 0xFF);
+    memoryController->setByte(0xFF4F, 0x01);
+    memoryController->setByte(0x8010, 0xFF);
+    memoryController->setByte(0x9800, 0xFF);
+    XCTAssertEqual(tileCache.tileRow(*memoryController, 0, 0x8010, 0, false), 0xF5A0);
+    XCTAssertEqual(tileCache.counters().invalidationCount, 0);
+    XCTAssertEqual(tileCache.tileRow(*memoryController, 1, 0x8010, 0, false), 0x5555);
+    
+    // A write to the tile does, as does a DMA over it. Row 8 is the first row of the next tile, not decoded before
+    memoryController->setByte(0xFF4F, 0x00);
+    memoryController->setByte(0x8011, 0x00);
+    XCTAssertEqual(tileCache.tileRow(*memoryController, 0, 0x8010, 0, false), 0x5500);
+    XCTAssertEqual(tileCache.tileRow(*memoryController, 0, 0x8010, 0, true), 0x0055);
+    XCTAssertEqual(tileCache.counters().invalidationCount, 1);
+    for (uint16_t addr = 0xC000; addr < 0xC020; ++addr) {
+        memoryController->setByte(addr, 0xFF);
+    }
+    memoryController->setByte(0xFF51, 0xC0);
+    memoryController->setByte(0xFF52, 0x00);
+    memoryController->setByte(0xFF53, 0x80);
+    memoryController->setByte(0xFF54, 0x10);
+    memoryController->setByte(0xFF55, 0x01);
+    XCTAssertEqual(tileCache.tileRow(*memoryController, 0, 0x8010, 0, false), 0xFFFF);
+    XCTAssertEqual(tileCache.tileRow(*memoryController, 0, 0x8010, 8, false), 0xFFFF);
+    XCTAssertEqual(tileCache.counters().invalidationCount, 2);
+    
+    // Everything is written by a reset
+    memoryController->reset();
+    XCTAssertEqual(tileCache.tileRow(*memoryController, 0, 0x8010, 0, false), 0x0000);
+    XCTAssertEqual(tileCache.counters().invalidationCount, 3);
+}
+
+- (void)testBackgroundLayerUpdates {
+    MemoryController::Ptr memoryController = make_shared<MemoryController>();
+    XCTAssertTrue(memoryController->configureWithEmptyData());
+    TileCache tileCache;
+    BackgroundLayer layer;
+    
+    // Tile 1's first row is codes 0, 0, 2, 2, 1, 1, 3, 3. Use it for the first entry of the 0x9800 map
+    memoryController->setByte(0x8010, 0x0F);
+    memoryController->setByte(0x8011, 0x33);
+    memoryController->setByte(0x9800, 0x01);
+    layer.update(*memoryController, tileCache, false, false);
+    const vector<uint8_t> expectedRow = { 0, 0, 2, 2, 1, 1, 3, 3, 0 };
+    XCTAssertTrue(vector<uint8_t>(layer.row(0, 0), layer.row(0, 0) + 9) == expectedRow);
+    XCTAssertEqual(layer.row(1, 0)[2], 0);
+    
+    // Writing the tile redraws entries that use it, and writing an entry redraws it
+    memoryController->setByte(0x8011, 0x00);
+    memoryController->setByte(0x9C21, 0x01);
+    layer.update(*memoryController, tileCache, false, false);
+    const vector<uint8_t> expectedUpdatedRow = { 0, 0, 0, 0, 1, 1, 1, 1 };
+    XCTAssertTrue(vector<uint8_t>(layer.row(0, 0), layer.row(0, 0) + 8) == expectedUpdatedRow);
+    XCTAssertTrue(vector<uint8_t>(layer.row(1, 8) + 8, layer.row(1, 8) + 16) == expectedUpdatedRow);
+    
+    // CGB attributes in bank 1: BG priority, X flip and palette 3
+    memoryController->setByte(0xFF4F, 0x01);
+    memoryController->setByte(0x9800, 0xA3);
+    memoryController->setByte(0xFF4F, 0x00);
+    layer.update(*memoryController, tileCache, false, true);
+    const uint8_t bits = 0x80 | (3 << BackgroundLayer::PaletteNumberShift);
+    const vector<uint8_t> expectedAttributedRow = { 1 | bits, 1 | bits, 1 | bits, 1 | bits, bits, bits, bits, bits };
+    XCTAssertTrue(vector<uint8_t>(layer.row(0, 0), layer.row(0, 0) + 8) == expectedAttributedRow);
+    
+    // Signed codes refer to tiles from 0x9000, so code 1 is now an empty tile
+    layer.update(*memoryController, tileCache, true, false);
+    XCTAssertEqual(layer.row(0, 0)[4], 0);
+    XCTAssertEqual(layer.row(1, 8)[12], 0);
+}
+
+- (void)testResetAndReconfigure {
+    // 64 KiB MBC1 ROMs with 8 KiB of RAM. Each has its number at the start of bank 0 and bank 1
+    vector<uint8_t> romA(64 * 1024), romB(64 * 1024);
+    for (auto rom : { &romA, &romB }) {
+        (*rom)[0x147] = 0x03;
+        (*rom)[0x148] = 0x01;
+        (*rom)[0x149] = 0x02;
+    }
+    romA[0x0150] = romA[0x4000] = 0xA0;
+    romB[0x0150] = romB[0x4000] = 0xB0;
+    romB[0x8000] = 0xB2;
+    MemoryController::Ptr memoryController = make_shared<MemoryController>();
+    XCTAssertTrue(memoryController->configureWithROMImage(ROMImage::CreateWithUnownedData(romA.data(), romA.size())));
+    size_t sampleCount = 0;
+    memoryController->setAudioSampleCallback([&sampleCount](int16_t, int16_t) {
+        sampleCount += 1;
+    });
+    
+    // Change a bit of everything: memory, banks, external RAM, registers and time
+    memoryController->setByte(0xFF50, 0x01);
+    memoryController->setByte(0x2000, 0x02);
+    memoryController->setByte(0x0000, 0x0A);
+    memoryController->setByte(0xA000, 0x12);
+    memoryController->setByte(0xC000, 0x34);
+    memoryController->setByte(0xFF70, 0x03);
+    memoryController->setByte(0xD000, 0x56);
+    memoryController->setByte(0x8000, 0x78);
+    memoryController->setByte(0xFF80, 0x9A);
+    memoryController->setByte(0xFF07, 0x05);
+    memoryController->scheduler.advance(100000);
+    memoryController->runDueEvents();
+    XCTAssertEqual(memoryController->currentROMBank(), 2);
+    
+    XCTAssertTrue(sampleCount > 0);
+    
+    // Same ROM, back to power-on. Callbacks are kept
+    memoryController->reset();
+    XCTAssertTrue(memoryController->isBootROMMapped());
+    XCTAssertEqual(memoryController->scheduler.cpuCycles(), 0);
+    const size_t samplesBeforeReset = sampleCount;
+    memoryController->scheduler.advance(100000);
+    memoryController->runDueEvents();
+    XCTAssertTrue(sampleCount > samplesBeforeReset);
+    XCTAssertEqual(memoryController->currentROMBank(), 1);
+    XCTAssertEqual(memoryController->readByte(0x4000), 0xA0);
+    XCTAssertEqual(memoryController->readByte(0xA000), 0xFF);
+    memoryController->setByte(0x0000, 0x0A);
+    XCTAssertEqual(memoryController->readByte(0xA000), 0x00);
+    XCTAssertEqual(memoryController->readByte(0xC000), 0x00);
+    XCTAssertEqual(memoryController->readByte(0xD000), 0x00);
+    XCTAssertEqual(memoryController->readByte(0x8000), 0x00);
+    XCTAssertEqual(memoryController->readByte(0xFF80), 0x00);
+    XCTAssertEqual(memoryController->readByte(0xFF07), 0x00);
+    
+    // Configuring again replaces the ROM, even after running
+    memoryController->setByte(0xFF50, 0x01);
+    memoryController->setByte(0xC000, 0x34);
+    memoryController->setByte(0x2000, 0x02);
+    XCTAssertTrue(memoryController->configureWithROMImage(ROMImage::CreateWithUnownedData(romB.data(), romB.size())));
+    XCTAssertTrue(memoryController->isBootROMMapped());
+    memoryController->setByte(0xFF50, 0x01);
+    XCTAssertEqual(memoryController->readByte(0x0150), 0xB0);
+    XCTAssertEqual(memoryController->readByte(0x4000), 0xB0);
+    XCTAssertEqual(memoryController->readByte(0xC000), 0x00);
+    memoryController->setByte(0x2000, 0x02);
+    XCTAssertEqual(memoryController->readByte(0x4000), 0xB2);
+}
+
+@end
@@ -0,0 +1,75 @@
+//
+//  TestROMImage.mm
+//  MikoGB
+//
+//  Created on 10/16/26.
+//
+
+#import <XCTest/XCTest.h>
+#include "ROMImage.hpp"
+#include "MemoryController.hpp"
+#include <vector>
+
+using namespace std;
+using namespace MikoGB;
+
+/// 64 KiB MBC1 ROM where the first byte of each bank is its bank number
+static vector<uint8_t> _MBC1ROM() {
+    vector<uint8_t> rom(64 * 1024);
+    for (size_t bank = 0; bank < 4; ++bank) {
+        rom[bank * 0x4000] = bank;
+    }
+    rom[0x147] = 0x01; // MBC1
+    rom[0x148] = 0x01; // 4 banks
+    rom[0x149] = 0x00; // No RAM
+    return rom;
+}
+
+@interface TestROMImage : XCTestCase
+
+@end
+
+@implementation TestROMImage
+
+- (void)testHeaderAndContentHash {
+    const vector<uint8_t> rom = _MBC1ROM();
+    ROMImage::Ptr image = ROMImage::CreateByCopying(rom.data(), rom.size());
+    XCTAssertEqual(image->size(), rom.size());
+    XCTAssertTrue(image->header().getType() == CartridgeType::MBC1);
+    XCTAssertTrue(image->header().getROMSize() == CartridgeROMSize::BANKS_4);
+    
+    // Same contents hash the same regardless of storage
+    ROMImage::Ptr unowned = ROMImage::CreateWithUnownedData(rom.data(), rom.size());
+    XCTAssertEqual(image->contentHash(), unowned->contentHash());
+    
+    vector<uint8_t> modified = rom;
+    modified[0x7FFF] = 1;
+    ROMImage::Ptr modifiedImage = ROMImage::CreateByCopying(modified.data(), modified.size());
+    XCTAssertNotEqual(image->contentHash(), modifiedImage->contentHash());
+}
+
+- (void)testSharedBetweenControllers {
+    const vector<uint8_t> rom = _MBC1ROM();
+    ROMImage::Ptr image = ROMImage::CreateByCopying(rom.data(), rom.size());
+    
+    MemoryController::Ptr first = make_shared<MemoryController>();
+    MemoryController::Ptr second = make_shared<MemoryController>();
+    XCTAssertTrue(first->configureWithROMImage(image));
+    XCTAssertTrue(second->configureWithROMImage(image));
+    
+    // Bank registers are per controller
+    first->setByte(0x2000, 0x02);
+    second->setByte(0x2000, 0x03);
+    XCTAssertEqual(first->readByte(0x4000), 2);
+    XCTAssertEqual(second->readByte(0x4000), 3);
+    
+    // Controllers keep the image alive
+    const weak_ptr<const ROMImage> weakImage = image;
+    image.reset();
+    XCTAssertFalse(weakImage.expired());
+    first.reset();
+    second.reset();
+    XCTAssertTrue(weakImage.expired());
+}
+
+@end
@@ -667,15 +667,18 @@ static void _AddInstruction(const MikoGB::DisassembledInstruction &instruction,
 
 // Expected on emulation queue
 - (void)_handleScanline:(const MikoGB::PixelBuffer &)scanline line:(size_t)line {
-    size_t bufferOffset = GBBytesPerLine * line;
-    uint8_t *buffer = _imageBuffer;
-    for (size_t pIdx = 0, bIdx = bufferOffset; pIdx < 160; ++pIdx, bIdx += 4) {
-        const MikoGB::Pixel &px = scanline.pixels[pIdx];
-        // RGBA format
-        buffer[bIdx] = px.red;
-        buffer[bIdx + 1] = px.green;
-        buffer[bIdx + 2] = px.blue;
-        buffer[bIdx + 3] = 0xFF;
+    // Unchanged lines are still in the image buffer from the previous frame
+    if (!_core->isScanlineUnchanged()) {
+        size_t bufferOffset = GBBytesPerLine * line;
+        uint8_t *buffer = _imageBuffer;
+        for (size_t pIdx = 0, bIdx = bufferOffset; pIdx < 160; ++pIdx, bIdx += 4) {
+            const MikoGB::Pixel &px = scanline.pixels[pIdx];
+            // RGBA format
+            buffer[bIdx] = px.red;
+            buffer[bIdx + 1] = px.green;
+            buffer[bIdx + 2] = px.blue;
+            buffer[bIdx + 3] = 0xFF;
+        }
     }
     
     if (line >= 143) {